@@ -0,0 +1,139 @@
+// 多会话扩展性基准：在本机回环上建立多对 Session，每条消息在处理时做一次固定的
+// SHA-256 计算模拟校验负载，统计不同 io 线程数下单位时间内完成的往返次数。
+//
+// 用法：bench_session_scaling [会话对数=32] [每轮秒数=3] [最大 io 线程数=硬件线程数]
+//                             [shared|sharded]
+#include "core/executor.h"
+#include "core/net/io/session.h"
+#include "transfer.pb.h"
+#include "util/hash.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+// 每条消息处理时额外哈希的字节数，模拟分块校验的 CPU 开销
+constexpr std::size_t kWorkBytes = 64 * 1024;
+
+void simulate_work() {
+    static const std::vector<std::byte> payload(kWorkBytes, std::byte{0x5a});
+    auto digest = util::hash::sha256(ConstDataBlock(payload.data(), payload.size()));
+    (void) digest;
+}
+
+class EchoServer : public core::net::io::Session {
+  public:
+    EchoServer(core::Executor& executor, std::uint16_t port)
+        : core::net::io::Session(executor, port) {}
+
+  private:
+    asio::awaitable<void> handle_message(const MessageWrapper& message) override {
+        transfer::FileChunkResponse request;
+        if (!request.ParseFromString(message.payload())) {
+            co_return;
+        }
+        simulate_work();
+        co_await send(request);
+    }
+};
+
+class PingClient : public core::net::io::Session {
+  public:
+    PingClient(core::Executor& executor, std::uint16_t port, std::atomic<std::uint64_t>& counter)
+        : core::net::io::Session(executor, "127.0.0.1", port)
+        , counter_(counter) {}
+
+    asio::awaitable<void> ping() {
+        transfer::FileChunkResponse request;
+        request.set_chunk_index(sequence_++);
+        co_await send(request);
+    }
+
+  private:
+    asio::awaitable<void> handle_message(const MessageWrapper& message) override {
+        (void) message;
+        counter_.fetch_add(1, std::memory_order_relaxed);
+        simulate_work();
+        if (is_running()) {
+            co_await ping();
+        }
+    }
+
+    std::atomic<std::uint64_t>& counter_;
+    std::uint64_t sequence_ = 0;
+};
+
+double run_round(core::IoMode mode,
+                 std::size_t io_threads,
+                 std::size_t pairs,
+                 int seconds,
+                 std::uint16_t base_port) {
+    core::Executor executor(1, io_threads, mode);
+    std::atomic<std::uint64_t> round_trips{0};
+    std::vector<std::unique_ptr<EchoServer>> servers;
+    std::vector<std::unique_ptr<PingClient>> clients;
+
+    for (std::size_t i = 0; i < pairs; ++i) {
+        servers.push_back(
+            std::make_unique<EchoServer>(executor, static_cast<std::uint16_t>(base_port + i)));
+    }
+    for (std::size_t i = 0; i < pairs; ++i) {
+        clients.push_back(std::make_unique<PingClient>(executor,
+                                                       static_cast<std::uint16_t>(base_port + i),
+                                                       round_trips));
+        clients.back()->spawn(clients.back()->ping());
+    }
+
+    std::thread runner([&executor]() { executor.start(); });
+
+    // 预热一秒，等待所有连接建立
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    const auto begin_count = round_trips.load();
+    const auto begin = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    const auto end_count = round_trips.load();
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin);
+
+    executor.stop();
+    runner.join();
+    clients.clear();
+    servers.clear();
+
+    return static_cast<double>(end_count - begin_count) / elapsed.count();
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t pairs = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32;
+    const int seconds = argc > 2 ? std::atoi(argv[2]) : 3;
+    const std::size_t max_threads = argc > 3 ? std::strtoul(argv[3], nullptr, 10)
+                                             : std::max(1U, std::thread::hardware_concurrency());
+    const auto mode = argc > 4 && std::string_view(argv[4]) == "sharded" ? core::IoMode::Sharded
+                                                                         : core::IoMode::Shared;
+
+    std::printf("sessions=%zu, work=%zu bytes sha256 per message, %d s per round, %s\n",
+                pairs * 2,
+                kWorkBytes,
+                seconds,
+                mode == core::IoMode::Sharded ? "sharded" : "shared");
+    std::printf("%10s %16s %10s\n", "io_threads", "round_trips/s", "speedup");
+
+    double baseline = 0;
+    std::uint16_t base_port = 47000;
+    for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+        const double rate = run_round(mode, threads, pairs, seconds, base_port);
+        base_port = static_cast<std::uint16_t>(base_port + pairs);
+        if (baseline == 0) {
+            baseline = rate;
+        }
+        std::printf("%10zu %16.0f %9.2fx\n", threads, rate, baseline > 0 ? rate / baseline : 0.0);
+    }
+    return 0;
+}
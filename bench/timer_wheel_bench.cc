@@ -0,0 +1,117 @@
+// 定时器基准：比较 asio::steady_timer 与 core::timer::WheelTimer 在大量同时存在的超时下的开销。
+// cancel 场景模拟分块重传超时：设置后绝大多数在到期前被取消；
+// fire 场景中所有定时器都到期，统计回调相对设定时间的延迟。
+//
+// 用法：bench_timer_wheel [定时器数量=100000]
+#include "core/timer/timer_wheel.h"
+#include <algorithm>
+#include <asio/io_context.hpp>
+#include <asio/steady_timer.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double ms_since(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+template<typename Timer>
+void run_cancel(const char* name, std::size_t count) {
+    asio::io_context io_context(1);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> timeout_ms(1000, 5000);
+    std::vector<std::unique_ptr<Timer>> timers;
+    timers.reserve(count);
+    std::size_t aborted = 0;
+
+    const auto arm_start = Clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        timers.push_back(std::make_unique<Timer>(io_context.get_executor()));
+        timers.back()->expires_after(std::chrono::milliseconds(timeout_ms(rng)));
+        timers.back()->async_wait([&aborted](const asio::error_code& ec) {
+            aborted += ec == asio::error::operation_aborted ? 1 : 0;
+        });
+    }
+    const auto arm_ms = ms_since(arm_start);
+
+    // 按随机顺序取消，接近重传超时被应答取消的情形
+    std::vector<std::size_t> order(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+    const auto cancel_start = Clock::now();
+    for (auto index : order) {
+        timers[index]->cancel();
+    }
+    const auto cancel_ms = ms_since(cancel_start);
+
+    const auto drain_start = Clock::now();
+    io_context.run();
+    const auto drain_ms = ms_since(drain_start);
+
+    std::printf("%-12s cancel  arm %8.1f ms (%6.0f ns/op)  cancel %8.1f ms (%6.0f ns/op)  "
+                "handlers %8.1f ms  aborted=%zu\n",
+                name,
+                arm_ms,
+                arm_ms * 1e6 / static_cast<double>(count),
+                cancel_ms,
+                cancel_ms * 1e6 / static_cast<double>(count),
+                drain_ms,
+                aborted);
+}
+
+template<typename Timer>
+void run_fire(const char* name, std::size_t count) {
+    asio::io_context io_context(1);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> timeout_ms(50, 250);
+    std::vector<std::unique_ptr<Timer>> timers;
+    timers.reserve(count);
+    double total_late_ms = 0;
+    double max_late_ms = 0;
+    std::size_t fired = 0;
+
+    const auto arm_start = Clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        timers.push_back(std::make_unique<Timer>(io_context.get_executor()));
+        auto& timer = *timers.back();
+        timer.expires_after(std::chrono::milliseconds(timeout_ms(rng)));
+        timer.async_wait([&, expiry = timer.expiry()](const asio::error_code& ec) {
+            if (ec) {
+                return;
+            }
+            const auto late = std::chrono::duration<double, std::milli>(Clock::now() - expiry);
+            total_late_ms += late.count();
+            max_late_ms = std::max(max_late_ms, late.count());
+            ++fired;
+        });
+    }
+    const auto arm_ms = ms_since(arm_start);
+    io_context.run();
+
+    std::printf("%-12s fire    arm %8.1f ms  fired=%zu  late avg %6.2f ms  max %6.2f ms\n",
+                name,
+                arm_ms,
+                fired,
+                fired > 0 ? total_late_ms / static_cast<double>(fired) : 0.0,
+                max_late_ms);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    std::printf("outstanding timers=%zu\n", count);
+
+    run_cancel<asio::steady_timer>("steady_timer", count);
+    run_cancel<core::timer::WheelTimer>("WheelTimer", count);
+    run_fire<asio::steady_timer>("steady_timer", count);
+    run_fire<core::timer::WheelTimer>("WheelTimer", count);
+    return 0;
+}
@@ -1,10 +1,14 @@
 #include "cli/online_list_display.h"
 #include "core/executor.h"
+#include "core/numa.h"
 #include "discovery/discovery_handler.h"
+#include "util/file_hash_cache.h"
 #include "util/settings.h"
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
 #include <csignal>
+#include <filesystem>
 #include <mutex>
 #include <spdlog/spdlog.h>
 #include <thread>
@@ -15,6 +19,37 @@ static std::atomic<bool> g_running{true};
 static std::mutex g_mutex;
 static std::condition_variable g_cv;
 
+// 绑核与 NUMA 放置：
+//   numa_node     节点号，或 "auto" 表示使用 nic_interface 所在的节点，缺省不指定
+//   nic_interface 网卡名，缺省为默认路由所在的网卡
+//   io_cpus / pool_cpus  cpulist 格式（如 "0-7,16-23"），缺省为所选节点上的全部 cpu
+static core::AffinityOptions load_affinity(const json& settings) {
+    core::AffinityOptions options;
+    const auto node_setting = settings.value("numa_node", json());
+    if (node_setting.is_number_integer()) {
+        options.numa_node = node_setting.get<int>();
+    } else if (node_setting.is_string() && node_setting.get<std::string>() == "auto") {
+        auto interface = settings.value("nic_interface", core::numa::default_route_interface());
+        if (const auto node = core::numa::interface_node(interface)) {
+            options.numa_node = *node;
+            spdlog::info("NIC {} is on NUMA node {}", interface, *node);
+        } else {
+            spdlog::info("NUMA node of NIC '{}' unknown, threads are not pinned", interface);
+        }
+    }
+
+    const auto node_cpus = core::numa::node_cpus(options.numa_node);
+    auto cpus_of = [&](const char* key) {
+        if (const auto list = settings.value(key, std::string()); !list.empty()) {
+            return core::numa::parse_cpu_list(list);
+        }
+        return node_cpus;
+    };
+    options.io_cpus = cpus_of("io_cpus");
+    options.pool_cpus = cpus_of("pool_cpus");
+    return options;
+}
+
 void signal_handler(int signal) {
     if (signal == SIGINT) {
         spdlog::info("\nReceived interrupt signal, shutting down...");
@@ -38,8 +73,26 @@ int main(int argc, char** argv) {
     auto& settings = util::Settings::instance();
     spdlog::info("Username: {}", settings.get()["username"].get<std::string>());
 
-    core::Executor executor;
+    const auto hash_cache_path = std::filesystem::path(argv[0]).parent_path() / "hash_cache.bin";
+    util::FileHashCache::instance().open(
+        hash_cache_path,
+        settings.get().value("hash_cache_max_entries", util::FileHashCache::kDefaultMaxEntries));
+
+    // io_context 默认单线程运行，可通过 io_threads 配置为多线程；
+    // io_sharding 为 true 时每个 io 线程独占一个绑核的 io_context
+    const size_t hardware_threads = std::max(1U, std::thread::hardware_concurrency());
+    const size_t io_threads = settings.get().value("io_threads", std::size_t{1});
+    const auto io_mode = settings.get().value("io_sharding", false) ? core::IoMode::Sharded
+                                                                    : core::IoMode::Shared;
+    core::Executor executor(hardware_threads, io_threads, io_mode);
     g_executor = &executor;
+    executor.set_affinity(load_affinity(settings.get()));
+
+    // 定期输出事件循环延迟、处理函数速率等运行指标，metrics_log_interval 为 0 时关闭
+    core::MetricsOptions metrics_options;
+    metrics_options.log_interval =
+        std::chrono::seconds(settings.get().value("metrics_log_interval", 60));
+    executor.set_metrics_options(metrics_options);
 
     spdlog::info("Creating discovery handler...");
     discovery::DiscoveryHandler discovery_handler(executor);
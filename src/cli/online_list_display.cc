@@ -1,5 +1,4 @@
 #include "online_list_display.h"
-#include "core/timer/spawn_after_delay.h"
 #include <chrono>
 #include <fmt/format.h>
 #include <iomanip>
@@ -14,22 +13,22 @@ void OnlineListDisplay::start() {
     }
     running_ = true;
     spdlog::info("OnlineListDisplay starting...");
-    executor_.spawn(display_loop());
+    executor_.spawn_on(strand_, display_loop());
 }
 
 void OnlineListDisplay::stop() {
     running_ = false;
+    ticker_.cancel();
 }
 
 asio::awaitable<void> OnlineListDisplay::display_loop() {
-    while (running_) {
-        std::cout << "\033[2J\033[H" << std::flush;
-        std::cout << "Users Online:\n";
-        print_online_list();
-
-        co_await core::timer::spawn_after_delay([]() -> asio::awaitable<void> { co_return; },
-                                                kRefreshIntervalMs);
-    }
+    co_await ticker_.run(
+        [this]() {
+            std::cout << "\033[2J\033[H" << std::flush;
+            std::cout << "Users Online:\n";
+            print_online_list();
+        },
+        true);
 }
 
 void OnlineListDisplay::print_online_list() {
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "core/executor.h"
+#include "core/timer/periodic.h"
 #include "discovery/online_list_inspector.h"
 #include <asio/awaitable.hpp>
+#include <atomic>
+#include <chrono>
 
 namespace cli {
 
@@ -10,6 +13,8 @@ class OnlineListDisplay {
   public:
     explicit OnlineListDisplay(core::Executor& executor, discovery::OnlineListInspector& inspector)
         : executor_(executor)
+        , strand_(executor.make_strand())
+        , ticker_(strand_, std::chrono::milliseconds(kRefreshIntervalMs))
         , inspector_(inspector)
         , running_(false) {}
 
@@ -24,8 +29,10 @@ class OnlineListDisplay {
     std::string format_timestamp(int64_t timestamp_ms);
 
     core::Executor& executor_;
+    core::IoStrand strand_;
+    core::timer::Periodic<> ticker_;
     discovery::OnlineListInspector& inspector_;
-    bool running_;
+    std::atomic<bool> running_;
     static constexpr int kRefreshIntervalMs = 1000;
 };
 
@@ -0,0 +1,47 @@
+#include "buffer_pool.h"
+#include "core/numa.h"
+
+namespace core {
+
+BufferPool::BufferPool(std::size_t buffer_size, std::size_t max_cached, int node)
+    : buffer_size_(buffer_size)
+    , max_cached_(max_cached)
+    , node_(node) {
+    free_.reserve(max_cached_);
+}
+
+BufferPool::~BufferPool() {
+    for (auto* data : free_) {
+        numa::deallocate(data, buffer_size_);
+    }
+}
+
+BufferPool::Buffer BufferPool::acquire() {
+    {
+        std::lock_guard lock(mutex_);
+        if (!free_.empty()) {
+            auto* data = free_.back();
+            free_.pop_back();
+            return Buffer(this, data);
+        }
+    }
+    auto* data = static_cast<std::byte*>(numa::allocate(buffer_size_, node_));
+    return data != nullptr ? Buffer(this, data) : Buffer();
+}
+
+std::size_t BufferPool::cached() const {
+    std::lock_guard lock(mutex_);
+    return free_.size();
+}
+
+void BufferPool::release(std::byte* data) {
+    {
+        std::lock_guard lock(mutex_);
+        if (free_.size() < max_cached_) {
+            free_.push_back(data);
+            return;
+        }
+    }
+    numa::deallocate(data, buffer_size_);
+}
+} // namespace core
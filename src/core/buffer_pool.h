@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace core {
+
+// 固定大小缓冲区的池，用于分块读写等大块临时缓冲。
+// 缓冲区通过 numa::allocate 分配在指定节点上（node < 0 时不指定），
+// 归还后留在池中复用，最多缓存 max_cached 个，避免每个分块都 mmap 一次。
+// 线程安全；池必须比借出的缓冲区活得更久
+class BufferPool {
+  public:
+    // 借出的缓冲区，析构时自动归还
+    class Buffer {
+      public:
+        Buffer() = default;
+        Buffer(Buffer&& other) noexcept
+            : pool_(std::exchange(other.pool_, nullptr))
+            , data_(std::exchange(other.data_, nullptr)) {}
+        Buffer& operator=(Buffer&& other) noexcept {
+            if (this != &other) {
+                reset();
+                pool_ = std::exchange(other.pool_, nullptr);
+                data_ = std::exchange(other.data_, nullptr);
+            }
+            return *this;
+        }
+        ~Buffer() { reset(); }
+
+        std::byte* data() const { return data_; }
+        std::size_t size() const { return pool_ != nullptr ? pool_->buffer_size() : 0; }
+        explicit operator bool() const { return data_ != nullptr; }
+
+        void reset() {
+            if (pool_ != nullptr && data_ != nullptr) {
+                pool_->release(data_);
+            }
+            pool_ = nullptr;
+            data_ = nullptr;
+        }
+
+      private:
+        friend class BufferPool;
+        Buffer(BufferPool* pool, std::byte* data)
+            : pool_(pool)
+            , data_(data) {}
+
+        BufferPool* pool_ = nullptr;
+        std::byte* data_ = nullptr;
+    };
+
+    BufferPool(std::size_t buffer_size, std::size_t max_cached, int node = -1);
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // 分配失败时返回空的 Buffer
+    Buffer acquire();
+
+    std::size_t buffer_size() const { return buffer_size_; }
+    int node() const { return node_; }
+    // 池中空闲的缓冲区数
+    std::size_t cached() const;
+
+  private:
+    void release(std::byte* data);
+
+    const std::size_t buffer_size_;
+    const std::size_t max_cached_;
+    const int node_;
+    mutable std::mutex mutex_;
+    std::vector<std::byte*> free_;
+};
+} // namespace core
@@ -0,0 +1,328 @@
+#pragma once
+
+#include <algorithm>
+#include <asio/associated_executor.hpp>
+#include <asio/async_result.hpp>
+#include <asio/awaitable.hpp>
+#include <asio/executor_work_guard.hpp>
+#include <asio/post.hpp>
+#include <asio/use_awaitable.hpp>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace core {
+
+// 通道的非模板部分，供 Pipeline 等统一查看占用与关闭
+class ChannelBase {
+  public:
+    virtual ~ChannelBase() = default;
+
+    // 缓冲区中的元素数，并发修改时为近似值
+    virtual std::size_t size() const = 0;
+    virtual std::size_t capacity() const = 0;
+    virtual void close() = 0;
+    virtual bool is_closed() const = 0;
+};
+
+// 有界多生产者多消费者异步通道，可在任意线程上的协程中使用。
+// 缓冲区是无锁环形队列（Vyukov MPMC），未满/非空时 push 与 pop 不加锁也不分配；
+// 满或空时才加锁登记等待者并挂起，由对端取出或放入后唤醒。
+// 唤醒只投递到等待者协程原来的执行器上，不会在对端的调用中直接恢复协程。
+// close() 之后 push 返回 false，缓冲区中剩余的元素仍可取出，取空后 pop 返回 nullopt
+template<typename T>
+class Channel final : public ChannelBase {
+  public:
+    // 容量向上取整为 2 的幂
+    explicit Channel(std::size_t capacity)
+        : mask_(std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity) - 1)
+        , cells_(std::make_unique<Cell[]>(mask_ + 1)) {
+        for (std::size_t i = 0; i <= mask_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~Channel() override {
+        while (try_pop()) {
+        }
+        senders_.drop();
+        receivers_.drop();
+    }
+
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+
+    std::size_t size() const override {
+        const auto tail = enqueue_pos_.load(std::memory_order_relaxed);
+        const auto head = dequeue_pos_.load(std::memory_order_relaxed);
+        return tail > head ? std::min(tail - head, capacity()) : 0;
+    }
+    std::size_t capacity() const override { return mask_ + 1; }
+    bool is_closed() const override { return closed_.load(std::memory_order_acquire); }
+
+    void close() override {
+        closed_.store(true, std::memory_order_release);
+        senders_.wake_all();
+        receivers_.wake_all();
+    }
+
+    // 不挂起的版本。成功时移走 value，失败（已满或已关闭）时 value 不变
+    bool try_push(T&& value) {
+        if (is_closed() || !enqueue(value)) {
+            return false;
+        }
+        receivers_.wake_one();
+        return true;
+    }
+    std::optional<T> try_pop() {
+        auto value = dequeue();
+        if (value) {
+            senders_.wake_one();
+        }
+        return value;
+    }
+
+    // 已满时挂起直到有空位；通道关闭时返回 false
+    asio::awaitable<bool> push(T value) {
+        while (!try_push(std::move(value))) {
+            if (is_closed()) {
+                co_return false;
+            }
+            co_await wait(senders_, [this] { return has_space() || is_closed(); });
+        }
+        co_return true;
+    }
+
+    // 为空时挂起直到有元素；通道关闭且取空后返回 nullopt
+    asio::awaitable<std::optional<T>> pop() {
+        while (true) {
+            if (auto value = try_pop()) {
+                co_return value;
+            }
+            if (is_closed() && !has_item()) {
+                co_return std::nullopt;
+            }
+            co_await wait(receivers_, [this] { return has_item() || is_closed(); });
+        }
+    }
+
+    // 依次放入全部元素，返回放入的数量，中途关闭时少于 values.size()
+    asio::awaitable<std::size_t> push_batch(std::vector<T> values) {
+        std::size_t pushed = 0;
+        for (auto& value : values) {
+            while (is_closed() || !enqueue(value)) {
+                // 挂起前先唤醒接收方取走本批已放入的元素
+                receivers_.wake_all();
+                if (is_closed()) {
+                    co_return pushed;
+                }
+                co_await wait(senders_, [this] { return has_space() || is_closed(); });
+            }
+            ++pushed;
+        }
+        // 放入一批后一次唤醒所有接收方，而不是每个元素唤醒一次
+        receivers_.wake_all();
+        co_return pushed;
+    }
+
+    // 至少取出一个、至多 max_count 个元素；通道关闭且取空后返回空数组
+    asio::awaitable<std::vector<T>> pop_batch(std::size_t max_count) {
+        std::vector<T> values;
+        while (values.empty()) {
+            while (values.size() < max_count) {
+                auto value = dequeue();
+                if (!value) {
+                    break;
+                }
+                values.push_back(std::move(*value));
+            }
+            if (!values.empty()) {
+                senders_.wake_all();
+                break;
+            }
+            if (is_closed() && !has_item()) {
+                break;
+            }
+            co_await wait(receivers_, [this] { return has_item() || is_closed(); });
+        }
+        co_return values;
+    }
+
+  private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        alignas(T) std::byte storage[sizeof(T)];
+    };
+
+    struct Waiter {
+        virtual ~Waiter() = default;
+        // 投递处理函数并销毁自己
+        virtual void wake() = 0;
+        Waiter* next = nullptr;
+    };
+
+    template<typename Handler>
+    struct HandlerWaiter final : Waiter {
+        explicit HandlerWaiter(Handler&& handler)
+            : handler_(std::move(handler))
+            , guard_(asio::make_work_guard(asio::get_associated_executor(handler_))) {}
+
+        void wake() override {
+            auto executor = guard_.get_executor();
+            asio::post(executor, std::move(handler_));
+            delete this;
+        }
+
+        Handler handler_;
+        // 挂起期间保持等待者所在的 io_context 不因无事可做而返回
+        asio::executor_work_guard<asio::associated_executor_t<Handler>> guard_;
+    };
+
+    // 一侧（发送方或接收方）的等待者队列。count 在锁外读取，没有等待者时唤醒不加锁
+    struct WaitQueue {
+        std::mutex mutex;
+        Waiter* head = nullptr;
+        Waiter* tail = nullptr;
+        std::atomic<std::size_t> count{0};
+
+        void wake_one() { wake(1); }
+        void wake_all() { wake(SIZE_MAX); }
+
+        void wake(std::size_t limit) {
+            // 与 wait() 中的栅栏配对：要么这里看到等待者，要么等待者在登记后看到状态变化
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (count.load(std::memory_order_relaxed) == 0) {
+                return;
+            }
+            Waiter* woken = nullptr;
+            {
+                std::lock_guard lock(mutex);
+                for (std::size_t i = 0; i < limit && head != nullptr; ++i) {
+                    auto* waiter = head;
+                    head = waiter->next;
+                    waiter->next = woken;
+                    woken = waiter;
+                    count.fetch_sub(1, std::memory_order_relaxed);
+                }
+                if (head == nullptr) {
+                    tail = nullptr;
+                }
+            }
+            while (auto* waiter = woken) {
+                woken = waiter->next;
+                waiter->wake();
+            }
+        }
+
+        // 通道销毁时丢弃未唤醒的等待者，与 io_context 关闭时的处理一致
+        void drop() {
+            while (auto* waiter = head) {
+                head = waiter->next;
+                delete waiter;
+            }
+            tail = nullptr;
+        }
+    };
+
+    // 挂起直到 ready() 成立。被唤醒只表示状态可能变化，调用方需要重新尝试
+    template<typename Ready>
+    asio::awaitable<void> wait(WaitQueue& queue, Ready ready) {
+        return asio::async_initiate<const asio::use_awaitable_t<>&, void()>(
+            [&queue, ready](auto handler) {
+                using Handler = decltype(handler);
+                std::unique_lock lock(queue.mutex);
+                queue.count.fetch_add(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (ready()) {
+                    queue.count.fetch_sub(1, std::memory_order_relaxed);
+                    lock.unlock();
+                    auto executor = asio::get_associated_executor(handler);
+                    asio::post(executor, std::move(handler));
+                    return;
+                }
+                auto* waiter = new HandlerWaiter<Handler>(std::move(handler));
+                if (queue.tail != nullptr) {
+                    queue.tail->next = waiter;
+                } else {
+                    queue.head = waiter;
+                }
+                queue.tail = waiter;
+            },
+            asio::use_awaitable);
+    }
+
+    bool has_space() const {
+        const auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+        const auto sequence = cells_[pos & mask_].sequence.load(std::memory_order_acquire);
+        return static_cast<std::intptr_t>(sequence - pos) >= 0;
+    }
+    bool has_item() const {
+        const auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+        const auto sequence = cells_[pos & mask_].sequence.load(std::memory_order_acquire);
+        return static_cast<std::intptr_t>(sequence - (pos + 1)) >= 0;
+    }
+
+    bool enqueue(T& value) {
+        auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        while (true) {
+            cell = &cells_[pos & mask_];
+            const auto sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(sequence - pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        new (cell->storage) T(std::move(value));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::optional<T> dequeue() {
+        auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        while (true) {
+            cell = &cells_[pos & mask_];
+            const auto sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(sequence - (pos + 1));
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return std::nullopt;
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        auto* slot = std::launder(reinterpret_cast<T*>(cell->storage));
+        std::optional<T> value(std::move(*slot));
+        slot->~T();
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return value;
+    }
+
+    const std::size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    // 生产者与消费者的位置分开放在不同缓存行，避免互相争用
+    alignas(64) std::atomic<std::size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<std::size_t> dequeue_pos_{0};
+    std::atomic<bool> closed_{false};
+
+    WaitQueue senders_;
+    WaitQueue receivers_;
+};
+} // namespace core
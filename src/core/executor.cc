@@ -1,17 +1,213 @@
 #include "executor.h"
+#include "util/data_block.h"
+#include <algorithm>
+#include <asio/post.hpp>
+#include <fmt/format.h>
+#include <latch>
 #include <spdlog/spdlog.h>
 
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 namespace core {
+std::string ExecutorMetrics::to_string() const {
+    return fmt::format("loop_lag={} us, max_loop_lag={} us, handlers/s={:.0f}, "
+                       "longest_handler={} us at {}, coroutines={}, cpu_queue={}",
+                       loop_lag.count(),
+                       max_loop_lag.count(),
+                       handlers_per_second,
+                       longest_handler.count(),
+                       longest_handler_site.empty() ? "-" : longest_handler_site,
+                       active_coroutines,
+                       cpu_queue_depth);
+}
+
+ExecutorMetrics Executor::metrics() const {
+    ExecutorMetrics result;
+    {
+        std::lock_guard lock(metrics_mutex_);
+        result = window_;
+    }
+    std::int64_t lag = 0;
+    for (const auto& shard_lag : shard_lag_us_) {
+        lag = std::max(lag, shard_lag.load(std::memory_order_relaxed));
+    }
+    result.loop_lag = std::chrono::microseconds(lag);
+    result.active_coroutines = active_coroutines_.load(std::memory_order_relaxed);
+    result.cpu_queue_depth = cpu_pool_->get_pending();
+    return result;
+}
+
+void Executor::start_probes() {
+    probes_.clear();
+    window_start_ = last_log_ = std::chrono::steady_clock::now();
+    window_invocations_ = handler_tracking::invocation_count();
+    handler_tracking::take_longest();
+    for (auto& io_context : io_contexts_) {
+        probes_.push_back(std::make_unique<asio::steady_timer>(*io_context));
+    }
+    for (size_t shard = 0; shard < probes_.size(); ++shard) {
+        arm_probe(shard);
+    }
+}
+
+void Executor::arm_probe(size_t shard) {
+    auto& probe = *probes_[shard];
+    probe.expires_after(metrics_options_.probe_interval);
+    probe.async_wait([this, shard](const asio::error_code& ec) {
+        if (!ec) {
+            on_probe(shard);
+        }
+    });
+}
+
+void Executor::on_probe(size_t shard) {
+    // 定时器到期后排在前面的处理函数越多、越慢，回调被执行得越晚
+    const auto now = std::chrono::steady_clock::now();
+    const auto lag = std::max(std::chrono::duration_cast<std::chrono::microseconds>(
+                                  now - probes_[shard]->expiry()),
+                              std::chrono::microseconds{0});
+    shard_lag_us_[shard].store(lag.count(), std::memory_order_relaxed);
+    auto max_lag = window_max_lag_us_.load(std::memory_order_relaxed);
+    while (lag.count() > max_lag
+           && !window_max_lag_us_.compare_exchange_weak(max_lag, lag.count())) {
+    }
+
+    if (shard == 0 && now - window_start_ >= metrics_options_.window) {
+        roll_window(now);
+    }
+    arm_probe(shard);
+}
+
+void Executor::roll_window(std::chrono::steady_clock::time_point now) {
+    const auto invocations = handler_tracking::invocation_count();
+    const auto [longest, site] = handler_tracking::take_longest();
+    const std::chrono::duration<double> elapsed = now - window_start_;
+    {
+        std::lock_guard lock(metrics_mutex_);
+        window_.max_loop_lag = std::chrono::microseconds(window_max_lag_us_.exchange(0));
+        window_.handlers_per_second =
+            static_cast<double>(invocations - window_invocations_) / elapsed.count();
+        window_.longest_handler = std::chrono::duration_cast<std::chrono::microseconds>(longest);
+        window_.longest_handler_site = site.to_string();
+    }
+    window_start_ = now;
+    window_invocations_ = invocations;
+
+    const auto snapshot = metrics();
+    if (metrics_options_.lag_warning.count() > 0
+        && snapshot.max_loop_lag >= metrics_options_.lag_warning) {
+        spdlog::warn("[Executor::roll_window] Event loop lag {} us, longest handler {} us at {}",
+                     snapshot.max_loop_lag.count(),
+                     snapshot.longest_handler.count(),
+                     snapshot.longest_handler_site);
+    }
+    if (metrics_options_.log_interval.count() > 0
+        && now - last_log_ >= metrics_options_.log_interval) {
+        last_log_ = now;
+        spdlog::info("[Executor::roll_window] {}", snapshot.to_string());
+    }
+}
+
+void Executor::pin_current_thread(const std::vector<size_t>& cpus) {
+    if (cpus.empty()) {
+        return;
+    }
+#if defined(__linux__)
+    const auto cpu_count = std::max(1U, std::thread::hardware_concurrency());
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const auto cpu : cpus) {
+        CPU_SET(static_cast<int>(cpu % cpu_count), &set);
+    }
+    if (const int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); err != 0) {
+        spdlog::warn("[Executor::pin_current_thread] Failed to pin thread to {} cpus: {}",
+                     cpus.size(),
+                     err);
+    }
+#endif
+}
+
+void Executor::set_affinity(const AffinityOptions& options) {
+    affinity_ = options;
+    chunk_buffers_ = make_chunk_buffers(options.numa_node);
+}
+
+std::unique_ptr<BufferPool> Executor::make_chunk_buffers(int node) const {
+    // 每个计算线程同时最多处理一两个分块，缓存更多只会占住内存
+    return std::make_unique<BufferPool>(kDefaultChunkSize, concurrency_ * 2, node);
+}
+
+void Executor::pin_pool_threads() {
+    if (affinity_.pool_cpus.empty()) {
+        return;
+    }
+    // 每个线程取到一个绑核任务后在 latch 上等待其他线程，保证每个线程恰好执行一次。
+    // 工作线程被唤醒后可能晚于本函数返回才离开 latch，因此由任务共同持有
+    auto pin_all = [this](size_t thread_count, auto&& submit) {
+        auto pinned = std::make_shared<std::latch>(static_cast<std::ptrdiff_t>(thread_count) + 1);
+        for (size_t i = 0; i < thread_count; ++i) {
+            submit([this, pinned]() {
+                pin_current_thread(affinity_.pool_cpus);
+                pinned->arrive_and_wait();
+            });
+        }
+        pinned->arrive_and_wait();
+    };
+    pin_all(concurrency_, [this](auto task) { asio::post(thread_pool_, std::move(task)); });
+    pin_all(cpu_pool_->get_thread_count(),
+            [this](auto task) { cpu_pool_->submit(std::move(task)); });
+}
+
 void Executor::start() {
     if (running_.exchange(true)) {
         spdlog::warn("Executor is already running");
         return;
     }
-    if (!work_guard_) {
-        work_guard_.emplace(asio::make_work_guard(io_context_));
+    if (work_guards_.empty()) {
+        for (auto& io_context : io_contexts_) {
+            work_guards_.emplace_back(asio::make_work_guard(*io_context));
+        }
+    }
+    start_probes();
+    pin_pool_threads();
+
+    if (io_mode_ == IoMode::Sharded) {
+        spdlog::info("Executor started with {} io shards and {} worker threads",
+                     io_contexts_.size(),
+                     concurrency_);
+        // 每个分片一个绑核线程，调用线程只负责等待回收
+        for (size_t i = 0; i < io_contexts_.size(); ++i) {
+            io_threads_.emplace_back([this, i]() {
+                const auto& cpus = affinity_.io_cpus;
+                pin_current_thread({cpus.empty() ? i : cpus[i % cpus.size()]});
+                io_contexts_[i]->run();
+            });
+        }
+    } else {
+        spdlog::info("Executor started with {} io threads and {} worker threads",
+                     io_concurrency_,
+                     concurrency_);
+        // 调用线程本身也运行 io_context，其余 io_concurrency_ - 1 个线程在此创建
+        for (size_t i = 1; i < io_concurrency_; ++i) {
+            io_threads_.emplace_back([this]() {
+                pin_current_thread(affinity_.io_cpus);
+                get_io_context().run();
+            });
+        }
+        pin_current_thread(affinity_.io_cpus);
+        get_io_context().run();
     }
-    spdlog::info("Executor started with {} worker threads", concurrency_);
-    io_context_.run();
+
+    // run() 返回后由调用线程回收，stop() 可以在任意 io 线程内调用
+    for (auto& thread : io_threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    io_threads_.clear();
 }
 
 void Executor::stop() {
@@ -21,13 +217,14 @@ void Executor::stop() {
     }
 
     spdlog::info("Stopping Executor...");
-    if (work_guard_) {
-        work_guard_.reset();
-    }
+    work_guards_.clear();
 
-    io_context_.stop();
+    for (auto& io_context : io_contexts_) {
+        io_context->stop();
+    }
     thread_pool_.stop();
     thread_pool_.join();
+    cpu_pool_->stop();
     spdlog::info("Executor stopped");
 }
 
@@ -35,11 +232,14 @@ void Executor::restart() {
     spdlog::info("Restarting Executor...");
     stop();
 
-    io_context_.restart();
+    for (auto& io_context : io_contexts_) {
+        io_context->restart();
+    }
 
     spdlog::warn("Thread pool cannot be restarted, creating new instance");
     thread_pool_.~thread_pool();
     new (&thread_pool_) asio::thread_pool(concurrency_);
+    cpu_pool_ = std::make_unique<WorkStealingPool>(concurrency_);
 
     start();
 }
@@ -1,24 +1,110 @@
 #pragma once
 
+#include "core/buffer_pool.h"
+#include "core/handler_tracking.h"
+#include "core/work_stealing_pool.h"
+#include <asio/any_io_executor.hpp>
+#include <asio/associated_executor.hpp>
+#include <asio/async_result.hpp>
+#include <asio/awaitable.hpp>
 #include <asio/co_spawn.hpp>
 #include <asio/detached.hpp>
+#include <asio/dispatch.hpp>
 #include <asio/executor_work_guard.hpp>
 #include <asio/io_context.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/strand.hpp>
+#include <asio/system_error.hpp>
 #include <asio/thread_pool.hpp>
+#include <asio/use_awaitable.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <source_location>
+#include <string>
 #include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace core {
+// 多线程运行 io_context 时，有状态的组件（Session、TcpInteractor、发现模块等）
+// 各自持有一个 strand，其上的协程串行执行，组件内部状态无需额外加锁
+using IoStrand = asio::strand<asio::io_context::executor_type>;
+
+// Shared：所有 io 线程共同运行一个 io_context；
+// Sharded：每个 io 线程独占一个 io_context 并绑定到一个核心，会话整个生命周期都留在所属分片上，
+// 配合 SO_REUSEPORT 由内核把新连接分散到各分片的监听 socket
+enum class IoMode { Shared, Sharded };
+
+// Executor 的运行指标快照，通过 Executor::metrics() 读取
+struct ExecutorMetrics {
+    // 各 io_context 最近一次探测到的事件循环延迟中的最大值：定时器到期后实际被执行的滞后时间
+    std::chrono::microseconds loop_lag{0};
+    // 以下为上一个统计窗口内的数据
+    std::chrono::microseconds max_loop_lag{0};
+    double handlers_per_second = 0;
+    // 自身耗时最长的处理函数，位置为启动所在协程的调用处
+    std::chrono::microseconds longest_handler{0};
+    std::string longest_handler_site;
+    // 以下为读取时的实时数据
+    size_t active_coroutines = 0;
+    size_t cpu_queue_depth = 0;
+
+    std::string to_string() const;
+};
+
+struct MetricsOptions {
+    // 延迟探测定时器的间隔
+    std::chrono::milliseconds probe_interval{100};
+    // 统计窗口长度，处理函数速率与最大值按窗口计算
+    std::chrono::milliseconds window{1000};
+    // 定期输出指标的间隔，为 0 时不输出
+    std::chrono::milliseconds log_interval{0};
+    // 窗口内最大延迟超过该值时输出警告，为 0 时不警告
+    std::chrono::milliseconds lag_warning{100};
+};
+
+// 线程绑核与 NUMA 放置，需在 start() 之前设置
+struct AffinityOptions {
+    // io 线程可运行的 cpu。Sharded 模式下第 i 个分片绑定到 io_cpus[i % n]，
+    // Shared 模式下所有 io 线程（包括调用 start() 的线程）绑定到整个集合。
+    // 为空时 Sharded 模式按分片号绑核，Shared 模式不绑定
+    std::vector<size_t> io_cpus;
+    // 线程池与计算线程池的线程可运行的 cpu，为空时不绑定
+    std::vector<size_t> pool_cpus;
+    // 分块缓冲区所在的 NUMA 节点，通常与网卡所在节点相同；-1 表示不指定
+    int numa_node = -1;
+};
+
 class Executor {
   public:
     Executor()
         : Executor(std::thread::hardware_concurrency()) {}
 
-    explicit Executor(size_t thread_count)
+    // thread_count 为线程池线程数；
+    // io_thread_count 为运行 io_context 的线程数，Shared 模式下包含调用 start() 的线程，
+    // Sharded 模式下即为分片数
+    explicit Executor(size_t thread_count,
+                      size_t io_thread_count = 1,
+                      IoMode io_mode = IoMode::Shared)
         : concurrency_(thread_count > 0 ? thread_count : 1)
+        , io_concurrency_(io_thread_count > 0 ? io_thread_count : 1)
+        , io_mode_(io_mode)
         , thread_pool_(concurrency_)
-        , io_context_()
-        , work_guard_() {}
+        , cpu_pool_(std::make_unique<WorkStealingPool>(concurrency_))
+        , chunk_buffers_(make_chunk_buffers(-1)) {
+        const auto shard_count = io_mode_ == IoMode::Sharded ? io_concurrency_ : 1;
+        const auto hint = io_mode_ == IoMode::Sharded ? 1 : static_cast<int>(io_concurrency_);
+        for (size_t i = 0; i < shard_count; ++i) {
+            io_contexts_.push_back(std::make_unique<asio::io_context>(hint));
+        }
+        shard_lag_us_ = std::vector<std::atomic<std::int64_t>>(shard_count);
+    }
 
     ~Executor() {
         if (running_.load()) {
@@ -33,25 +119,105 @@ class Executor {
     void stop();
     void restart();
 
-    asio::io_context& get_io_context() { return io_context_; }
+    // 默认 io_context（分片 0），供发现模块等全局组件使用
+    asio::io_context& get_io_context() { return *io_contexts_.front(); }
+    asio::io_context& get_io_context(size_t shard) { return *io_contexts_[shard]; }
+    // 轮流返回各分片，新建会话时用于分配所在分片；Shared 模式下总是同一个 io_context
+    asio::io_context& next_io_context() {
+        const auto index = next_shard_.fetch_add(1, std::memory_order_relaxed);
+        return *io_contexts_[index % io_contexts_.size()];
+    }
+    size_t get_shard_count() const { return io_contexts_.size(); }
+    IoMode get_io_mode() const { return io_mode_; }
+
     asio::thread_pool& get_thread_pool() { return thread_pool_; }
+    WorkStealingPool& get_cpu_pool() { return *cpu_pool_; }
     size_t get_thread_count() const { return concurrency_; }
+    size_t get_io_thread_count() const { return io_concurrency_; }
+
+    // 需在 start() 之前设置
+    void set_metrics_options(const MetricsOptions& options) { metrics_options_ = options; }
+    // 需在 start() 之前、借出任何分块缓冲区之前设置
+    void set_affinity(const AffinityOptions& options);
+    const AffinityOptions& get_affinity() const { return affinity_; }
+
+    // 分块大小的缓冲区池，位于 AffinityOptions::numa_node 上，用于读取与发送分块
+    BufferPool& get_chunk_buffers() { return *chunk_buffers_; }
+    ExecutorMetrics metrics() const;
+
+    IoStrand make_strand() { return make_strand(get_io_context()); }
+    static IoStrand make_strand(asio::io_context& io_context) {
+        return asio::make_strand(io_context);
+    }
+
+    // 返回在 io_context 上串行执行协程的执行器，供会话等热路径组件使用。
+    // io_context 只由一个线程运行时（分片模式或只有一个 io 线程）本身就是隐式 strand，
+    // 直接返回其执行器，省去 strand 的排队开销以及 any_io_executor 包装 strand 时的堆分配
+    asio::any_io_executor make_serial_executor(asio::io_context& io_context) {
+        if (io_mode_ == IoMode::Sharded || io_concurrency_ == 1) {
+            return io_context.get_executor();
+        }
+        return make_strand(io_context);
+    }
+    // executor 通常来自某个 io_context，例如 socket.get_executor()；
+    // 其他执行器（如已经是 strand）无法判断是否单线程运行，一律包一层 strand
+    asio::any_io_executor make_serial_executor(const asio::any_io_executor& executor) {
+        if (const auto* io_executor = executor.target<asio::io_context::executor_type>()) {
+            return make_serial_executor(io_executor->context());
+        }
+        return asio::make_strand(executor);
+    }
 
     enum class Context { IO, ThreadPool };
 
+    // spawn 与 spawn_on 启动的协程计入 active_coroutines，协程内的处理函数归属于 site
     template<typename Awaitable>
-    auto spawn(Awaitable&& awaitable, Context ctx = Context::IO) {
+    void spawn(Awaitable&& awaitable,
+               Context ctx = Context::IO,
+               std::source_location site = std::source_location::current()) {
         if (ctx == Context::IO) {
-            return asio::co_spawn(io_context_, std::forward<Awaitable>(awaitable), asio::detached);
+            spawn_on(get_io_context().get_executor(), std::forward<Awaitable>(awaitable), site);
         } else {
-            return asio::co_spawn(thread_pool_, std::forward<Awaitable>(awaitable), asio::detached);
+            spawn_on(thread_pool_.get_executor(), std::forward<Awaitable>(awaitable), site);
         }
     }
 
+    // 在指定 strand（或 make_serial_executor 返回的执行器）上启动协程，
+    // 协程内的所有续体都在其上串行执行
+    template<typename SerialExecutor, typename Awaitable>
+    void spawn_on(const SerialExecutor& strand,
+                  Awaitable&& awaitable,
+                  std::source_location site = std::source_location::current()) {
+        handler_tracking::Location location(site);
+        active_coroutines_.fetch_add(1, std::memory_order_relaxed);
+        asio::co_spawn(strand,
+                       std::forward<Awaitable>(awaitable),
+                       [this](std::exception_ptr, auto&&...) {
+                           active_coroutines_.fetch_sub(1, std::memory_order_relaxed);
+                       });
+    }
+
+    // 同上，协程结束（正常返回或抛出异常）后在 strand 上调用 on_done()
+    template<typename SerialExecutor, typename Awaitable, typename OnDone>
+        requires std::invocable<OnDone&>
+    void spawn_on(const SerialExecutor& strand,
+                  Awaitable&& awaitable,
+                  OnDone on_done,
+                  std::source_location site = std::source_location::current()) {
+        handler_tracking::Location location(site);
+        active_coroutines_.fetch_add(1, std::memory_order_relaxed);
+        asio::co_spawn(strand,
+                       std::forward<Awaitable>(awaitable),
+                       [this, on_done = std::move(on_done)](std::exception_ptr, auto&&...) mutable {
+                           active_coroutines_.fetch_sub(1, std::memory_order_relaxed);
+                           on_done();
+                       });
+    }
+
     template<typename Awaitable, typename CompletionToken>
     auto spawn(Awaitable&& awaitable, CompletionToken&& token, Context ctx = Context::IO) {
         if (ctx == Context::IO) {
-            return asio::co_spawn(io_context_,
+            return asio::co_spawn(get_io_context(),
                                   std::forward<Awaitable>(awaitable),
                                   std::forward<CompletionToken>(token));
         } else {
@@ -61,11 +227,153 @@ class Executor {
         }
     }
 
+    // 在计算线程池上执行 fn，完成后回到调用协程原来的执行器（io_context 或 strand）继续，
+    // 返回 fn 的结果。用于哈希、压缩、阻塞文件操作等不应占用 io 线程的工作。
+    // fn 抛出的异常在调用方重新抛出；线程池停止而 fn 没有执行时抛出 operation_aborted。
+    // fn 在协程挂起期间执行，按引用捕获调用方的局部变量是安全的
+    template<typename Fn>
+        requires std::invocable<std::decay_t<Fn>&>
+    asio::awaitable<std::invoke_result_t<std::decay_t<Fn>&>> offload(Fn&& fn) {
+        using Work = std::decay_t<Fn>;
+        using Result = std::invoke_result_t<Work&>;
+        if constexpr (std::is_void_v<Result>) {
+            co_await asio::async_initiate<const asio::use_awaitable_t<>&,
+                                          void(std::exception_ptr)>(
+                OffloadInitiation{*cpu_pool_}, asio::use_awaitable, Work(std::forward<Fn>(fn)));
+        } else {
+            // 结果包在 optional 中传回，Result 不必可默认构造
+            auto result = co_await asio::async_initiate<const asio::use_awaitable_t<>&,
+                                                        void(std::exception_ptr,
+                                                             std::optional<Result>)>(
+                OffloadInitiation{*cpu_pool_}, asio::use_awaitable, Work(std::forward<Fn>(fn)));
+            co_return std::move(*result);
+        }
+    }
+
   private:
+    // offload 任务的完成端：把结果或异常投递回调用方的执行器。
+    // 持有调用方执行器的 work guard，结果投递回去之前 io_context 不会因无事可做而返回。
+    // 任务没有执行就被销毁（线程池已停止）时在析构中以 operation_aborted 恢复调用方
+    template<typename Handler, typename Result>
+    class OffloadCompletion {
+      public:
+        explicit OffloadCompletion(Handler handler)
+            : guard_(asio::make_work_guard(asio::get_associated_executor(handler)))
+            , handler_(std::move(handler)) {}
+
+        OffloadCompletion(OffloadCompletion&& other) noexcept
+            : guard_(std::move(other.guard_))
+            , handler_(std::move(other.handler_))
+            , pending_(std::exchange(other.pending_, false)) {}
+        OffloadCompletion& operator=(OffloadCompletion&&) = delete;
+
+        ~OffloadCompletion() {
+            if (!pending_) {
+                return;
+            }
+            const auto aborted =
+                std::make_exception_ptr(asio::system_error(asio::error::operation_aborted));
+            if constexpr (std::is_void_v<Result>) {
+                finish(aborted);
+            } else {
+                finish(aborted, std::optional<Result>());
+            }
+        }
+
+        template<typename Work>
+        void run(Work& work) {
+            std::exception_ptr error;
+            if constexpr (std::is_void_v<Result>) {
+                try {
+                    work();
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                finish(error);
+            } else {
+                std::optional<Result> result;
+                try {
+                    result.emplace(work());
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                finish(error, std::move(result));
+            }
+        }
+
+      private:
+        template<typename... Values>
+        void finish(std::exception_ptr error, Values&&... values) {
+            pending_ = false;
+            auto executor = guard_.get_executor();
+            asio::dispatch(executor,
+                           [handler = std::move(handler_),
+                            error = std::move(error),
+                            ... values = std::forward<Values>(values)]() mutable {
+                               std::move(handler)(std::move(error), std::move(values)...);
+                           });
+            guard_.reset();
+        }
+
+        asio::executor_work_guard<asio::associated_executor_t<Handler>> guard_;
+        Handler handler_;
+        bool pending_ = true;
+    };
+
+    struct OffloadInitiation {
+        WorkStealingPool& pool;
+
+        template<typename Handler, typename Work>
+        void operator()(Handler&& handler, Work&& work) const {
+            using Result = std::invoke_result_t<std::decay_t<Work>&>;
+            pool.submit([completion = OffloadCompletion<std::decay_t<Handler>, Result>(
+                             std::forward<Handler>(handler)),
+                         work = std::forward<Work>(work),
+                         site = handler_tracking::current_site()]() mutable {
+                // 投递回去的续体仍归属于调用协程的位置
+                handler_tracking::Location location(site);
+                completion.run(work);
+            });
+        }
+    };
+
+    // 将当前线程绑定到 cpus 中的核心，cpus 为空或平台不支持时忽略
+    static void pin_current_thread(const std::vector<size_t>& cpus);
+    // 按 affinity_.pool_cpus 绑定线程池与计算线程池的所有线程
+    void pin_pool_threads();
+    std::unique_ptr<BufferPool> make_chunk_buffers(int node) const;
+
+    void start_probes();
+    void arm_probe(size_t shard);
+    void on_probe(size_t shard);
+    void roll_window(std::chrono::steady_clock::time_point now);
+
+    using WorkGuard = asio::executor_work_guard<asio::io_context::executor_type>;
+
     size_t concurrency_;
+    size_t io_concurrency_;
+    IoMode io_mode_;
     asio::thread_pool thread_pool_;
-    asio::io_context io_context_;
-    std::optional<asio::executor_work_guard<asio::io_context::executor_type>> work_guard_{};
+    std::unique_ptr<WorkStealingPool> cpu_pool_;
+    AffinityOptions affinity_;
+    std::unique_ptr<BufferPool> chunk_buffers_;
+    std::vector<std::unique_ptr<asio::io_context>> io_contexts_;
+    std::vector<WorkGuard> work_guards_;
+
+    MetricsOptions metrics_options_;
+    std::atomic<size_t> active_coroutines_{0};
+    // 延迟探测定时器与各分片最近一次的延迟，定时器只在所属分片上访问
+    std::vector<std::unique_ptr<asio::steady_timer>> probes_;
+    std::vector<std::atomic<std::int64_t>> shard_lag_us_;
+    std::atomic<std::int64_t> window_max_lag_us_{0};
+    // 窗口状态只在分片 0 的探测回调中修改，window_ 另由 metrics() 读取
+    std::chrono::steady_clock::time_point window_start_;
+    std::chrono::steady_clock::time_point last_log_;
+    std::uint64_t window_invocations_ = 0;
+    mutable std::mutex metrics_mutex_;
+    ExecutorMetrics window_;
+    std::atomic<size_t> next_shard_{0};
     std::atomic<bool> running_{false};
+    std::vector<std::thread> io_threads_;
 };
 } // namespace core
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "handler_tracking.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace core::handler_tracking {
+namespace {
+// 每个线程单独计数，避免多个 io 线程在同一个原子变量上竞争；线程退出时计数并入 retired_count
+struct ThreadCounter;
+
+std::mutex registry_mutex;
+std::vector<ThreadCounter*> registry;
+std::uint64_t retired_count = 0;
+
+struct ThreadCounter {
+    std::atomic<std::uint64_t> value{0};
+
+    ThreadCounter() {
+        std::lock_guard lock(registry_mutex);
+        registry.push_back(this);
+    }
+    ~ThreadCounter() {
+        std::lock_guard lock(registry_mutex);
+        retired_count += value.load(std::memory_order_relaxed);
+        registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+    }
+};
+
+thread_local ThreadCounter invocations;
+thread_local Site site_of_thread;
+// 当前处理函数内嵌套执行的处理函数累计耗时，用于计算自身耗时
+thread_local std::chrono::nanoseconds child_time{0};
+
+std::atomic<std::int64_t> longest_ns{0};
+std::mutex longest_mutex;
+Site longest_site;
+
+void record(const Site& site, std::chrono::nanoseconds self_time) {
+    invocations.value.fetch_add(1, std::memory_order_relaxed);
+    if (self_time.count() <= longest_ns.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::lock_guard lock(longest_mutex);
+    if (self_time.count() > longest_ns.load(std::memory_order_relaxed)) {
+        longest_ns.store(self_time.count(), std::memory_order_relaxed);
+        longest_site = site;
+    }
+}
+} // namespace
+
+std::string Site::to_string() const {
+    if (empty()) {
+        return "unknown";
+    }
+    std::string_view path(file);
+    if (const auto slash = path.find_last_of("/\\"); slash != std::string_view::npos) {
+        path.remove_prefix(slash + 1);
+    }
+    std::string result(path);
+    result += ':';
+    result += std::to_string(line);
+    if (function != nullptr && *function != '\0') {
+        result += " (";
+        result += function;
+        result += ')';
+    }
+    return result;
+}
+
+Site& current_site() {
+    return site_of_thread;
+}
+
+Location::Location(const Site& site)
+    : saved_(site_of_thread) {
+    if (!site.empty()) {
+        site_of_thread = site;
+    }
+}
+
+Location::~Location() {
+    site_of_thread = saved_;
+}
+
+AsioLocation::AsioLocation(const char* file, int line, const char* function)
+    : saved_(site_of_thread) {
+    if (file != nullptr && site_of_thread.empty()) {
+        site_of_thread = Site{file, function, static_cast<std::uint32_t>(line)};
+    }
+}
+
+AsioLocation::~AsioLocation() {
+    site_of_thread = saved_;
+}
+
+Completion::Completion(const TrackedHandler& handler)
+    : site_(handler.tracked_site_)
+    , saved_site_(site_of_thread) {}
+
+Completion::~Completion() {
+    if (invoking_) {
+        invocation_end();
+    }
+    site_of_thread = saved_site_;
+}
+
+void Completion::begin() {
+    // 处理函数执行期间创建的异步操作继承它的位置
+    site_of_thread = site_;
+    saved_child_time_ = child_time;
+    child_time = std::chrono::nanoseconds{0};
+    invoking_ = true;
+    start_ = std::chrono::steady_clock::now();
+}
+
+void Completion::invocation_end() {
+    if (!invoking_) {
+        return;
+    }
+    invoking_ = false;
+    const auto elapsed = std::chrono::steady_clock::now() - start_;
+    record(site_, elapsed - child_time);
+    child_time = saved_child_time_ + elapsed;
+}
+
+std::uint64_t invocation_count() {
+    std::lock_guard lock(registry_mutex);
+    auto total = retired_count;
+    for (const auto* counter : registry) {
+        total += counter->value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::pair<std::chrono::nanoseconds, Site> take_longest() {
+    std::lock_guard lock(longest_mutex);
+    const auto longest = std::chrono::nanoseconds{longest_ns.exchange(0)};
+    return {longest, std::exchange(longest_site, Site{})};
+}
+} // namespace core::handler_tracking
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <source_location>
+#include <string>
+#include <utility>
+
+// asio 处理函数追踪。构建脚本定义 ASIO_CUSTOM_HANDLER_TRACKING 指向本文件，
+// asio 在创建、执行每个异步操作的处理函数时回调下面的宏，据此统计处理函数的执行次数、
+// 耗时以及发起位置，供 Executor 的运行指标使用。
+namespace core::handler_tracking {
+// 处理函数的发起位置。异步操作创建时继承当前正在执行的处理函数的位置，
+// Executor::spawn 等入口会用调用处覆盖，因此一个协程内的所有处理函数都归属于启动它的位置
+struct Site {
+    const char* file = nullptr;
+    const char* function = nullptr;
+    std::uint32_t line = 0;
+
+    bool empty() const { return file == nullptr; }
+    std::string to_string() const;
+};
+
+// asio 的操作对象（scheduler_operation 等）继承此类型，保存创建时的位置
+struct TrackedHandler {
+    Site tracked_site_;
+};
+
+// 当前线程正在执行的处理函数的位置
+Site& current_site();
+
+// 在作用域内把当前位置替换为 site，之后创建的异步操作归属于 site；site 为空时保持不变
+class Location {
+  public:
+    explicit Location(const Site& site);
+    explicit Location(const std::source_location& site)
+        : Location(Site{site.file_name(), site.function_name(), site.line()}) {}
+    ~Location();
+
+    Location(const Location&) = delete;
+    Location& operator=(const Location&) = delete;
+
+  private:
+    Site saved_;
+};
+
+// asio 内部标注的位置（co_spawn 入口等），只在当前位置未知时使用，
+// 不覆盖 Executor::spawn 等处记录的调用方位置
+class AsioLocation {
+  public:
+    AsioLocation(const char* file, int line, const char* function);
+    ~AsioLocation();
+
+    AsioLocation(const AsioLocation&) = delete;
+    AsioLocation& operator=(const AsioLocation&) = delete;
+
+  private:
+    Site saved_;
+};
+
+// 对应一次处理函数的完成。嵌套执行（strand 内、dispatch 内联）时只统计自身耗时，
+// 不包含内部嵌套的处理函数
+class Completion {
+  public:
+    explicit Completion(const TrackedHandler& handler);
+    ~Completion();
+
+    Completion(const Completion&) = delete;
+    Completion& operator=(const Completion&) = delete;
+
+    template<typename... Args>
+    void invocation_begin(Args&&...) {
+        begin();
+    }
+    void invocation_end();
+
+  private:
+    void begin();
+
+    Site site_;
+    Site saved_site_;
+    std::chrono::steady_clock::time_point start_{};
+    std::chrono::nanoseconds saved_child_time_{0};
+    bool invoking_ = false;
+};
+
+template<typename Context, typename... Rest>
+inline void creation(Context&, TrackedHandler& handler, Rest&&...) {
+    handler.tracked_site_ = current_site();
+}
+
+// 进程内所有线程累计执行的处理函数数量
+std::uint64_t invocation_count();
+
+// 取出自上次调用以来自身耗时最长的处理函数及其位置，并重新开始统计
+std::pair<std::chrono::nanoseconds, Site> take_longest();
+} // namespace core::handler_tracking
+
+#if defined(ASIO_CUSTOM_HANDLER_TRACKING)
+#define ASIO_INHERIT_TRACKED_HANDLER : public ::core::handler_tracking::TrackedHandler
+#define ASIO_ALSO_INHERIT_TRACKED_HANDLER , public ::core::handler_tracking::TrackedHandler
+#define ASIO_HANDLER_TRACKING_INIT (void) 0
+#define ASIO_HANDLER_LOCATION(args) ::core::handler_tracking::AsioLocation tracked_location args
+#define ASIO_HANDLER_CREATION(args) ::core::handler_tracking::creation args
+#define ASIO_HANDLER_COMPLETION(args) ::core::handler_tracking::Completion tracked_completion args
+#define ASIO_HANDLER_INVOCATION_BEGIN(args) tracked_completion.invocation_begin args
+#define ASIO_HANDLER_INVOCATION_END tracked_completion.invocation_end()
+#define ASIO_HANDLER_OPERATION(args) (void) 0
+#define ASIO_HANDLER_REACTOR_REGISTRATION(args) (void) 0
+#define ASIO_HANDLER_REACTOR_DEREGISTRATION(args) (void) 0
+#define ASIO_HANDLER_REACTOR_READ_EVENT 1
+#define ASIO_HANDLER_REACTOR_WRITE_EVENT 2
+#define ASIO_HANDLER_REACTOR_ERROR_EVENT 4
+#define ASIO_HANDLER_REACTOR_EVENTS(args) (void) 0
+#define ASIO_HANDLER_REACTOR_OPERATION(args) (void) 0
+#endif
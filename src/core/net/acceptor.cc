@@ -1,6 +1,7 @@
 #include "acceptor.h"
 #include "spdlog/spdlog.h"
 #include <asio/error_code.hpp>
+#include <asio/redirect_error.hpp>
 #include <asio/use_awaitable.hpp>
 
 namespace core::net {
@@ -8,29 +9,67 @@ Acceptor::~Acceptor() = default;
 
 void Acceptor::listen(uint16_t port) {
     acceptor_.open(asio::ip::tcp::v4());
+    acceptor_.set_option(asio::ip::tcp::acceptor::reuse_address(true));
+#if defined(SO_REUSEPORT)
+    if (executor_.get_io_mode() == IoMode::Sharded) {
+        using reuse_port = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+        acceptor_.set_option(reuse_port(true));
+    }
+#endif
     acceptor_.bind(asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port));
     acceptor_.listen();
 }
 
 asio::awaitable<void> Acceptor::accept() {
-    if (socket_.is_open()) {
-        socket_.close();
+    if (socket_->is_open()) {
+        socket_->close();
     }
-    co_await acceptor_.async_accept(socket_, asio::use_awaitable);
-    const auto endpoint = socket_.remote_endpoint();
+    co_await acceptor_.async_accept(*socket_, asio::use_awaitable);
+    const auto endpoint = socket_->remote_endpoint();
     spdlog::debug("Connection accepted from {}:{}", endpoint.address().to_string(), endpoint.port());
     co_return;
 }
 
+asio::awaitable<std::optional<asio::ip::tcp::socket>> Acceptor::accept(
+    asio::io_context& context) {
+    asio::ip::tcp::socket socket(context);
+    asio::error_code ec;
+    co_await acceptor_.async_accept(socket, asio::redirect_error(asio::use_awaitable, ec));
+    if (ec) {
+        if (ec != asio::error::operation_aborted) {
+            spdlog::warn("[Acceptor::accept] Accept failed: {}", ec.message());
+        }
+        co_return std::nullopt;
+    }
+    const auto endpoint = socket.remote_endpoint(ec);
+    if (!ec) {
+        spdlog::debug("Connection accepted from {}:{}",
+                      endpoint.address().to_string(),
+                      endpoint.port());
+    }
+    co_return std::optional<asio::ip::tcp::socket>(std::move(socket));
+}
+
+void Acceptor::close() {
+    asio::error_code ec;
+    acceptor_.close(ec);
+}
+
+std::uint16_t Acceptor::port() const {
+    asio::error_code ec;
+    const auto endpoint = acceptor_.local_endpoint(ec);
+    return ec ? 0 : endpoint.port();
+}
+
 void Acceptor::refuse() {
-    if (!socket_.is_open()) {
+    if (socket_ == nullptr || !socket_->is_open()) {
         spdlog::debug("No active connection to refuse.");
         return;
     }
 
     asio::error_code ec;
-    const auto endpoint = socket_.remote_endpoint(ec);
-    socket_.close();
+    const auto endpoint = socket_->remote_endpoint(ec);
+    socket_->close();
 
     if (!ec) {
         spdlog::debug("Connection refused from {}:{}",
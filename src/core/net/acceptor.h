@@ -4,23 +4,38 @@
 #include <asio/awaitable.hpp>
 #include <asio/ip/tcp.hpp>
 #include <cstdint>
+#include <optional>
 
 namespace core::net {
 class Acceptor {
   public:
     explicit Acceptor(Executor& executor, asio::ip::tcp::socket& socket)
         : executor_(executor)
-        , acceptor_(executor_.get_io_context())
-        , socket_(socket) {}
+        , acceptor_(socket.get_executor())
+        , socket_(&socket) {}
+    // 不绑定 socket，每个连接通过 accept(io_context) 接受到新的 socket 中，用于多连接的服务端
+    explicit Acceptor(Executor& executor)
+        : Acceptor(executor, executor.get_io_context()) {}
+    // 同上，监听 socket 位于 context 上，分片模式下每个分片各自监听
+    Acceptor(Executor& executor, asio::io_context& context)
+        : executor_(executor)
+        , acceptor_(context) {}
     ~Acceptor();
 
+    // 执行器为分片模式时开启 SO_REUSEPORT，各分片可以监听同一端口，由内核分配新连接
     void listen(std::uint16_t port);
     asio::awaitable<void> accept();
+    // 接受一个连接到位于 context 上的新 socket，监听被关闭或出错时返回 nullopt
+    asio::awaitable<std::optional<asio::ip::tcp::socket>> accept(asio::io_context& context);
     void refuse();
+    // 停止监听，进行中的 accept 随之结束
+    void close();
+    // 实际监听的端口，listen(0) 时由系统分配
+    std::uint16_t port() const;
 
   private:
     Executor& executor_;
     asio::ip::tcp::acceptor acceptor_;
-    asio::ip::tcp::socket& socket_;
+    asio::ip::tcp::socket* socket_ = nullptr;
 };
 } // namespace core::net
\ No newline at end of file
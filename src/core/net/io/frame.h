@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace core::net::io {
+
+// TCP 连接上的帧格式：4 字节负载长度、4 字节流 ID（均为网络字节序），随后是负载。
+// 会话的负载是序列化后的 MessageWrapper；流 ID 让一条连接同时承载多个互不相干的传输
+struct FrameHeader {
+    std::uint32_t length = 0;
+    std::uint32_t stream_id = 0;
+};
+
+inline constexpr std::size_t kFrameHeaderSize = 8;
+// 超过该长度的帧视为协议错误，避免对端发来的错误长度导致超大分配
+inline constexpr std::uint32_t kMaxFrameSize = 64 * 1024 * 1024;
+
+inline void encode_frame_header(const FrameHeader& header, std::byte* out) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<std::byte>(header.length >> (24 - 8 * i));
+        out[4 + i] = static_cast<std::byte>(header.stream_id >> (24 - 8 * i));
+    }
+}
+
+inline FrameHeader decode_frame_header(const std::byte* in) {
+    FrameHeader header;
+    for (int i = 0; i < 4; ++i) {
+        header.length = (header.length << 8) | std::to_integer<std::uint32_t>(in[i]);
+        header.stream_id = (header.stream_id << 8) | std::to_integer<std::uint32_t>(in[4 + i]);
+    }
+    return header;
+}
+} // namespace core::net::io
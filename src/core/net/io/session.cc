@@ -1,35 +1,220 @@
 #include "core/net/io/session.h"
 #include "asio/awaitable.hpp"
+#include "asio/dispatch.hpp"
+#include "asio/redirect_error.hpp"
+#include "asio/system_error.hpp"
+#include "asio/use_awaitable.hpp"
+#include <exception>
+#include <utility>
+#include <spdlog/spdlog.h>
 namespace core::net::io {
-Session::Session(core::Executor& executor, std::string_view host, uint16_t port)
-    : socket_(executor.get_io_context())
-    , executor_(executor)
-    , interactor_(executor_, socket_, host, port) {
+Session::Session(core::Executor& executor,
+                 std::string_view host,
+                 uint16_t port,
+                 std::function<void()> on_finished)
+    : executor_(executor)
+    , socket_(executor.next_io_context())
+    , interactor_(executor_, socket_, host, port)
+    , receive_gate_(socket_.get_executor())
+    , on_finished_(std::move(on_finished)) {
     interactor_.start();
-    executor_.spawn(start());
+    spawn(start());
 }
 
 Session::Session(core::Executor& executor, uint16_t port)
-    : socket_(executor.get_io_context())
-    , executor_(executor)
-    , interactor_(executor_, socket_, port) {
+    : executor_(executor)
+    , socket_(executor.next_io_context())
+    , interactor_(executor_, socket_, port)
+    , receive_gate_(socket_.get_executor()) {
     interactor_.start();
-    executor_.spawn(start());
+    spawn(start());
+}
+
+Session::Session(core::Executor& executor,
+                 asio::ip::tcp::socket socket,
+                 std::function<void()> on_finished)
+    : executor_(executor)
+    , socket_(std::move(socket))
+    , interactor_(executor_, socket_)
+    , receive_gate_(socket_.get_executor())
+    , on_finished_(std::move(on_finished)) {
+    spawn(start());
+}
+
+void Session::close() {
+    asio::dispatch(interactor_.strand(), [this]() {
+        running_.store(false);
+        asio::error_code ec;
+        socket_.shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+        socket_.close(ec);
+        resume_receive();
+    });
+}
+
+void Session::coroutine_finished() {
+    if (live_coroutines_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    // 回调可能销毁会话，先拷贝出来
+    auto on_finished = on_finished_;
+    on_finished();
 }
 
 asio::awaitable<void> Session::start() {
-    running_.store(true);
-    executor_.spawn(receive_loop());
+    // 构造时已经启动过接收循环；同一连接上两个接收循环会把帧读乱
+    if (running_.exchange(true)) {
+        co_return;
+    }
+    spawn(receive_loop());
     co_return;
 }
 
 asio::awaitable<void> Session::receive_loop() {
-    while (running_.load()) {
-        auto message_opt = co_await interactor_.receive_message<MessageWrapper>();
-        if (!message_opt.has_value()) {
-            continue;
+    try {
+        while (running_.load()) {
+            while (!can_receive() && running_.load()) {
+                receive_gate_.expires_at(asio::steady_timer::time_point::max());
+                asio::error_code ec;
+                co_await receive_gate_.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+            }
+            auto frame = co_await interactor_.receive_frame();
+            if (!frame.has_value()) {
+                // 连接没能建立时接收直接返回，不退出就会空转
+                if (!interactor_.is_connected()) {
+                    break;
+                }
+                continue;
+            }
+            MessageWrapper message;
+            if (!message.ParseFromArray(frame->payload.data(),
+                                        static_cast<int>(frame->payload.size()))) {
+                spdlog::warn("[io::Session::receive_loop] Malformed message on stream {}",
+                             frame->stream_id);
+                continue;
+            }
+            // 处理函数只持有引用，消息必须由派生出的协程自己持有，否则本轮循环结束即悬空
+            spawn([this, stream_id = frame->stream_id, message = std::move(message)]()
+                      -> asio::awaitable<void> {
+                co_await handle_stream_message(stream_id, message);
+            });
         }
-        executor_.spawn(handle_message(message_opt.value()));
+    } catch (const std::exception& e) {
+        spdlog::debug("[io::Session::receive_loop] Connection closed: {}", e.what());
     }
+    running_.store(false);
+    receive_stopped();
+}
+
+asio::awaitable<void> Session::enqueue_frame(std::uint32_t stream_id,
+                                             std::vector<std::byte> frame,
+                                             core::timer::Deadline deadline,
+                                             FramePriority priority) {
+    if (!writing_) {
+        // 写端空闲时调用方直接写出，省去排队与唤醒写协程；写出期间到达的帧交给写协程
+        writing_ = true;
+        const auto result = co_await write_frame(stream_id, frame, deadline);
+        recycle_frame(std::move(frame));
+        if (!has_queued_frames()) {
+            writing_ = false;
+        } else {
+            spawn(write_loop());
+        }
+        if (result) {
+            throw asio::system_error(result);
+        }
+        co_return;
+    }
+
+    asio::steady_timer done(interactor_.strand(), asio::steady_timer::time_point::max());
+    asio::error_code result;
+    const auto cost = frame.size() + kFrameHeaderSize;
+    PendingFrame pending{std::move(frame), deadline, &done, &result};
+    if (priority == FramePriority::Control && cost <= kMaxControlFrameSize) {
+        control_queue_.emplace_back(stream_id, std::move(pending));
+    } else {
+        send_queue_.push(stream_id, cost, std::move(pending));
+    }
+
+    // 写协程写完这一帧后取消 done，结果放在 result 中
+    asio::error_code ec;
+    co_await done.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+    if (result) {
+        throw asio::system_error(result);
+    }
+}
+
+asio::awaitable<void> Session::write_loop() {
+    while (auto next = next_frame()) {
+        auto& [stream_id, frame] = *next;
+        const auto result = co_await write_frame(stream_id, frame.bytes, frame.deadline);
+        recycle_frame(std::move(frame.bytes));
+        frame.complete(result);
+    }
+    writing_ = false;
+}
+
+asio::awaitable<asio::error_code> Session::write_frame(std::uint32_t stream_id,
+                                                       const std::vector<std::byte>& frame,
+                                                       core::timer::Deadline deadline) {
+    // 排队期间已经超时的帧不再写出，免得占用其他流的带宽
+    if (deadline.expired()) {
+        co_return asio::error::timed_out;
+    }
+    try {
+        co_await interactor_.send_frame(
+            stream_id, ConstDataBlock(frame.data(), frame.size()), deadline);
+        co_return asio::error_code{};
+    } catch (const asio::system_error& e) {
+        spdlog::debug("[io::Session::write_frame] Send failed: {}", e.what());
+        // 超时前一个字节都没写出时 socket 仍然打开，只有这一帧失败，其他帧与接收不受影响
+        if (e.code() == asio::error::timed_out && socket_.is_open()) {
+            co_return e.code();
+        }
+        // 帧可能只写出了一部分，连接上的字节流已无法继续使用，排队中的帧一并失败
+        auto fail = [&](std::uint32_t, PendingFrame pending) {
+            recycle_frame(std::move(pending.bytes));
+            pending.complete(e.code());
+        };
+        for (auto& [queued_stream, pending] : std::exchange(control_queue_, {})) {
+            fail(queued_stream, std::move(pending));
+        }
+        send_queue_.drain(fail);
+        close();
+        co_return e.code();
+    }
+}
+
+std::optional<std::pair<std::uint32_t, Session::PendingFrame>> Session::next_frame() {
+    if (control_queue_.empty()) {
+        return send_queue_.pop();
+    }
+    auto next = std::move(control_queue_.front());
+    control_queue_.pop_front();
+    return next;
+}
+
+std::vector<std::byte> Session::take_frame() {
+    if (spare_frames_.empty()) {
+        return {};
+    }
+    auto frame = std::move(spare_frames_.back());
+    spare_frames_.pop_back();
+    return frame;
+}
+
+void Session::recycle_frame(std::vector<std::byte> frame) {
+    // 只回收分块大小以内的缓冲区，避免个别超大帧长期占用内存
+    if (spare_frames_.size() < kMaxSpareFrames && frame.capacity() <= kMaxSpareFrameSize) {
+        frame.clear();
+        spare_frames_.push_back(std::move(frame));
+    }
+}
+
+asio::awaitable<void> Session::drop_unserializable(std::string_view type,
+                                                   std::vector<std::byte> frame) {
+    // 不是协程：调用 send() 时立即记录，返回的 awaitable 什么也不做
+    spdlog::error("[io::Session::send] Failed to serialize {}, message dropped", type);
+    recycle_frame(std::move(frame));
+    return []() -> asio::awaitable<void> { co_return; }();
 }
-} //namespace core::net::io
\ No newline at end of file
+} //namespace core::net::io
@@ -1,55 +1,182 @@
 #pragma once
 #include "asio/awaitable.hpp"
 #include "asio/ip/tcp.hpp"
+#include "asio/steady_timer.hpp"
 #include "core/executor.h"
 #include "core/net/io/tcp_interactor.h"
+#include "core/net/io/weighted_fair_queue.h"
 #include "session.pb.h"
 #include "tcp_interactor.h"
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <source_location>
+#include <utility>
 #include <vector>
 
 namespace core::net::io {
+
+// 帧的发送优先级。控制帧（应答、元数据等）走独立的优先通道，在帧边界上总是先于
+// 排队中的数据帧写出；数据帧之间按流加权公平排队
+enum class FramePriority { Control, Bulk };
+
 class Session {
   public:
-    Session(core::Executor& executor, std::string_view host, uint16_t port);
+    Session(core::Executor& executor,
+            std::string_view host,
+            uint16_t port,
+            std::function<void()> on_finished = {});
     Session(core::Executor& executor, uint16_t port);
-    ~Session() = default;
+    // 接管一个已接受的连接。on_finished 在会话的所有协程（包括接收循环）都结束后
+    // 在会话的串行执行器上调用一次，之后会话可以被销毁
+    Session(core::Executor& executor,
+            asio::ip::tcp::socket socket,
+            std::function<void()> on_finished = {});
+    virtual ~Session() = default;
 
     virtual asio::awaitable<void> start();
     
     bool is_running() const { return running_.load(); }
+    bool is_connected() const { return interactor_.is_connected(); }
     void stop() { running_.store(false); }
+    // 停止会话并关闭连接，阻塞中的收发随之失败，接收循环退出。可在任意线程调用
+    void close();
+
+    const asio::any_io_executor& strand() const { return interactor_.strand(); }
+
+    // 在会话的串行执行器上启动协程。会话状态只能在该执行器上访问，
+    // 因此会话及其子组件（如 SingleFileSender）都应通过这里派生协程
+    template<typename Awaitable>
+    void spawn(Awaitable&& awaitable,
+               std::source_location site = std::source_location::current()) {
+        if (!on_finished_) {
+            executor_.spawn_on(interactor_.strand(), std::forward<Awaitable>(awaitable), site);
+            return;
+        }
+        live_coroutines_.fetch_add(1, std::memory_order_relaxed);
+        executor_.spawn_on(
+            interactor_.strand(),
+            std::forward<Awaitable>(awaitable),
+            [this]() { coroutine_finished(); },
+            site);
+    }
+
+    // 会话级截止时间，约束之后会话内的所有收发（包括接收循环），
+    // 单次 send 传入的 deadline 只能把它收紧。只能在会话的串行执行器上调用
+    void set_deadline(core::timer::Deadline deadline) { interactor_.set_deadline(deadline); }
+    core::timer::Deadline deadline() const { return interactor_.deadline(); }
 
+    // 在 stream_id 流上发送消息并等待写出，失败时抛出 asio::system_error。
+    // 不是协程：调用时立即序列化，消息不必在 co_await 期间存活。
+    // 帧进入发送队列后由唯一的写协程按各流的权重公平调度写出，
+    // 小而紧急的流不会排在大流已经积压的分块之后。文件分块等大块数据应以 Bulk 发送，
+    // 否则会占用控制通道。只能在 strand() 上调用
     template<typename ProtobufType>
-    asio::awaitable<void> send(ProtobufType message) {
-        MessageWrapper wrapper;
-        wrapper.set_type(ProtobufType::descriptor()->full_name());
+    asio::awaitable<void> send(std::uint32_t stream_id,
+                               const ProtobufType& message,
+                               core::timer::Deadline deadline = {},
+                               FramePriority priority = FramePriority::Control) {
+        // 复用 send_wrapper_ 的字符串容量，消息直接序列化进 payload，再整体序列化成帧负载
+        send_wrapper_.set_type(ProtobufType::descriptor()->full_name());
 
         const size_t message_size = message.ByteSizeLong();
-        if (send_buffer_.size() < message_size) {
-            send_buffer_.resize(message_size);
+        auto* payload = send_wrapper_.mutable_payload();
+        payload->resize(message_size);
+        auto frame = take_frame();
+        if (!message.SerializeToArray(payload->data(), static_cast<int>(message_size))) {
+            return drop_unserializable(ProtobufType::descriptor()->full_name(), std::move(frame));
         }
-        if (!message.SerializeToArray(send_buffer_.data(), static_cast<int>(message_size))) {
-            co_return;
+        frame.resize(send_wrapper_.ByteSizeLong());
+        if (!send_wrapper_.SerializeToArray(frame.data(), static_cast<int>(frame.size()))) {
+            return drop_unserializable(ProtobufType::descriptor()->full_name(), std::move(frame));
         }
-        wrapper.set_payload(send_buffer_.data(), message_size);
+        return enqueue_frame(stream_id, std::move(frame), deadline, priority);
+    }
 
-        co_await interactor_.send_message(wrapper);
+    // 在默认的 0 号流上发送
+    template<typename ProtobufType>
+    asio::awaitable<void> send(const ProtobufType& message, core::timer::Deadline deadline = {}) {
+        return send(0, message, deadline);
     }
 
+    // 流的发送权重，忙碌的流按权重分享连接带宽，未设置时为 1。只能在 strand() 上调用
+    void set_stream_weight(std::uint32_t stream_id, std::uint32_t weight) {
+        send_queue_.set_weight(stream_id, weight);
+    }
+    void reset_stream_weight(std::uint32_t stream_id) { send_queue_.reset_weight(stream_id); }
+
+    // 处理能力恢复后调用，唤醒暂停中的接收循环。只能在 strand() 上调用
+    void resume_receive() { receive_gate_.cancel(); }
+
   protected:
+    // 子类处理能力饱和时返回 false，接收循环暂停读取 socket，由 TCP 流控向对端施加背压
+    virtual bool can_receive() const { return true; }
+    // 接收循环结束（连接断开、建立连接失败或 stop() 之后）时在串行执行器上调用一次
+    virtual void receive_stopped() {}
+
     core::Executor& executor_;
 
   private:
+    // 等待写出的一帧，done 与 result 指向 enqueue_frame 协程帧中的局部变量
+    struct PendingFrame {
+        std::vector<std::byte> bytes;
+        core::timer::Deadline deadline;
+        asio::steady_timer* done = nullptr;
+        asio::error_code* result = nullptr;
+
+        void complete(const asio::error_code& ec) {
+            *result = ec;
+            done->cancel();
+        }
+    };
+
     asio::awaitable<void> receive_loop();
-    virtual asio::awaitable<void> handle_message(const MessageWrapper& message) = 0;
+    asio::awaitable<void> enqueue_frame(std::uint32_t stream_id,
+                                        std::vector<std::byte> frame,
+                                        core::timer::Deadline deadline,
+                                        FramePriority priority);
+    // 控制通道优先，其次按加权公平顺序取数据帧
+    std::optional<std::pair<std::uint32_t, PendingFrame>> next_frame();
+    bool has_queued_frames() const { return !control_queue_.empty() || !send_queue_.empty(); }
+    asio::awaitable<void> write_loop();
+    // 写出一帧，失败时关闭连接并让排队中的帧一并失败，返回该帧的结果
+    asio::awaitable<asio::error_code> write_frame(std::uint32_t stream_id,
+                                                  const std::vector<std::byte>& frame,
+                                                  core::timer::Deadline deadline);
+    // 帧缓冲区复用，稳态下发送不分配内存
+    std::vector<std::byte> take_frame();
+    void recycle_frame(std::vector<std::byte> frame);
+    // 消息序列化失败：记录日志并回收帧，不发送
+    asio::awaitable<void> drop_unserializable(std::string_view type, std::vector<std::byte> frame);
+
+    // 处理一条消息。需要区分流的子类覆盖带 stream_id 的版本，默认交给不区分流的版本
+    virtual asio::awaitable<void> handle_stream_message(std::uint32_t stream_id,
+                                                        const MessageWrapper& message) {
+        return handle_message(message);
+    }
+    virtual asio::awaitable<void> handle_message(const MessageWrapper& message) { co_return; }
+    void coroutine_finished();
 
     std::atomic<bool> running_{false};
     asio::ip::tcp::socket socket_;
 
     core::net::io::TcpInteractor interactor_;
+    asio::steady_timer receive_gate_;
+
+    MessageWrapper send_wrapper_;
+    WeightedFairQueue<PendingFrame> send_queue_;
+    std::deque<std::pair<std::uint32_t, PendingFrame>> control_queue_;
+    // 超过该大小的控制帧（例如文件很多时的元数据）按数据帧排队，免得长时间独占连接
+    static constexpr std::size_t kMaxControlFrameSize = 64 * 1024;
+    bool writing_ = false;
+    static constexpr std::size_t kMaxSpareFrames = 16;
+    static constexpr std::size_t kMaxSpareFrameSize = 2 * kDefaultChunkSize;
+    std::vector<std::vector<std::byte>> spare_frames_;
 
-    std::vector<std::byte> send_buffer_;
+    std::function<void()> on_finished_;
+    std::atomic<std::size_t> live_coroutines_{0};
 };
 } // namespace core::net::io
\ No newline at end of file
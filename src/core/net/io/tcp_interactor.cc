@@ -1,42 +1,84 @@
 #include "tcp_interactor.h"
+#include <algorithm>
+#include <array>
+#include <asio/bind_cancellation_slot.hpp>
+#include <asio/read.hpp>
 #include <asio/redirect_error.hpp>
 #include <asio/steady_timer.hpp>
+#include <asio/system_error.hpp>
+#include <asio/this_coro.hpp>
+#include <asio/write.hpp>
 
 namespace core::net::io {
 
+namespace {
+// 与 use_awaitable 的行为一致，失败时抛出 asio::system_error。
+// 截止时间到达时操作可能恰好已经完成，只有被中止的操作才算超时
+void throw_on_error(const asio::error_code& ec, const timer::DeadlineGuard& guard) {
+    if (ec == asio::error::operation_aborted && guard.timed_out()) {
+        throw asio::system_error(asio::error::timed_out);
+    }
+    if (ec) {
+        throw asio::system_error(ec);
+    }
+}
+
+// socket 已关闭（或连接没能建立）时收发不能当作成功，调用方据此发现连接已断开
+void throw_if_closed(const asio::ip::tcp::socket& socket) {
+    if (!socket.is_open()) {
+        throw asio::system_error(asio::error::not_connected);
+    }
+}
+} // namespace
+
 // 客户端模式构造函数
 TcpInteractor::TcpInteractor(Executor& executor,
                              asio::ip::tcp::socket& socket,
                              std::string_view host,
                              uint16_t port)
     : executor_(executor)
+    , strand_(executor.make_serial_executor(socket.get_executor()))
     , socket_(socket)
     , mode_(TcpInteractorMode::Client)
     , connector_(std::in_place, executor, socket)
     , host_(host)
     , port_(port)
-    , ready_signal_(std::make_shared<asio::steady_timer>(executor.get_io_context())) {
+    , ready_signal_(std::make_shared<asio::steady_timer>(socket.get_executor())) {
     ready_signal_->expires_at(asio::steady_timer::time_point::max());
 }
 
 // 服务端模式构造函数
 TcpInteractor::TcpInteractor(Executor& executor, asio::ip::tcp::socket& socket, std::uint16_t port)
     : executor_(executor)
+    , strand_(executor.make_serial_executor(socket.get_executor()))
     , socket_(socket)
     , mode_(TcpInteractorMode::Server)
     , port_(port)
     , acceptor_(std::in_place, executor, socket)
-    , ready_signal_(std::make_shared<asio::steady_timer>(executor.get_io_context())) {
+    , ready_signal_(std::make_shared<asio::steady_timer>(socket.get_executor())) {
     ready_signal_->expires_at(asio::steady_timer::time_point::max());
     if (acceptor_) {
         acceptor_->listen(port_);
     }
 }
 
+// 已接受连接构造函数
+TcpInteractor::TcpInteractor(Executor& executor, asio::ip::tcp::socket& socket)
+    : executor_(executor)
+    , strand_(executor.make_serial_executor(socket.get_executor()))
+    , socket_(socket)
+    , mode_(TcpInteractorMode::Accepted)
+    , port_(0)
+    , ready_signal_(std::make_shared<asio::steady_timer>(socket.get_executor()))
+    , connected_(socket.is_open()) {}
+
 void TcpInteractor::start() {
+    if (mode_ == TcpInteractorMode::Accepted) {
+        return;
+    }
     if (mode_ == TcpInteractorMode::Client) {
         // 客户端模式：主动连接
-        executor_.spawn([this]() -> asio::awaitable<void> {
+        executor_.spawn_on(strand_, [this]() -> asio::awaitable<void> {
             if (!connector_) {
                 co_return;
             }
@@ -46,7 +88,7 @@ void TcpInteractor::start() {
         });
     } else {
         // 服务端模式：监听并接受连接
-        executor_.spawn([this]() -> asio::awaitable<void> {
+        executor_.spawn_on(strand_, [this]() -> asio::awaitable<void> {
             if (!acceptor_) {
                 co_return;
             }
@@ -64,37 +106,154 @@ asio::awaitable<void> TcpInteractor::wait_for_ready() {
     }
 }
 
-asio::awaitable<void> TcpInteractor::send(ConstDataBlock data) {
+asio::awaitable<void> TcpInteractor::send(ConstDataBlock data, timer::Deadline deadline) {
     if (data.empty()) {
         co_return;
     }
 
-    co_await wait_for_ready();
+    // 已连接时不进入 wait_for_ready，避免每次收发都多分配一个协程帧
+    if (!connected_.load()) {
+        co_await wait_for_ready();
+    }
 
-    if (!socket_.is_open()) {
-        co_return;
+    throw_if_closed(socket_);
+
+    deadline = deadline.earliest(deadline_);
+    if (deadline.expired()) {
+        throw asio::system_error(asio::error::timed_out);
     }
 
-    co_await socket_.async_send(asio::buffer(static_cast<const void*>(data.data()), data.size()),
-                                asio::use_awaitable);
+    timer::DeadlineGuard guard(co_await asio::this_coro::executor, deadline);
+    asio::error_code ec;
+    co_await socket_.async_send(
+        asio::buffer(static_cast<const void*>(data.data()), data.size()),
+        asio::bind_cancellation_slot(guard.slot(), asio::redirect_error(asio::use_awaitable, ec)));
+    if (guard.finish()) {
+        co_await guard.settle();
+    }
+    throw_on_error(ec, guard);
 }
 
-asio::awaitable<void> TcpInteractor::receive(MutDataBlock& buffer) {
+asio::awaitable<void> TcpInteractor::receive(MutDataBlock& buffer, timer::Deadline deadline) {
     if (buffer.empty()) {
         co_return;
     }
 
-    co_await wait_for_ready();
+    // 已连接时不进入 wait_for_ready，避免每次收发都多分配一个协程帧
+    if (!connected_.load()) {
+        co_await wait_for_ready();
+    }
 
-    if (!socket_.is_open()) {
-        co_return;
+    throw_if_closed(socket_);
+
+    deadline = deadline.earliest(deadline_);
+    if (deadline.expired()) {
+        throw asio::system_error(asio::error::timed_out);
     }
 
-    std::size_t bytes_received = co_await socket_.async_receive(asio::buffer(static_cast<void*>(
-                                                                                 buffer.data()),
-                                                                             buffer.size()),
-                                                                asio::use_awaitable);
+    timer::DeadlineGuard guard(co_await asio::this_coro::executor, deadline);
+    asio::error_code ec;
+    std::size_t bytes_received = co_await socket_.async_receive(
+        asio::buffer(static_cast<void*>(buffer.data()), buffer.size()),
+        asio::bind_cancellation_slot(guard.slot(), asio::redirect_error(asio::use_awaitable, ec)));
+    if (guard.finish()) {
+        co_await guard.settle();
+    }
+    throw_on_error(ec, guard);
     buffer = buffer.first(bytes_received);
 }
 
+asio::awaitable<void> TcpInteractor::send_frame(std::uint32_t stream_id,
+                                                ConstDataBlock payload,
+                                                timer::Deadline deadline) {
+    if (!connected_.load()) {
+        co_await wait_for_ready();
+    }
+    throw_if_closed(socket_);
+    if (payload.size() > kMaxFrameSize) {
+        throw asio::system_error(asio::error::message_size);
+    }
+
+    deadline = deadline.earliest(deadline_);
+    if (deadline.expired()) {
+        throw asio::system_error(asio::error::timed_out);
+    }
+
+    std::array<std::byte, kFrameHeaderSize> header;
+    encode_frame_header({static_cast<std::uint32_t>(payload.size()), stream_id}, header.data());
+    // 帧头与负载一次聚合写出，不为拼接再复制负载
+    const std::array<asio::const_buffer, 2> buffers{
+        asio::buffer(header),
+        asio::buffer(static_cast<const void*>(payload.data()), payload.size())};
+
+    timer::DeadlineGuard guard(co_await asio::this_coro::executor, deadline);
+    asio::error_code ec;
+    const auto written = co_await asio::async_write(
+        socket_,
+        buffers,
+        asio::bind_cancellation_slot(guard.slot(), asio::redirect_error(asio::use_awaitable, ec)));
+    if (guard.finish()) {
+        co_await guard.settle();
+    }
+    // 超时前已写出半帧时字节流无法继续使用；一个字节都没写出时连接不受影响
+    if (ec && written > 0) {
+        close_broken_stream();
+    }
+    throw_on_error(ec, guard);
+}
+
+asio::awaitable<std::optional<TcpInteractor::Frame>> TcpInteractor::receive_frame(
+    timer::Deadline deadline) {
+    if (!connected_.load()) {
+        co_await wait_for_ready();
+    }
+    throw_if_closed(socket_);
+
+    deadline = deadline.earliest(deadline_);
+    if (deadline.expired()) {
+        throw asio::system_error(asio::error::timed_out);
+    }
+
+    std::array<std::byte, kFrameHeaderSize> header_bytes;
+    co_await read_exactly(header_bytes, deadline, false);
+    const auto header = decode_frame_header(header_bytes.data());
+    if (header.length > kMaxFrameSize) {
+        throw asio::system_error(asio::error::message_size);
+    }
+
+    if (receive_buffer_.size() < header.length) {
+        receive_buffer_.resize(std::max<std::size_t>(header.length, kDefaultBufferSize));
+    }
+    MutDataBlock payload(receive_buffer_.data(), header.length);
+    if (!payload.empty()) {
+        co_await read_exactly(payload, deadline, true);
+    }
+    co_return Frame{header.stream_id, payload};
+}
+
+asio::awaitable<void> TcpInteractor::read_exactly(MutDataBlock buffer,
+                                                 timer::Deadline deadline,
+                                                 bool mid_frame) {
+    timer::DeadlineGuard guard(co_await asio::this_coro::executor, deadline);
+    asio::error_code ec;
+    const auto bytes_read = co_await asio::async_read(
+        socket_,
+        asio::buffer(static_cast<void*>(buffer.data()), buffer.size()),
+        asio::bind_cancellation_slot(guard.slot(), asio::redirect_error(asio::use_awaitable, ec)));
+    if (guard.finish()) {
+        co_await guard.settle();
+    }
+    // 超时前已读入半帧时字节流无法继续使用；一个字节都没读到时连接不受影响
+    if (ec && (mid_frame || bytes_read > 0)) {
+        close_broken_stream();
+    }
+    throw_on_error(ec, guard);
+}
+
+void TcpInteractor::close_broken_stream() {
+    asio::error_code ec;
+    socket_.shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+    socket_.close(ec);
+}
+
 } // namespace core::net::io
@@ -3,6 +3,8 @@
 #include "core/executor.h"
 #include "core/net/acceptor.h"
 #include "core/net/connector.h"
+#include "core/net/io/frame.h"
+#include "core/timer/deadline.h"
 #include "util/data_block.h"
 #include <asio/awaitable.hpp>
 #include <asio/ip/tcp.hpp>
@@ -15,7 +17,8 @@
 
 namespace core::net::io {
 
-enum class TcpInteractorMode { Client, Server };
+// Accepted：socket 已由外部（例如 receiver::Server 的监听循环）接受，构造后即处于连接状态
+enum class TcpInteractorMode { Client, Server, Accepted };
 
 class TcpInteractor {
   public:
@@ -26,6 +29,9 @@ class TcpInteractor {
 
     TcpInteractor(Executor& executor, asio::ip::tcp::socket& socket, std::uint16_t port);
 
+    // 已连接的 socket，start() 不再建立连接
+    TcpInteractor(Executor& executor, asio::ip::tcp::socket& socket);
+
     ~TcpInteractor() = default;
 
     TcpInteractor(const TcpInteractor&) = delete;
@@ -37,42 +43,66 @@ class TcpInteractor {
 
     bool is_connected() const { return connected_.load(); }
 
-    asio::awaitable<void> send(ConstDataBlock data);
-    asio::awaitable<void> receive(MutDataBlock& buffer);
+    // 连接建立以及所属 Session 的协程都在此串行执行器上运行，它位于 socket 所在的分片
+    const asio::any_io_executor& strand() const { return strand_; }
+
+    // 收发使用 deadline 与 set_deadline() 设置的截止时间中较早的一个，
+    // 超时抛出 asio::error::timed_out，只中止这一次收发；socket 已关闭时抛出 not_connected
+    // （其他错误与 use_awaitable 一样抛出）。
+    // send/receive 是不分帧的原始字节收发，消息应使用下面的按帧接口
+    asio::awaitable<void> send(ConstDataBlock data, timer::Deadline deadline = {});
+    asio::awaitable<void> receive(MutDataBlock& buffer, timer::Deadline deadline = {});
+
+    // 整个连接的截止时间，约束之后的所有收发。只能在 strand() 上调用
+    void set_deadline(timer::Deadline deadline) { deadline_ = deadline; }
+    timer::Deadline deadline() const { return deadline_; }
 
     std::vector<std::byte>& get_send_buffer() { return send_buffer_; }
     std::vector<std::byte>& get_receive_buffer() { return receive_buffer_; }
 
+    // 一帧消息，payload 指向 get_receive_buffer()，在下一次接收前有效
+    struct Frame {
+        std::uint32_t stream_id = 0;
+        MutDataBlock payload;
+    };
+
+    // 按帧收发，帧格式见 frame.h。send_frame 写出整帧，receive_frame 读满整帧；
+    // 对端关闭连接时抛出 asio::error::eof，帧长度超过 kMaxFrameSize 时抛出 message_size。
+    // 超时发生在一帧的中途时关闭 socket，否则连接仍可继续使用。
+    // 同一方向上不能并发调用，Session 通过单个写协程串行化发送
+    asio::awaitable<void> send_frame(std::uint32_t stream_id,
+                                     ConstDataBlock payload,
+                                     timer::Deadline deadline = {});
+    asio::awaitable<std::optional<Frame>> receive_frame(timer::Deadline deadline = {});
+
+    // 不是协程：调用时立即序列化到 send_buffer_，返回的 awaitable 必须马上 co_await，
+    // 这样每次发送少一层协程帧
     template<util::ProtobufMessage T>
-    asio::awaitable<void> send_message(const T& message) {
+    asio::awaitable<void> send_message(const T& message,
+                                       timer::Deadline deadline = {},
+                                       std::uint32_t stream_id = 0) {
         const size_t size = message.ByteSizeLong();
 
         if (send_buffer_.size() < size) {
             send_buffer_.resize(size);
         }
         if (!message.SerializeToArray(send_buffer_.data(), static_cast<int>(size))) {
-            co_return;
+            return send({}, deadline);
         }
 
-        ConstDataBlock data(send_buffer_.data(), size);
-        co_await send(data);
+        return send_frame(stream_id, ConstDataBlock(send_buffer_.data(), size), deadline);
     }
 
     template<util::ProtobufMessage T>
-    asio::awaitable<std::optional<T>> receive_message() {
-        if (receive_buffer_.size() < kDefaultBufferSize) {
-            receive_buffer_.resize(kDefaultBufferSize);
-        }
-
-        MutDataBlock buf_span(receive_buffer_.data(), receive_buffer_.size());
-        co_await receive(buf_span);
-
-        if (buf_span.empty()) {
+    asio::awaitable<std::optional<T>> receive_message(timer::Deadline deadline = {}) {
+        auto frame = co_await receive_frame(deadline);
+        if (!frame.has_value()) {
             co_return std::nullopt;
         }
 
         T message;
-        if (!message.ParseFromArray(buf_span.data(), static_cast<int>(buf_span.size()))) {
+        const auto& payload = frame->payload;
+        if (!message.ParseFromArray(payload.data(), static_cast<int>(payload.size()))) {
             co_return std::nullopt;
         }
         co_return message;
@@ -80,8 +110,15 @@ class TcpInteractor {
 
   private:
     asio::awaitable<void> wait_for_ready();
+    // 读满 buffer，deadline 已与连接的截止时间合并。mid_frame 表示帧的前一部分已经读入
+    asio::awaitable<void> read_exactly(MutDataBlock buffer,
+                                       timer::Deadline deadline,
+                                       bool mid_frame);
+    // 帧只收发了一部分时字节流已错位，关闭 socket，连接上的其他操作随之结束
+    void close_broken_stream();
 
     Executor& executor_;
+    asio::any_io_executor strand_;
     asio::ip::tcp::socket& socket_;
     TcpInteractorMode mode_;
 
@@ -93,6 +130,7 @@ class TcpInteractor {
 
     std::shared_ptr<asio::steady_timer> ready_signal_;
     std::atomic<bool> connected_{false};
+    timer::Deadline deadline_;
 
     std::vector<std::byte> send_buffer_;
     std::vector<std::byte> receive_buffer_;
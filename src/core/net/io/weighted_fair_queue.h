@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+namespace core::net::io {
+
+// 按流加权公平排队（自计时的 SCFQ）。每个元素带一个代价（通常是字节数），
+// 入队时打上完成标签 max(虚拟时间, 该流上一个标签) + 代价 / 权重，出队取标签最小的元素，
+// 虚拟时间随之推进到该标签。同一流内保持先进先出；长期来看各个忙碌的流按权重分享带宽，
+// 新出现的小流不必排在大流已经积压的元素之后。
+// 不是线程安全的，通常只在会话的串行执行器上使用
+template<typename Item>
+class WeightedFairQueue {
+  public:
+    // 未设置权重的流按 1 计算，weight 为 0 时按 1 处理
+    void set_weight(std::uint32_t stream_id, std::uint32_t weight) {
+        weights_[stream_id] = std::max<std::uint32_t>(weight, 1);
+    }
+    void reset_weight(std::uint32_t stream_id) { weights_.erase(stream_id); }
+    std::uint32_t weight(std::uint32_t stream_id) const {
+        const auto it = weights_.find(stream_id);
+        return it == weights_.end() ? 1 : it->second;
+    }
+
+    void push(std::uint32_t stream_id, std::size_t cost, Item item) {
+        auto& flow = flows_[stream_id];
+        const double start = std::max(virtual_time_, flow.last_finish);
+        flow.last_finish = start + static_cast<double>(std::max<std::size_t>(cost, 1))
+                                       / weight(stream_id);
+        flow.items.push_back(Entry{flow.last_finish, sequence_++, std::move(item)});
+        ++size_;
+    }
+
+    // 取出完成标签最小的元素及其所属的流，队列为空时返回 nullopt
+    std::optional<std::pair<std::uint32_t, Item>> pop() {
+        auto best = flows_.end();
+        for (auto it = flows_.begin(); it != flows_.end(); ++it) {
+            if (best == flows_.end()
+                || it->second.items.front().before(best->second.items.front())) {
+                best = it;
+            }
+        }
+        if (best == flows_.end()) {
+            return std::nullopt;
+        }
+
+        const auto stream_id = best->first;
+        auto& entry = best->second.items.front();
+        virtual_time_ = entry.finish;
+        std::pair<std::uint32_t, Item> result{stream_id, std::move(entry.item)};
+        best->second.items.pop_front();
+        // 流排空时它最后的标签不超过虚拟时间，之后再入队从虚拟时间起算，可以丢掉状态
+        if (best->second.items.empty()) {
+            flows_.erase(best);
+        }
+        --size_;
+        return result;
+    }
+
+    bool empty() const { return size_ == 0; }
+    std::size_t size() const { return size_; }
+
+    // 取出所有元素（例如连接断开时逐个通知失败），按流分组、流内有序
+    template<typename Fn>
+    void drain(Fn&& fn) {
+        for (auto& [stream_id, flow] : flows_) {
+            for (auto& entry : flow.items) {
+                fn(stream_id, std::move(entry.item));
+            }
+        }
+        flows_.clear();
+        size_ = 0;
+    }
+
+  private:
+    struct Entry {
+        double finish;
+        std::uint64_t sequence; // 标签相同时先入队的先出
+        Item item;
+
+        bool before(const Entry& other) const {
+            return finish < other.finish || (finish == other.finish && sequence < other.sequence);
+        }
+    };
+    struct Flow {
+        double last_finish = 0;
+        std::deque<Entry> items;
+    };
+
+    // 流的数目通常很少，出队时线性查找最小标签比维护堆更便宜
+    std::map<std::uint32_t, Flow> flows_;
+    std::unordered_map<std::uint32_t, std::uint32_t> weights_;
+    double virtual_time_ = 0;
+    std::uint64_t sequence_ = 0;
+    std::size_t size_ = 0;
+};
+} // namespace core::net::io
@@ -0,0 +1,143 @@
+#include "numa.h"
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+#include <spdlog/spdlog.h>
+#include <sstream>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace core::numa {
+
+namespace {
+std::optional<std::size_t> parse_number(std::string_view text) {
+    std::size_t value = 0;
+    const auto* end = text.data() + text.size();
+    const auto [ptr, ec] = std::from_chars(text.data(), end, value);
+    if (ec != std::errc() || ptr != end) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+std::string_view trim(std::string_view text) {
+    const auto begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    const auto end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+std::optional<std::string> read_first_line(const std::filesystem::path& path) {
+    std::ifstream file(path);
+    std::string line;
+    if (!file || !std::getline(file, line)) {
+        return std::nullopt;
+    }
+    return line;
+}
+} // namespace
+
+std::vector<std::size_t> parse_cpu_list(std::string_view list) {
+    std::vector<std::size_t> cpus;
+    while (!list.empty()) {
+        const auto comma = list.find(',');
+        const auto part = trim(list.substr(0, comma));
+        list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+
+        const auto dash = part.find('-');
+        const auto first = parse_number(part.substr(0, dash));
+        const auto last = dash == std::string_view::npos ? first
+                                                         : parse_number(part.substr(dash + 1));
+        if (!first || !last || *last < *first) {
+            continue;
+        }
+        for (auto cpu = *first; cpu <= *last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+std::optional<int> interface_node(const std::string& interface,
+                                  const std::filesystem::path& sysfs) {
+    if (interface.empty()) {
+        return std::nullopt;
+    }
+    const auto line = read_first_line(sysfs / "class" / "net" / interface / "device" / "numa_node");
+    if (!line) {
+        return std::nullopt;
+    }
+    const auto node = parse_number(trim(*line));
+    // 单节点机器上内核写入 -1，parse_number 不接受负数
+    if (!node) {
+        return std::nullopt;
+    }
+    return static_cast<int>(*node);
+}
+
+std::string default_route_interface(const std::filesystem::path& route_table) {
+    std::ifstream file(route_table);
+    std::string line;
+    std::getline(file, line); // 表头
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string interface;
+        std::string destination;
+        if (fields >> interface >> destination && destination == "00000000") {
+            return interface;
+        }
+    }
+    return {};
+}
+
+std::vector<std::size_t> node_cpus(int node, const std::filesystem::path& sysfs) {
+    if (node < 0) {
+        return {};
+    }
+    const auto line = read_first_line(sysfs / "devices" / "system" / "node"
+                                      / ("node" + std::to_string(node)) / "cpulist");
+    return line ? parse_cpu_list(*line) : std::vector<std::size_t>{};
+}
+
+void* allocate(std::size_t bytes, int node) {
+    if (bytes == 0) {
+        return nullptr;
+    }
+#if defined(__linux__)
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+    if (node >= 0 && node < 64) {
+        // 不依赖 libnuma，直接调用 mbind；MPOL_PREFERRED 在节点内存不足时仍可从其他节点分配
+        constexpr int kMpolPreferred = 1;
+        const unsigned long mask = 1UL << node;
+        if (syscall(SYS_mbind, memory, bytes, kMpolPreferred, &mask, 64UL, 0U) != 0) {
+            spdlog::debug("[numa::allocate] mbind to node {} failed, using default policy", node);
+        }
+    }
+    return memory;
+#else
+    (void) node;
+    return std::aligned_alloc(4096, (bytes + 4095) / 4096 * 4096);
+#endif
+}
+
+void deallocate(void* memory, std::size_t bytes) {
+    if (memory == nullptr) {
+        return;
+    }
+#if defined(__linux__)
+    munmap(memory, bytes);
+#else
+    (void) bytes;
+    std::free(memory);
+#endif
+}
+} // namespace core::numa
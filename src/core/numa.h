@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// NUMA 拓扑探测与按节点分配内存。只在 Linux 上通过 sysfs 与 mbind 实现，
+// 其他平台上探测函数返回空结果，分配退化为普通分配
+namespace core::numa {
+
+// 解析 sysfs 的 cpulist 格式，例如 "0-3,8,10-11"；格式错误的部分被忽略
+std::vector<std::size_t> parse_cpu_list(std::string_view list);
+
+// 网卡所在的 NUMA 节点，来自 /sys/class/net/<interface>/device/numa_node。
+// 虚拟网卡或单节点机器上没有该信息（或为 -1）时返回 nullopt
+std::optional<int> interface_node(const std::string& interface,
+                                  const std::filesystem::path& sysfs = "/sys");
+
+// 默认路由所在的网卡，来自 /proc/net/route，找不到时返回空字符串
+std::string default_route_interface(const std::filesystem::path& route_table = "/proc/net/route");
+
+// 节点上的 cpu 列表，节点不存在时为空
+std::vector<std::size_t> node_cpus(int node, const std::filesystem::path& sysfs = "/sys");
+
+// 分配按页对齐的内存并优先放在 node 上；node < 0 或不支持时不指定节点。
+// 失败时返回 nullptr，必须用 deallocate 释放
+void* allocate(std::size_t bytes, int node);
+void deallocate(void* memory, std::size_t bytes);
+} // namespace core::numa
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "core/channel.h"
+#include "core/executor.h"
+#include <asio/awaitable.hpp>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace core {
+namespace detail {
+template<typename T>
+inline constexpr bool is_optional = false;
+template<typename T>
+inline constexpr bool is_optional<std::optional<T>> = true;
+} // namespace detail
+
+// 由有界通道连接的流水线，例如 读取 → 哈希 → 分帧 → 写入。
+// 每两级之间是一个容量为 depth 的 Channel，下游处理不过来时上游挂起在 push 上，
+// 背压逐级传回源头，整条流水线占用的内存有上限。
+// 某一级的输入通道关闭且取空后，该级所有工作协程退出并关闭它的输出通道，
+// 源头 close() 之后整条流水线依次结束。sink() 是最后一级，添加前流水线不会结束，
+// 即使前面的级已经全部退出。Pipeline 必须比 join() 活得更久
+class Pipeline {
+  public:
+    struct StageOccupancy {
+        std::string name;
+        std::size_t queued = 0;   // 输入通道中等待处理的元素
+        std::size_t capacity = 0; // 输入通道容量
+        std::size_t busy = 0;     // 正在处理元素的工作协程
+        std::size_t workers = 0;
+        std::size_t processed = 0;
+    };
+
+    Pipeline(Executor& executor, std::size_t depth)
+        : executor_(executor)
+        , depth_(depth) {}
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    // 新建由流水线持有的通道，容量为 depth
+    template<typename T>
+    Channel<T>& make_channel() {
+        auto channel = std::make_unique<Channel<T>>(depth_);
+        auto& ref = *channel;
+        channels_.push_back(std::move(channel));
+        return ref;
+    }
+
+    // 启动一级：workers 个协程从 in 取出元素，co_await fn(item) 的结果放入 out。
+    // fn 返回 awaitable<Out>，或者 awaitable<std::optional<Out>>（nullopt 表示丢弃）。
+    // workers 大于 1 时输出顺序不保证与输入一致。计算密集的 fn 应在内部使用 offload
+    template<typename In, typename Out, typename Fn>
+    void stage(std::string name,
+               Channel<In>& in,
+               Channel<Out>& out,
+               Fn fn,
+               std::size_t workers = 1) {
+        auto& state = add_stage(std::move(name), in, workers);
+        for (std::size_t i = 0; i < workers; ++i) {
+            executor_.spawn([this, &state, &in, &out, fn]() -> asio::awaitable<void> {
+                while (auto item = co_await in.pop()) {
+                    state.busy.fetch_add(1, std::memory_order_relaxed);
+                    auto result = co_await fn(std::move(*item));
+                    state.busy.fetch_sub(1, std::memory_order_relaxed);
+                    state.processed.fetch_add(1, std::memory_order_relaxed);
+                    if constexpr (detail::is_optional<decltype(result)>) {
+                        if (!result) {
+                            continue;
+                        }
+                        if (!co_await out.push(std::move(*result))) {
+                            break;
+                        }
+                    } else if (!co_await out.push(std::move(result))) {
+                        break;
+                    }
+                }
+                // 下游已关闭时也要关闭输入，让上游停止生产
+                if (out.is_closed()) {
+                    in.close();
+                }
+                finish_worker(state, &out);
+            });
+        }
+    }
+
+    // 启动最后一级：workers 个协程从 in 取出元素并 co_await fn(item)
+    template<typename In, typename Fn>
+    void sink(std::string name, Channel<In>& in, Fn fn, std::size_t workers = 1) {
+        auto& state = add_stage(std::move(name), in, workers);
+        for (std::size_t i = 0; i < workers; ++i) {
+            executor_.spawn([this, &state, &in, fn]() -> asio::awaitable<void> {
+                while (auto item = co_await in.pop()) {
+                    state.busy.fetch_add(1, std::memory_order_relaxed);
+                    co_await fn(std::move(*item));
+                    state.busy.fetch_sub(1, std::memory_order_relaxed);
+                    state.processed.fetch_add(1, std::memory_order_relaxed);
+                }
+                finish_worker(state, nullptr);
+            });
+        }
+        // 释放构建期间持有的计数，此后所有工作协程退出时 join() 才会返回
+        if (!sealed_) {
+            sealed_ = true;
+            release();
+        }
+    }
+
+    // sink() 已添加且所有级都结束后返回
+    asio::awaitable<void> join() { co_await finished_.pop(); }
+
+    // 各级的占用情况，按添加顺序排列
+    std::vector<StageOccupancy> occupancy() const {
+        std::vector<StageOccupancy> result;
+        result.reserve(stages_.size());
+        for (const auto& state : stages_) {
+            result.push_back({state->name,
+                              state->input.size(),
+                              state->input.capacity(),
+                              state->busy.load(std::memory_order_relaxed),
+                              state->workers,
+                              state->processed.load(std::memory_order_relaxed)});
+        }
+        return result;
+    }
+
+  private:
+    struct StageState {
+        StageState(std::string name, ChannelBase& input, std::size_t workers)
+            : name(std::move(name))
+            , input(input)
+            , workers(workers)
+            , remaining(workers) {}
+
+        std::string name;
+        ChannelBase& input;
+        std::size_t workers;
+        std::atomic<std::size_t> remaining;
+        std::atomic<std::size_t> busy{0};
+        std::atomic<std::size_t> processed{0};
+    };
+
+    StageState& add_stage(std::string name, ChannelBase& input, std::size_t& workers) {
+        workers = workers > 0 ? workers : 1;
+        running_.fetch_add(workers, std::memory_order_relaxed);
+        stages_.push_back(std::make_unique<StageState>(std::move(name), input, workers));
+        return *stages_.back();
+    }
+
+    // 一级的最后一个工作协程退出时关闭输出通道，流水线建好后最后一个协程退出时唤醒 join()
+    void finish_worker(StageState& state, ChannelBase* output) {
+        if (state.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 && output != nullptr) {
+            output->close();
+        }
+        release();
+    }
+
+    void release() {
+        if (running_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            finished_.close();
+        }
+    }
+
+    Executor& executor_;
+    std::size_t depth_;
+    std::vector<std::unique_ptr<ChannelBase>> channels_;
+    std::vector<std::unique_ptr<StageState>> stages_;
+    // 运行中的工作协程数，加上 sink() 添加前构建者持有的 1
+    std::atomic<std::size_t> running_{1};
+    bool sealed_ = false;
+    Channel<bool> finished_{1};
+};
+} // namespace core
@@ -0,0 +1,13 @@
+#include "deadline.h"
+#include <asio/post.hpp>
+#include <asio/use_awaitable.hpp>
+
+namespace core::timer {
+
+asio::awaitable<void> DeadlineGuard::settle() {
+    // 到期回调已在执行器队列中，让出执行器直到它执行完
+    while (!fired_) {
+        co_await asio::post(executor_, asio::use_awaitable);
+    }
+}
+} // namespace core::timer
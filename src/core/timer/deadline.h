@@ -0,0 +1,101 @@
+#pragma once
+
+#include "core/timer/timer_wheel.h"
+#include <algorithm>
+#include <asio/any_io_executor.hpp>
+#include <asio/awaitable.hpp>
+#include <asio/cancellation_signal.hpp>
+#include <asio/error_code.hpp>
+#include <chrono>
+#include <optional>
+
+namespace core::timer {
+
+// 截止时间。默认构造表示未设置；嵌套操作用 earliest() 与外层的截止时间合并，
+// 这样会话级的截止时间会约束其中的每一次收发
+class Deadline {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    Deadline() = default;
+    explicit Deadline(Clock::time_point at)
+        : at_(at) {}
+
+    static Deadline after(Clock::duration timeout) { return Deadline(Clock::now() + timeout); }
+
+    bool is_set() const { return at_ != Clock::time_point::max(); }
+    bool expired() const { return is_set() && Clock::now() >= at_; }
+    Clock::time_point time_point() const { return at_; }
+    // 未设置时返回 duration::max()，已过期时返回 0
+    Clock::duration remaining() const {
+        if (!is_set()) {
+            return Clock::duration::max();
+        }
+        return std::max(at_ - Clock::now(), Clock::duration::zero());
+    }
+
+    Deadline earliest(Deadline other) const { return Deadline(std::min(at_, other.at_)); }
+
+  private:
+    Clock::time_point at_ = Clock::time_point::max();
+};
+
+// 给单个异步操作加截止时间，用法：
+//     DeadlineGuard guard(executor, deadline);
+//     co_await socket.async_send(..., asio::bind_cancellation_slot(
+//         guard.slot(), asio::redirect_error(asio::use_awaitable, ec)));
+//     if (guard.finish()) co_await guard.settle();
+//     if (guard.timed_out()) ...
+// 到期时向绑定的取消槽发出 terminal 取消，只有这一个操作以 operation_aborted 结束，
+// 同一 socket 上的其他操作（例如会话的接收循环）不受影响。
+// 与 spawn_with_timeout 不同，不需要额外的协程帧和 variant，定时器在时间轮上，
+// 未设置截止时间时不创建定时器，slot() 返回未连接的槽。
+// executor 应与操作所在的串行执行器相同
+class DeadlineGuard {
+  public:
+    DeadlineGuard(const asio::any_io_executor& executor, Deadline deadline)
+        : executor_(executor) {
+        if (!deadline.is_set()) {
+            return;
+        }
+        timer_.emplace(executor);
+        timer_->expires_at(deadline.time_point());
+        // 被取消时 guard 可能已经销毁，只有正常到期才访问 this
+        timer_->async_wait([this](const asio::error_code& ec) {
+            if (ec) {
+                return;
+            }
+            fired_ = true;
+            if (!finished_) {
+                timed_out_ = true;
+                signal_.emit(asio::cancellation_type::terminal);
+            }
+        });
+    }
+
+    DeadlineGuard(const DeadlineGuard&) = delete;
+    DeadlineGuard& operator=(const DeadlineGuard&) = delete;
+
+    // 操作完成后调用。返回 true 表示到期回调已投递但还没执行，
+    // 此时必须 co_await settle() 之后才能销毁 guard
+    bool finish() {
+        finished_ = true;
+        return timer_.has_value() && timer_->cancel() == 0 && !fired_;
+    }
+    asio::awaitable<void> settle();
+
+    // 绑定到被限时的那一个操作上
+    asio::cancellation_slot slot() {
+        return timer_.has_value() ? signal_.slot() : asio::cancellation_slot();
+    }
+    bool timed_out() const { return timed_out_; }
+
+  private:
+    asio::any_io_executor executor_;
+    asio::cancellation_signal signal_;
+    std::optional<WheelTimer> timer_;
+    bool finished_ = false;
+    bool fired_ = false;
+    bool timed_out_ = false;
+};
+} // namespace core::timer
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <asio/awaitable.hpp>
+#include <asio/dispatch.hpp>
+#include <asio/error_code.hpp>
+#include <asio/redirect_error.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/use_awaitable.hpp>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <random>
+#include <type_traits>
+
+namespace core::timer {
+
+// 周期任务。整个生命周期复用一个定时器，按绝对时刻 start + n * period 调度，
+// 任务本身的耗时不会累积成漂移；任务耗时超过一个周期时跳过错过的时刻而不是连续补跑。
+// jitter 非零时每个时刻在 [0, jitter) 内随机推迟（不累积），避免多台设备的心跳同时到达。
+// task 可以是普通函数，也可以返回 awaitable；普通函数不会为每个周期创建协程帧。
+// Timer 默认为 asio::steady_timer，也可以是 core::timer::WheelTimer。
+// Periodic 必须比 run() 活得更久
+template<typename Timer = asio::steady_timer>
+class Periodic {
+  public:
+    using clock_type = typename Timer::clock_type;
+    using duration = typename clock_type::duration;
+
+    // executor 通常是任务所在的 strand，任务与定时器回调都在其上执行
+    template<typename Executor>
+    Periodic(const Executor& executor, duration period, duration jitter = duration::zero())
+        : timer_(executor)
+        , period_(period > duration::zero() ? period : duration(1))
+        , jitter_(jitter)
+        , random_(std::random_device{}()) {}
+
+    Periodic(const Periodic&) = delete;
+    Periodic& operator=(const Periodic&) = delete;
+
+    // 每个周期执行一次 task，直到 cancel()。immediate 为 true 时立即执行第一次，
+    // 否则在一个周期之后
+    template<typename Task>
+    asio::awaitable<void> run(Task task, bool immediate = false) {
+        const auto generation = generation_.load();
+        auto next = clock_type::now() + (immediate ? duration::zero() : period_);
+        while (generation_.load() == generation) {
+            timer_.expires_at(next + random_jitter());
+            asio::error_code ec;
+            co_await timer_.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+            if (generation_.load() != generation) {
+                break;
+            }
+            if (ec) {
+                // 取消的是上一轮 run 遗留的等待，重新等待同一时刻
+                continue;
+            }
+
+            if constexpr (std::is_void_v<std::invoke_result_t<Task&>>) {
+                task();
+            } else {
+                co_await task();
+            }
+
+            next += period_;
+            if (const auto now = clock_type::now(); next <= now) {
+                next += period_ * ((now - next) / period_ + 1);
+            }
+        }
+    }
+
+    // 停止正在进行的 run()，可在任意线程调用。之后可以再次 run()
+    void cancel() {
+        generation_.fetch_add(1);
+        asio::dispatch(timer_.get_executor(), [this]() { timer_.cancel(); });
+    }
+
+  private:
+    duration random_jitter() {
+        if (jitter_ <= duration::zero()) {
+            return duration::zero();
+        }
+        std::uniform_int_distribution<typename duration::rep> distribution(0, jitter_.count() - 1);
+        return duration(distribution(random_));
+    }
+
+    Timer timer_;
+    const duration period_;
+    const duration jitter_;
+    std::minstd_rand random_;
+    std::atomic<std::uint64_t> generation_{0};
+};
+} // namespace core::timer
@@ -9,11 +9,11 @@
 #include <chrono>
 namespace core::timer {
 
-template<typename Callable>
+// Timer 默认为 asio::steady_timer；大量同时存在的短超时可改用 core::timer::WheelTimer
+template<typename Timer = asio::steady_timer, typename Callable>
     requires std::invocable<Callable>
 inline asio::awaitable<void> spawn_after_delay(Callable&& callable, int delay_ms) {
-    asio::steady_timer timer(co_await asio::this_coro::executor,
-                             std::chrono::milliseconds(delay_ms));
+    Timer timer(co_await asio::this_coro::executor, std::chrono::milliseconds(delay_ms));
     asio::error_code ec;
     co_await timer.async_wait(asio::redirect_error(asio::use_awaitable, ec));
     if (!ec) {
@@ -21,11 +21,10 @@ inline asio::awaitable<void> spawn_after_delay(Callable&& callable, int delay_ms
     }
 }
 
-template<typename Awaitable>
+template<typename Timer = asio::steady_timer, typename Awaitable>
     requires(!std::invocable<Awaitable>)
 inline asio::awaitable<void> spawn_after_delay(Awaitable&& awaitable, int delay_ms) {
-    asio::steady_timer timer(co_await asio::this_coro::executor,
-                             std::chrono::milliseconds(delay_ms));
+    Timer timer(co_await asio::this_coro::executor, std::chrono::milliseconds(delay_ms));
     asio::error_code ec;
     co_await timer.async_wait(asio::redirect_error(asio::use_awaitable, ec));
     if (!ec) {
@@ -8,10 +8,10 @@
 #include <asio/use_awaitable.hpp>
 namespace core::timer {
 
-template<typename Callable>
+template<typename Timer = asio::steady_timer, typename Callable>
     requires std::invocable<Callable>
 inline asio::awaitable<void> spawn_at(Callable&& callable, auto& timestamp) {
-    asio::steady_timer timer(co_await asio::this_coro::executor);
+    Timer timer(co_await asio::this_coro::executor);
     timer.expires_at(timestamp);
     asio::error_code ec;
     co_await timer.async_wait(asio::redirect_error(asio::use_awaitable, ec));
@@ -20,10 +20,10 @@ inline asio::awaitable<void> spawn_at(Callable&& callable, auto& timestamp) {
     }
 }
 
-template<typename Awaitable>
+template<typename Timer = asio::steady_timer, typename Awaitable>
     requires(!std::invocable<Awaitable>)
 inline asio::awaitable<void> spawn_at(Awaitable&& awaitable, auto& timestamp) {
-    asio::steady_timer timer(co_await asio::this_coro::executor);
+    Timer timer(co_await asio::this_coro::executor);
     timer.expires_at(timestamp);
     asio::error_code ec;
     co_await timer.async_wait(asio::redirect_error(asio::use_awaitable, ec));
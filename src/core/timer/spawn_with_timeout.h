@@ -15,15 +15,17 @@ namespace core::timer {
 
 using namespace asio::experimental::awaitable_operators;
 
+// 与任意 awaitable 竞争的通用超时，每次调用多出两个协程帧、一个定时器和一个 variant。
+// 只是给 socket 的单次收发加超时时用 DeadlineGuard（core/timer/deadline.h）
 // Primary template for non-void return types
-template<typename Awaitable>
+template<typename Timer = asio::steady_timer, typename Awaitable>
     requires(!std::is_void_v<typename Awaitable::value_type>)
 inline auto spawn_with_timeout(Awaitable awaitable_task, std::chrono::steady_clock::duration timeout)
     -> asio::awaitable<std::optional<typename Awaitable::value_type>> {
     using T = typename Awaitable::value_type;
 
     auto timeout_impl = [timeout]() -> asio::awaitable<std::optional<T>> {
-        asio::steady_timer timer(co_await asio::this_coro::executor);
+        Timer timer(co_await asio::this_coro::executor);
         timer.expires_after(timeout);
         asio::error_code ec;
         co_await timer.async_wait(asio::redirect_error(asio::use_awaitable, ec));
@@ -40,12 +42,12 @@ inline auto spawn_with_timeout(Awaitable awaitable_task, std::chrono::steady_clo
 }
 
 // Specialization for void return type - returns bool (true = success, false = timeout)
-template<typename Awaitable>
+template<typename Timer = asio::steady_timer, typename Awaitable>
     requires(std::is_void_v<typename Awaitable::value_type>)
 inline auto spawn_with_timeout(Awaitable awaitable_task, std::chrono::steady_clock::duration timeout)
     -> asio::awaitable<bool> {
     auto timeout_impl = [timeout]() -> asio::awaitable<bool> {
-        asio::steady_timer timer(co_await asio::this_coro::executor);
+        Timer timer(co_await asio::this_coro::executor);
         timer.expires_after(timeout);
         asio::error_code ec;
         co_await timer.async_wait(asio::redirect_error(asio::use_awaitable, ec));
@@ -0,0 +1,279 @@
+#include "timer_wheel.h"
+#include <algorithm>
+#include <bit>
+#include <functional>
+
+namespace core::timer {
+asio::execution_context::id TimerWheel::id;
+
+namespace {
+// 第 level 层（从 1 开始）的槽宽对应的位移
+constexpr unsigned upper_shift(std::size_t level) {
+    return 8 + 6 * static_cast<unsigned>(level - 1);
+}
+} // namespace
+
+TimerWheel::TimerWheel(asio::execution_context& context, Clock::duration tick)
+    : asio::execution_context::service(context)
+    , tick_(tick > Clock::duration::zero() ? tick : kDefaultTick)
+    , origin_(Clock::now())
+    , driver_(static_cast<asio::io_context&>(context)) {}
+
+TimerWheel::~TimerWheel() = default;
+
+std::size_t TimerWheel::size() const {
+    std::lock_guard lock(mutex_);
+    return count_;
+}
+
+void TimerWheel::shutdown() {
+    // 与 asio 的定时器一致，io_context 关闭时未完成的等待直接销毁，不调用处理函数
+    std::lock_guard lock(mutex_);
+    auto drop = [](Entry*& head) {
+        while (auto* entry = head) {
+            head = entry->next;
+            entry->prev = entry->next = nullptr;
+            entry->slot = nullptr;
+            entry->linked = false;
+            entry->reset_waiter();
+        }
+    };
+    std::for_each(level0_.begin(), level0_.end(), drop);
+    for (auto& level : upper_) {
+        std::for_each(level.begin(), level.end(), drop);
+    }
+    occupied_.fill(0);
+    count_ = 0;
+    driver_.cancel();
+}
+
+std::uint64_t TimerWheel::to_tick(Clock::time_point time, bool round_up) const {
+    if (time <= origin_) {
+        return 0;
+    }
+    const auto elapsed = time - origin_;
+    auto ticks = static_cast<std::uint64_t>(elapsed / tick_);
+    if (round_up && elapsed % tick_ != Clock::duration::zero()) {
+        ++ticks;
+    }
+    return ticks;
+}
+
+TimerWheel::Entry*& TimerWheel::slot_of(std::size_t level, std::uint64_t deadline) {
+    if (level == 0) {
+        return level0_[deadline & (kLevel0Slots - 1)];
+    }
+    return upper_[level - 1][(deadline >> upper_shift(level)) & (kLevelSlots - 1)];
+}
+
+void TimerWheel::insert(Entry& entry) {
+    const auto delta = entry.deadline - current_;
+    std::size_t level = 0;
+    while (level < kLevels - 1 && delta >= (std::uint64_t{1} << upper_shift(level + 1))) {
+        ++level;
+    }
+
+    Entry** slot = nullptr;
+    if (level == kLevels - 1
+        && delta >= (std::uint64_t{1} << (upper_shift(level) + kLevelBits))) {
+        // 超出最高层一圈的定时器放在最后才会下放的槽，下放时重新计算位置
+        const auto last = (current_ >> upper_shift(level)) + kLevelSlots - 1;
+        slot = &upper_[level - 1][last & (kLevelSlots - 1)];
+    } else {
+        slot = &slot_of(level, entry.deadline);
+    }
+
+    entry.prev = nullptr;
+    entry.next = *slot;
+    if (*slot != nullptr) {
+        (*slot)->prev = &entry;
+    }
+    *slot = &entry;
+    entry.slot = slot;
+    entry.linked = true;
+    update_occupied(slot);
+}
+
+void TimerWheel::unlink(Entry& entry) {
+    if (entry.prev != nullptr) {
+        entry.prev->next = entry.next;
+    } else {
+        *entry.slot = entry.next;
+    }
+    if (entry.next != nullptr) {
+        entry.next->prev = entry.prev;
+    }
+    update_occupied(entry.slot);
+    entry.prev = entry.next = nullptr;
+    entry.slot = nullptr;
+    entry.linked = false;
+}
+
+void TimerWheel::update_occupied(Entry** slot) {
+    const std::less<Entry**> before;
+    if (before(slot, level0_.data()) || !before(slot, level0_.data() + kLevel0Slots)) {
+        return;
+    }
+    const auto index = static_cast<std::size_t>(slot - level0_.data());
+    const auto bit = std::uint64_t{1} << (index % 64);
+    if (*slot != nullptr) {
+        occupied_[index / 64] |= bit;
+    } else {
+        occupied_[index / 64] &= ~bit;
+    }
+}
+
+void TimerWheel::schedule(Entry& entry, Clock::time_point expiry) {
+    std::lock_guard lock(mutex_);
+    if (count_ == 0) {
+        // 空闲期间不推进，重新开始时直接对齐到当前时间
+        current_ = std::max(current_, to_tick(Clock::now(), false));
+    }
+
+    const auto deadline = to_tick(expiry, true);
+    if (deadline <= current_) {
+        entry.complete({});
+        return;
+    }
+    entry.deadline = deadline;
+    insert(entry);
+    ++count_;
+    arm_driver();
+}
+
+std::size_t TimerWheel::cancel(Entry& entry) {
+    std::lock_guard lock(mutex_);
+    if (!entry.linked) {
+        return 0;
+    }
+    unlink(entry);
+    --count_;
+    entry.complete(asio::error::operation_aborted);
+    // 还有定时器时驱动保持不变，提前唤醒也只是推进指针；全部取消后停止驱动，
+    // 不再占用 io_context 的未完成工作
+    if (count_ == 0 && driver_armed_) {
+        driver_armed_ = false;
+        ++driver_generation_;
+        driver_.cancel();
+    }
+    return 1;
+}
+
+void TimerWheel::cascade(std::size_t level) {
+    auto& slot = slot_of(level, current_);
+    auto* entry = std::exchange(slot, nullptr);
+    while (entry != nullptr) {
+        auto* next = entry->next;
+        insert(*entry);
+        entry = next;
+    }
+}
+
+std::uint64_t TimerWheel::next_event_tick() const {
+    const auto index = current_ & (kLevel0Slots - 1);
+    const auto base = current_ - index;
+    // 在本圈剩余的槽中找下一个非空槽，找不到时在转完一圈（需要下放上层）时唤醒
+    for (auto next = index + 1; next < kLevel0Slots;) {
+        const auto word = occupied_[next / 64] >> (next % 64);
+        if (word != 0) {
+            return base + next + static_cast<std::uint64_t>(std::countr_zero(word));
+        }
+        next = (next / 64 + 1) * 64;
+    }
+    return base + kLevel0Slots;
+}
+
+void TimerWheel::advance(std::uint64_t target) {
+    while (current_ < target && count_ > 0) {
+        const auto next = next_event_tick();
+        if (next > target) {
+            current_ = target;
+            return;
+        }
+        current_ = next;
+
+        const auto index = current_ & (kLevel0Slots - 1);
+        if (index == 0) {
+            // 从高层到低层下放，高层下放到本层当前槽的定时器不会被漏掉
+            std::size_t top = 1;
+            while (top < kLevels - 1 && ((current_ >> upper_shift(top)) & (kLevelSlots - 1)) == 0) {
+                ++top;
+            }
+            for (auto level = top; level >= 1; --level) {
+                cascade(level);
+            }
+        }
+
+        occupied_[index / 64] &= ~(std::uint64_t{1} << (index % 64));
+        auto* entry = std::exchange(level0_[index], nullptr);
+        while (entry != nullptr) {
+            auto* next_entry = entry->next;
+            entry->prev = entry->next = nullptr;
+            entry->slot = nullptr;
+            entry->linked = false;
+            --count_;
+            entry->complete({});
+            entry = next_entry;
+        }
+    }
+    current_ = std::max(current_, target);
+}
+
+void TimerWheel::arm_driver() {
+    if (count_ == 0) {
+        return;
+    }
+    const auto next = next_event_tick();
+    if (driver_armed_ && driver_tick_ <= next) {
+        return;
+    }
+    driver_armed_ = true;
+    driver_tick_ = next;
+    const auto generation = ++driver_generation_;
+    driver_.expires_at(origin_ + tick_ * static_cast<Clock::rep>(next));
+    driver_.async_wait([this, generation](const asio::error_code& ec) {
+        if (!ec) {
+            on_driver(generation);
+        }
+    });
+}
+
+void TimerWheel::on_driver(std::uint64_t generation) {
+    std::lock_guard lock(mutex_);
+    if (generation != driver_generation_) {
+        return;
+    }
+    driver_armed_ = false;
+    advance(to_tick(Clock::now(), false));
+    arm_driver();
+}
+
+WheelTimer::WheelTimer(const executor_type& executor)
+    : executor_(executor)
+    , service_(asio::use_service<TimerWheel>(
+          asio::query(executor, asio::execution::context_as<asio::execution_context&>)))
+    , expiry_(clock_type::now()) {}
+
+WheelTimer::WheelTimer(const executor_type& executor, duration expiry_time)
+    : WheelTimer(executor) {
+    expiry_ = clock_type::now() + expiry_time;
+}
+
+WheelTimer::~WheelTimer() {
+    service_.cancel(entry_);
+}
+
+std::size_t WheelTimer::expires_at(time_point expiry_time) {
+    const auto cancelled = service_.cancel(entry_);
+    expiry_ = expiry_time;
+    return cancelled;
+}
+
+std::size_t WheelTimer::expires_after(duration expiry_time) {
+    return expires_at(clock_type::now() + expiry_time);
+}
+
+std::size_t WheelTimer::cancel() {
+    return service_.cancel(entry_);
+}
+} // namespace core::timer
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <array>
+#include <asio/any_io_executor.hpp>
+#include <asio/associated_cancellation_slot.hpp>
+#include <asio/associated_executor.hpp>
+#include <asio/async_result.hpp>
+#include <asio/cancellation_type.hpp>
+#include <asio/error.hpp>
+#include <asio/error_code.hpp>
+#include <asio/execution_context.hpp>
+#include <asio/io_context.hpp>
+#include <asio/post.hpp>
+#include <asio/steady_timer.hpp>
+#include <chrono>
+#include <cstddef>
+#include <new>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace core::timer {
+
+// 分层时间轮，作为 io_context 的服务存在，每个 io_context 一个（不支持其他执行上下文）。
+// 定时器的插入与取消都是 O(1)：第 0 层 256 个槽，每槽一个 tick；其上三层各 64 个槽，
+// 每层的槽宽是下一层一整圈。指针转过一圈时把上一层对应槽中的定时器重新分配到下层。
+// 只用一个 asio::steady_timer 驱动，且只在有定时器时运行：下一个非空槽到期或需要
+// 下放上层定时器时唤醒，长时间的超时不会每个 tick 都唤醒一次。
+// 精度为一个 tick，到期回调不会早于设定时间。
+class TimerWheel : public asio::execution_context::service {
+  public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr Clock::duration kDefaultTick = std::chrono::milliseconds(1);
+
+    static asio::execution_context::id id;
+
+    // 需指定 tick 时在首次使用前调用 asio::make_service<TimerWheel>(io_context, tick)
+    explicit TimerWheel(asio::execution_context& context, Clock::duration tick = kDefaultTick);
+    ~TimerWheel() override;
+
+    Clock::duration tick() const { return tick_; }
+    // 当前挂在时间轮上的定时器数量
+    std::size_t size() const;
+
+    // 等待者，保存一个异步等待的完成处理函数。complete() 只投递处理函数，不会在调用处执行，
+    // 因此可以在持锁时调用
+    struct Waiter {
+        virtual ~Waiter() = default;
+        virtual void complete(const asio::error_code& ec) = 0;
+    };
+
+    // 侵入式链表节点，由 WheelTimer 持有。等待者通常直接构造在 storage 中，
+    // 放不下时才分配，arm 与 cancel 都不访问堆
+    struct Entry {
+        static constexpr std::size_t kInlineWaiterSize = 128;
+
+        Entry() = default;
+        Entry(const Entry&) = delete;
+        Entry& operator=(const Entry&) = delete;
+        ~Entry() { reset_waiter(); }
+
+        template<typename W, typename... Args>
+        void emplace_waiter(Args&&... args) {
+            reset_waiter();
+            if constexpr (sizeof(W) <= kInlineWaiterSize
+                          && alignof(W) <= alignof(std::max_align_t)) {
+                waiter = new (storage) W(std::forward<Args>(args)...);
+            } else {
+                waiter = new W(std::forward<Args>(args)...);
+            }
+        }
+        void reset_waiter() {
+            if (waiter == nullptr) {
+                return;
+            }
+            if (static_cast<void*>(waiter) == static_cast<void*>(storage)) {
+                waiter->~Waiter();
+            } else {
+                delete waiter;
+            }
+            waiter = nullptr;
+        }
+        // 投递处理函数并销毁等待者
+        void complete(const asio::error_code& ec) {
+            waiter->complete(ec);
+            reset_waiter();
+        }
+
+        Entry* prev = nullptr;
+        Entry* next = nullptr;
+        Entry** slot = nullptr;     // 所在槽的表头
+        std::uint64_t deadline = 0; // 到期的 tick
+        Waiter* waiter = nullptr;
+        bool linked = false;
+        alignas(std::max_align_t) std::byte storage[kInlineWaiterSize];
+    };
+
+    // 把带有等待者的 entry 挂到 expiry 对应的槽上，已到期的直接完成。
+    // entry 上不能有未完成的等待，调用前先 cancel
+    void schedule(Entry& entry, Clock::time_point expiry);
+    // 取消 entry 上的等待，返回被取消的等待数
+    std::size_t cancel(Entry& entry);
+
+  private:
+    static constexpr std::size_t kLevels = 4;
+    static constexpr unsigned kLevel0Bits = 8;
+    static constexpr unsigned kLevelBits = 6;
+    static constexpr std::size_t kLevel0Slots = std::size_t{1} << kLevel0Bits;
+    static constexpr std::size_t kLevelSlots = std::size_t{1} << kLevelBits;
+
+    void shutdown() override;
+
+    // round_up 为 true 时向上取整，保证到期不早于 time
+    std::uint64_t to_tick(Clock::time_point time, bool round_up) const;
+
+    void insert(Entry& entry);
+    void unlink(Entry& entry);
+    Entry*& slot_of(std::size_t level, std::uint64_t deadline);
+    void update_occupied(Entry** slot);
+
+    // 推进到 target，完成其间到期的等待
+    void advance(std::uint64_t target);
+    void cascade(std::size_t level);
+    std::uint64_t next_event_tick() const;
+    void arm_driver();
+    void on_driver(std::uint64_t generation);
+
+    const Clock::duration tick_;
+    const Clock::time_point origin_;
+
+    mutable std::mutex mutex_;
+    std::uint64_t current_ = 0;
+    std::size_t count_ = 0;
+    // 每个槽是一条侵入式双向链表的表头
+    std::array<Entry*, kLevel0Slots> level0_{};
+    std::array<std::array<Entry*, kLevelSlots>, kLevels - 1> upper_{};
+    // 第 0 层槽的占用位图，用于跳到下一个非空槽
+    std::array<std::uint64_t, kLevel0Slots / 64> occupied_{};
+
+    asio::steady_timer driver_;
+    bool driver_armed_ = false;
+    std::uint64_t driver_tick_ = 0;
+    std::uint64_t driver_generation_ = 0;
+};
+
+// 运行在 TimerWheel 上的定时器，接口与 asio::steady_timer 的常用部分一致，
+// 可以作为 spawn_after_delay 等模板的 Timer 参数。
+// 每个定时器同一时间只有一个等待，再次 async_wait 会以 operation_aborted 结束上一个。
+// 支持处理函数关联的取消槽（例如 awaitable 运算符 ||），取消时等待立即从时间轮上摘下
+class WheelTimer {
+  public:
+    using clock_type = TimerWheel::Clock;
+    using duration = clock_type::duration;
+    using time_point = clock_type::time_point;
+    using executor_type = asio::any_io_executor;
+
+    // executor 必须来自某个 io_context（可以是其上的 strand），
+    // 例如 co_await asio::this_coro::executor
+    explicit WheelTimer(const executor_type& executor);
+    WheelTimer(const executor_type& executor, duration expiry_time);
+    ~WheelTimer();
+
+    WheelTimer(const WheelTimer&) = delete;
+    WheelTimer& operator=(const WheelTimer&) = delete;
+
+    const executor_type& get_executor() const { return executor_; }
+    time_point expiry() const { return expiry_; }
+
+    // 与 asio 一致：修改到期时间会取消正在进行的等待，返回取消的数量
+    std::size_t expires_at(time_point expiry_time);
+    std::size_t expires_after(duration expiry_time);
+    std::size_t cancel();
+
+    template<typename WaitToken>
+    auto async_wait(WaitToken&& token) {
+        return asio::async_initiate<WaitToken, void(asio::error_code)>(
+            [this](auto handler) {
+                service_.cancel(entry_);
+                auto slot = asio::get_associated_cancellation_slot(handler);
+                if (slot.is_connected()) {
+                    // 在等待完成前取消；槽在处理函数执行前清除
+                    slot.assign([this](asio::cancellation_type) { service_.cancel(entry_); });
+                }
+                entry_.emplace_waiter<HandlerWaiter<decltype(handler)>>(std::move(handler),
+                                                                        executor_);
+                service_.schedule(entry_, expiry_);
+            },
+            token);
+    }
+
+  private:
+    template<typename Handler>
+    struct HandlerWaiter final : TimerWheel::Waiter {
+        HandlerWaiter(Handler&& handler, const executor_type& executor)
+            : handler_(std::move(handler))
+            , executor_(asio::get_associated_executor(handler_, executor)) {}
+
+        void complete(const asio::error_code& ec) override {
+            auto function = [handler = std::move(handler_), ec]() mutable {
+                asio::get_associated_cancellation_slot(handler).clear();
+                std::move(handler)(ec);
+            };
+            // 处理函数位于 io_context 本身（非 strand）时直接投递，省去 any_io_executor 的类型擦除
+            if constexpr (std::is_same_v<Executor, asio::any_io_executor>) {
+                using IoExecutor = asio::io_context::executor_type;
+                if (auto* io_executor = executor_.template target<IoExecutor>()) {
+                    asio::post(*io_executor, std::move(function));
+                    return;
+                }
+            }
+            asio::post(executor_, std::move(function));
+        }
+
+        using Executor = asio::associated_executor_t<Handler, executor_type>;
+
+        Handler handler_;
+        Executor executor_;
+    };
+
+    executor_type executor_;
+    TimerWheel& service_;
+    time_point expiry_;
+    TimerWheel::Entry entry_;
+};
+} // namespace core::timer
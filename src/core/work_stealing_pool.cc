@@ -0,0 +1,125 @@
+#include "work_stealing_pool.h"
+#include <spdlog/spdlog.h>
+
+namespace core {
+namespace {
+// 当前线程所属的线程池与队列编号，用于把线程内提交的任务放回本地队列
+thread_local const WorkStealingPool* current_pool = nullptr;
+thread_local std::size_t current_index = 0;
+} // namespace
+
+WorkStealingPool::WorkStealingPool(std::size_t thread_count) {
+    const auto count = thread_count > 0 ? thread_count : 1;
+    workers_.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    threads_.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        threads_.emplace_back([this, i]() { run_worker(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    stop();
+}
+
+void WorkStealingPool::stop() {
+    if (stopping_.exchange(true)) {
+        return;
+    }
+    {
+        std::lock_guard lock(sleep_mutex_);
+    }
+    wakeup_.notify_all();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads_.clear();
+    for (auto& worker : workers_) {
+        std::lock_guard lock(worker->mutex);
+        worker->tasks.clear();
+    }
+    pending_.store(0);
+}
+
+void WorkStealingPool::push(TaskPtr task) {
+    if (stopping_.load(std::memory_order_relaxed)) {
+        spdlog::warn("[WorkStealingPool::push] Pool is stopped, task dropped");
+        return;
+    }
+
+    const auto index = current_pool == this
+                           ? current_index
+                           : next_worker_.fetch_add(1, std::memory_order_relaxed)
+                                 % workers_.size();
+    {
+        auto& worker = *workers_[index];
+        std::lock_guard lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+
+    // 先增加 pending_ 再检查 sleepers_，与 run_worker 中相反的顺序保证唤醒不会丢失
+    pending_.fetch_add(1);
+    if (sleepers_.load() > 0) {
+        {
+            std::lock_guard lock(sleep_mutex_);
+        }
+        wakeup_.notify_one();
+    }
+}
+
+WorkStealingPool::TaskPtr WorkStealingPool::take(std::size_t index) {
+    {
+        auto& own = *workers_[index];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty()) {
+            auto task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return task;
+        }
+    }
+
+    // 本地队列为空，从其他队列的头部窃取最早提交的任务
+    for (std::size_t offset = 1; offset < workers_.size(); ++offset) {
+        auto& victim = *workers_[(index + offset) % workers_.size()];
+        std::lock_guard lock(victim.mutex);
+        if (victim.tasks.empty()) {
+            continue;
+        }
+        auto task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return task;
+    }
+    return nullptr;
+}
+
+void WorkStealingPool::run_worker(std::size_t index) {
+    current_pool = this;
+    current_index = index;
+
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        if (auto task = take(index)) {
+            pending_.fetch_sub(1);
+            // 异常不能离开工作线程，否则整个进程终止；offload 的任务自己捕获并传回调用方
+            try {
+                task->run();
+            } catch (const std::exception& e) {
+                spdlog::error("[WorkStealingPool::run_worker] Task threw: {}", e.what());
+            } catch (...) {
+                spdlog::error("[WorkStealingPool::run_worker] Task threw an unknown exception");
+            }
+            continue;
+        }
+
+        std::unique_lock lock(sleep_mutex_);
+        sleepers_.fetch_add(1);
+        wakeup_.wait(lock, [this]() { return stopping_.load() || pending_.load() > 0; });
+        sleepers_.fetch_sub(1);
+    }
+
+    current_pool = nullptr;
+}
+} // namespace core
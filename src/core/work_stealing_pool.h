@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace core {
+// 计算密集任务使用的工作窃取线程池。
+// 每个工作线程有自己的任务队列：线程内提交的任务压入自己队列的尾部并按后进先出执行，
+// 外部线程提交的任务轮流分给各个队列；自己的队列为空时从其他队列头部窃取。
+// 任务之间没有顺序保证，需要串行的工作应使用 strand。
+class WorkStealingPool {
+  public:
+    explicit WorkStealingPool(std::size_t thread_count);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    template<typename Fn>
+        requires std::invocable<std::decay_t<Fn>&>
+    void submit(Fn&& fn) {
+        push(std::make_unique<TaskImpl<std::decay_t<Fn>>>(std::forward<Fn>(fn)));
+    }
+
+    // 停止并回收所有工作线程，尚未执行的任务被直接丢弃
+    void stop();
+
+    std::size_t get_thread_count() const { return workers_.size(); }
+    // 尚未开始执行的任务数
+    std::size_t get_pending() const { return pending_.load(std::memory_order_relaxed); }
+
+  private:
+    struct Task {
+        virtual ~Task() = default;
+        virtual void run() = 0;
+    };
+
+    template<typename Fn>
+    struct TaskImpl final : Task {
+        explicit TaskImpl(Fn&& fn)
+            : fn_(std::move(fn)) {}
+        explicit TaskImpl(const Fn& fn)
+            : fn_(fn) {}
+        void run() override { fn_(); }
+        Fn fn_;
+    };
+
+    using TaskPtr = std::unique_ptr<Task>;
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<TaskPtr> tasks;
+    };
+
+    void push(TaskPtr task);
+    TaskPtr take(std::size_t index);
+    void run_worker(std::size_t index);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+
+    // pending_ 为所有队列中的任务总数，空闲线程据此决定是否休眠
+    std::atomic<std::size_t> pending_{0};
+    std::atomic<std::size_t> sleepers_{0};
+    std::atomic<std::size_t> next_worker_{0};
+    std::atomic<bool> stopping_{false};
+    std::mutex sleep_mutex_;
+    std::condition_variable wakeup_;
+};
+} // namespace core
@@ -21,17 +21,17 @@ class DiscoveryHandler {
     OnlineListInspector online_list_inspector_;
 
     void start() {
-        executor_.spawn(heartbeat_.start());
+        executor_.spawn_on(heartbeat_.strand(), heartbeat_.start());
         online_list_inspector_.start();
     }
 
     void stop() {
-        executor_.spawn(heartbeat_.stop());
+        executor_.spawn_on(heartbeat_.strand(), heartbeat_.stop());
         online_list_inspector_.stop();
     }
 
     void restart() {
-        executor_.spawn(heartbeat_.restart());
+        executor_.spawn_on(heartbeat_.strand(), heartbeat_.restart());
         online_list_inspector_.restart();
     }
 
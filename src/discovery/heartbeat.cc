@@ -1,5 +1,4 @@
 #include "heartbeat.h"
-#include "core/timer/spawn_after_delay.h"
 #include "heartbeat.pb.h"
 #include "util/settings.h"
 #include <asio/ip/host_name.hpp>
@@ -25,21 +24,20 @@ asio::awaitable<void> Heartbeat::start() {
     std::string username = util::Settings::instance().get().value("username", "unknown");
     heartbeat_msg.set_username(username);
 
-    while (running_) {
+    // 按固定时刻发送，时间戳取发送时刻而不是上一轮等待开始的时刻
+    co_await ticker_.run([&]() {
         auto now = std::chrono::system_clock::now();
         auto timestamp_ms
             = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
         heartbeat_msg.set_timestamp_ms(timestamp_ms);
-
-        co_await core::timer::spawn_after_delay(sender_.send_message_to(heartbeat_msg),
-                                                interval_ms_);
-
-        spdlog::debug("Heartbeat sent: ip={}, timestamp={}", local_ip, timestamp_ms);
-    }
+        spdlog::debug("Heartbeat sending: ip={}, timestamp={}", local_ip, timestamp_ms);
+        return sender_.send_message_to(heartbeat_msg);
+    });
 }
 
 asio::awaitable<void> Heartbeat::stop() {
     running_.store(false);
+    ticker_.cancel();
     co_return;
 }
 
@@ -3,13 +3,16 @@
 #include "asio/awaitable.hpp"
 #include "core/executor.h"
 #include "core/net/io/udp_sender.h"
+#include "core/timer/periodic.h"
+#include <chrono>
 
 namespace discovery {
 class Heartbeat {
   public:
     explicit Heartbeat(core::Executor& executor, int interval_ms = 1000)
-        : interval_ms_(interval_ms)
-        , executor_(executor)
+        : executor_(executor)
+        , strand_(executor.make_strand())
+        , ticker_(strand_, std::chrono::milliseconds(interval_ms))
         , socket_(executor.get_io_context())
         , sender_(executor_, socket_) {}
     ~Heartbeat() = default;
@@ -21,10 +24,13 @@ class Heartbeat {
     asio::awaitable<void> stop();
     asio::awaitable<void> restart();
 
+    const core::IoStrand& strand() const { return strand_; }
+
   private:
-    int interval_ms_;
     std::atomic<bool> running_{false};
     core::Executor& executor_;
+    core::IoStrand strand_;
+    core::timer::Periodic<> ticker_;
     asio::ip::udp::socket socket_;
     core::net::io::UdpSender sender_;
 };
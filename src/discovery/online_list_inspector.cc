@@ -11,6 +11,8 @@ namespace discovery {
 
 OnlineListInspector::OnlineListInspector(core::Executor& executor)
     : executor_(executor)
+    , strand_(executor.make_strand())
+    , cleanup_ticker_(strand_, std::chrono::milliseconds(kCleanupIntervalMs))
     , socket_(executor.get_io_context())
     , receiver_(executor, socket_) {}
 
@@ -20,12 +22,13 @@ void OnlineListInspector::start() {
     }
 
     local_ip_ = get_local_ip();
-    executor_.spawn(inspect_loop());
-    executor_.spawn(cleanup_loop());
+    executor_.spawn_on(strand_, inspect_loop());
+    executor_.spawn_on(strand_, cleanup_loop());
 }
 
 void OnlineListInspector::stop() {
     running_.store(false);
+    cleanup_ticker_.cancel();
     socket_.close();
     std::lock_guard<std::mutex> lock(mutex_);
     online_list_.clear();
@@ -81,11 +84,7 @@ void OnlineListInspector::update_online_list(HeartbeatRequest&& msg) {
 }
 
 asio::awaitable<void> OnlineListInspector::cleanup_loop() {
-    while (running_.load()) {
-        asio::steady_timer timer(co_await asio::this_coro::executor,
-                                 std::chrono::milliseconds(kCleanupIntervalMs));
-        co_await timer.async_wait(asio::use_awaitable);
-
+    co_await cleanup_ticker_.run([this]() {
         auto now = std::chrono::steady_clock::now();
         std::lock_guard<std::mutex> lock(mutex_);
 
@@ -95,7 +94,7 @@ asio::awaitable<void> OnlineListInspector::cleanup_loop() {
                 entry.online = false;
             }
         }
-    }
+    });
 }
 
 asio::awaitable<void> OnlineListInspector::remove_user(std::string ip) {
@@ -4,6 +4,7 @@
 #include "asio/ip/udp.hpp"
 #include "core/executor.h"
 #include "core/net/io/udp_receiver.h"
+#include "core/timer/periodic.h"
 #include "heartbeat.pb.h"
 #include <map>
 #include <mutex>
@@ -51,6 +52,8 @@ class OnlineListInspector {
 
     std::map<std::string, UserEntry> online_list_;
     core::Executor& executor_;
+    core::IoStrand strand_; // inspect_loop 与 cleanup_loop 共用
+    core::timer::Periodic<> cleanup_ticker_;
     asio::ip::udp::socket socket_;
     core::net::io::UdpReceiver receiver_;
     std::atomic<bool> running_{false};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+
+namespace receiver {
+
+// 多会话接收服务的准入控制：限制并发会话数，以及所有会话已交给磁盘阶段但尚未落盘的分块字节总量。
+// 字节额度在会话间平分（每个会话最多 max_inflight_bytes / 当前会话数），
+// 一个会话无法挤占其他会话的磁盘与校验时间。手上没有在途分块的会话总能再接收一个分块，
+// 因此不会饿死，总量最多超出每个会话一个分块。
+// 线程安全；各监听的 accept 循环可能同时准入，会话数不会超过上限
+class Admission {
+  public:
+    Admission(std::size_t max_sessions, std::size_t max_inflight_bytes)
+        : max_sessions_(std::max<std::size_t>(max_sessions, 1))
+        , max_inflight_bytes_(max_inflight_bytes) {}
+
+    Admission(const Admission&) = delete;
+    Admission& operator=(const Admission&) = delete;
+
+    // 额度从饱和中释放（分块落盘或会话离开）时调用，用于唤醒暂停读取的会话。
+    // 必须在第一个会话准入之前设置
+    void set_release_handler(std::function<void()> handler) { on_release_ = std::move(handler); }
+
+    bool try_admit() {
+        auto sessions = sessions_.load();
+        do {
+            if (sessions >= max_sessions_) {
+                return false;
+            }
+        } while (!sessions_.compare_exchange_weak(sessions, sessions + 1));
+        return true;
+    }
+
+    void leave() {
+        sessions_.fetch_sub(1);
+        notify_release();
+    }
+
+    // 会话当前有 session_inflight 字节在途时，能否再接收一个分块。
+    // 返回 false 时记下有会话在等待，下一次释放额度时调用 release handler
+    bool can_take(std::size_t session_inflight) const {
+        if (session_inflight == 0 || has_room(session_inflight)) {
+            return true;
+        }
+        // 登记后再检查一次：与 give_back 交错时要么这里看到释放后的额度，要么 give_back 看到登记
+        blocked_.store(true);
+        return has_room(session_inflight);
+    }
+
+    void take(std::size_t bytes) { inflight_bytes_.fetch_add(bytes); }
+
+    void give_back(std::size_t bytes) {
+        inflight_bytes_.fetch_sub(bytes);
+        notify_release();
+    }
+
+    std::size_t sessions() const { return sessions_.load(); }
+    std::size_t inflight_bytes() const { return inflight_bytes_.load(); }
+    std::size_t max_sessions() const { return max_sessions_; }
+    std::size_t max_inflight_bytes() const { return max_inflight_bytes_; }
+
+  private:
+    bool has_room(std::size_t session_inflight) const {
+        const auto share = max_inflight_bytes_ / std::max<std::size_t>(sessions_.load(), 1);
+        return inflight_bytes_.load() < max_inflight_bytes_ && session_inflight < share;
+    }
+
+    void notify_release() {
+        if (blocked_.exchange(false) && on_release_) {
+            on_release_();
+        }
+    }
+
+    const std::size_t max_sessions_;
+    const std::size_t max_inflight_bytes_;
+    std::atomic<std::size_t> sessions_{0};
+    std::atomic<std::size_t> inflight_bytes_{0};
+    mutable std::atomic<bool> blocked_{false};
+    std::function<void()> on_release_;
+};
+} // namespace receiver
@@ -0,0 +1,214 @@
+#include "directory_cache.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <spdlog/spdlog.h>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace receiver {
+
+DirectoryCache::DirectoryCache(std::size_t capacity)
+    : capacity_(std::max<std::size_t>(capacity, 1)) {}
+
+bool DirectoryCache::create_all(std::vector<std::filesystem::path> directories,
+                                core::WorkStealingPool* pool) {
+    // 深度小的在前，同一深度内去重
+    const auto depth = [](const std::filesystem::path& path) {
+        return std::distance(path.begin(), path.end());
+    };
+    std::sort(directories.begin(), directories.end(), [&](const auto& a, const auto& b) {
+        const auto depth_a = depth(a);
+        const auto depth_b = depth(b);
+        return depth_a < depth_b || (depth_a == depth_b && a < b);
+    });
+    directories.erase(std::unique(directories.begin(), directories.end()), directories.end());
+
+    // 一层中的目录由调用线程与池中的辅助任务共同领取，调用线程只等待目录全部完成，
+    // 辅助任务来不及执行时由调用线程独自做完
+    struct Level {
+        std::vector<std::filesystem::path> directories;
+        std::atomic<std::size_t> next{0};
+        std::atomic<bool> ok{true};
+        std::size_t finished = 0;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    const auto run = [this](Level& level) {
+        std::size_t count = 0;
+        for (auto i = level.next.fetch_add(1); i < level.directories.size();
+             i = level.next.fetch_add(1)) {
+            if (!create(level.directories[i])) {
+                level.ok.store(false);
+            }
+            ++count;
+        }
+        std::lock_guard lock(level.mutex);
+        level.finished += count;
+        if (level.finished == level.directories.size()) {
+            level.done.notify_all();
+        }
+    };
+
+    bool ok = true;
+    for (auto begin = directories.begin(); begin != directories.end();) {
+        const auto level_depth = depth(*begin);
+        const auto end = std::find_if(begin, directories.end(), [&](const auto& path) {
+            return depth(path) != level_depth;
+        });
+        auto level = std::make_shared<Level>();
+        level->directories.assign(std::make_move_iterator(begin), std::make_move_iterator(end));
+        begin = end;
+
+        if (pool != nullptr) {
+            const auto helpers = std::min(level->directories.size(), pool->get_thread_count()) - 1;
+            for (std::size_t i = 0; i < helpers; ++i) {
+                pool->submit([level, run]() { run(*level); });
+            }
+        }
+        run(*level);
+        std::unique_lock lock(level->mutex);
+        level->done.wait(lock, [&]() { return level->finished == level->directories.size(); });
+        ok = ok && level->ok.load();
+    }
+    return ok;
+}
+
+#if defined(__linux__)
+DirectoryCache::Handle::~Handle() {
+    ::close(fd);
+}
+
+std::shared_ptr<DirectoryCache::Handle> DirectoryCache::handle(
+    const std::filesystem::path& directory) {
+    auto key = directory.string();
+    {
+        std::lock_guard lock(mutex_);
+        if (const auto it = handles_.find(key); it != handles_.end()) {
+            return it->second;
+        }
+    }
+
+    // 已存在的目录只需一次 open；不存在时先取得父目录，再相对它创建
+    int fd = ::open(directory.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0 && errno == ENOENT) {
+        const auto parent_path = directory.parent_path();
+        std::shared_ptr<Handle> parent;
+        if (!parent_path.empty() && parent_path != directory) {
+            parent = handle(parent_path);
+            if (!parent) {
+                return nullptr;
+            }
+        }
+        const int parent_fd = parent ? parent->fd : AT_FDCWD;
+        const auto name = directory.filename();
+        if (::mkdirat(parent_fd, name.c_str(), 0755) != 0 && errno != EEXIST) {
+            spdlog::error("[DirectoryCache::handle] Failed to create {}: {}",
+                          directory.string(),
+                          std::strerror(errno));
+            return nullptr;
+        }
+        fd = ::openat(parent_fd, name.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+    }
+    if (fd < 0) {
+        spdlog::error("[DirectoryCache::handle] Failed to open {}: {}",
+                      directory.string(),
+                      std::strerror(errno));
+        return nullptr;
+    }
+
+    auto result = std::make_shared<Handle>(fd);
+    std::lock_guard lock(mutex_);
+    if (handles_.size() >= capacity_) {
+        // 正在使用的描述符由调用方的 shared_ptr 保活
+        handles_.clear();
+    }
+    return handles_.emplace(std::move(key), std::move(result)).first->second;
+}
+
+void DirectoryCache::forget(const std::filesystem::path& directory) {
+    // 祖先目录可能一同被删除，重新创建时不能再经由它们的旧描述符
+    std::lock_guard lock(mutex_);
+    for (auto path = directory; !path.empty(); path = path.parent_path()) {
+        handles_.erase(path.string());
+        if (path == path.parent_path()) {
+            break;
+        }
+    }
+}
+
+bool DirectoryCache::create(const std::filesystem::path& directory) {
+    return handle(directory) != nullptr;
+}
+
+std::shared_ptr<OpenFile> DirectoryCache::open_file(const std::filesystem::path& path,
+                                                    bool create) {
+    const auto parent_path = path.parent_path();
+    const auto name = path.filename();
+    const int flags = O_WRONLY | O_CLOEXEC | (create ? O_CREAT | O_TRUNC : 0);
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        std::shared_ptr<Handle> parent;
+        if (!parent_path.empty()) {
+            parent = handle(parent_path);
+            if (!parent) {
+                return nullptr;
+            }
+        }
+        const int dir_fd = parent ? parent->fd : AT_FDCWD;
+        const auto& target = parent ? name : path;
+        const int fd = ::openat(dir_fd, target.c_str(), flags, 0644);
+        if (fd >= 0) {
+            return std::make_shared<OpenFile>(fd);
+        }
+        // 缓存的目录可能已被外部删除，丢弃后按路径重新取得一次
+        if (errno != ENOENT || !parent) {
+            break;
+        }
+        forget(parent_path);
+    }
+    spdlog::error("[DirectoryCache::open_file] Failed to open {}: {}",
+                  path.string(),
+                  std::strerror(errno));
+    return nullptr;
+}
+#else
+bool DirectoryCache::create(const std::filesystem::path& directory) {
+    auto key = directory.string();
+    {
+        std::lock_guard lock(mutex_);
+        if (existing_.contains(key)) {
+            return true;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) {
+        spdlog::error("[DirectoryCache::create] Failed to create {}: {}",
+                      directory.string(),
+                      ec.message());
+        return false;
+    }
+    std::lock_guard lock(mutex_);
+    if (existing_.size() >= capacity_) {
+        existing_.clear();
+    }
+    existing_.insert(std::move(key));
+    return true;
+}
+
+std::shared_ptr<OpenFile> DirectoryCache::open_file(const std::filesystem::path& path,
+                                                    bool create) {
+    const auto parent_path = path.parent_path();
+    if (create && !parent_path.empty() && !this->create(parent_path)) {
+        return nullptr;
+    }
+    return OpenFile::open(path, create);
+}
+#endif
+} // namespace receiver
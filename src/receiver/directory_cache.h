@@ -0,0 +1,62 @@
+#pragma once
+
+#include "core/work_stealing_pool.h"
+#include "file_handle_cache.h"
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if !defined(__linux__)
+#include <unordered_set>
+#endif
+
+namespace receiver {
+
+// 接收端的目录缓存：记住已经存在的目录。
+// Linux 上保留它们的 O_PATH 描述符，子目录以 mkdirat、文件以 openat 相对已缓存的父目录创建，
+// 同一目录下的大量文件不再各自解析完整路径、重复 stat 与 mkdir。
+// 缓存的目录超过 capacity 个时整体丢弃重建；缓存的目录被外部删除时按路径重新打开。线程安全
+class DirectoryCache {
+  public:
+    static constexpr std::size_t kDefaultCapacity = 1024;
+
+    explicit DirectoryCache(std::size_t capacity = kDefaultCapacity);
+
+    DirectoryCache(const DirectoryCache&) = delete;
+    DirectoryCache& operator=(const DirectoryCache&) = delete;
+
+    // 创建 directories 及其祖先，返回是否全部成功。按深度分层、父目录优先，
+    // 同一层的目录互不依赖，分给 pool 并行创建，调用线程也参与，池中线程被占满时不会卡住
+    bool create_all(std::vector<std::filesystem::path> directories,
+                    core::WorkStealingPool* pool = nullptr);
+    bool create(const std::filesystem::path& directory);
+
+    // 打开 path，create 时创建（父目录不存在时一并创建）并截断。失败时返回空
+    std::shared_ptr<OpenFile> open_file(const std::filesystem::path& path, bool create);
+
+  private:
+#if defined(__linux__)
+    struct Handle {
+        explicit Handle(int fd)
+            : fd(fd) {}
+        ~Handle();
+        int fd;
+    };
+
+    // 取得目录的描述符，不存在时逐级创建
+    std::shared_ptr<Handle> handle(const std::filesystem::path& directory);
+    // 丢弃 directory 及其祖先的缓存
+    void forget(const std::filesystem::path& directory);
+
+    std::unordered_map<std::string, std::shared_ptr<Handle>> handles_;
+#else
+    std::unordered_set<std::string> existing_;
+#endif
+    std::size_t capacity_;
+    std::mutex mutex_;
+};
+} // namespace receiver
@@ -0,0 +1,123 @@
+#include "file_handle_cache.h"
+#include "directory_cache.h"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace receiver {
+
+std::shared_ptr<OpenFile> OpenFile::open(const std::filesystem::path& path, bool create) {
+#if defined(__linux__)
+    const int flags = O_WRONLY | O_CLOEXEC | (create ? O_CREAT | O_TRUNC : 0);
+    const int fd = ::open(path.c_str(), flags, 0644);
+    if (fd < 0) {
+        spdlog::error(
+            "[OpenFile::open] Failed to open {}: {}", path.string(), std::strerror(errno));
+        return nullptr;
+    }
+    return std::make_shared<OpenFile>(fd);
+#else
+    const auto mode = std::ios::binary | std::ios::in | std::ios::out
+                      | (create ? std::ios::trunc : std::ios::openmode{});
+    std::fstream stream(path, mode);
+    if (!stream.is_open()) {
+        spdlog::error("[OpenFile::open] Failed to open {}", path.string());
+        return nullptr;
+    }
+    return std::make_shared<OpenFile>(std::move(stream));
+#endif
+}
+
+#if defined(__linux__)
+OpenFile::~OpenFile() {
+    ::close(fd_);
+}
+#endif
+
+bool OpenFile::write_at(std::uint64_t offset, std::string_view data) {
+#if defined(__linux__)
+    while (!data.empty()) {
+        const auto written = ::pwrite(fd_, data.data(), data.size(), static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        data.remove_prefix(static_cast<std::size_t>(written));
+        offset += static_cast<std::uint64_t>(written);
+    }
+    return true;
+#else
+    stream_.clear();
+    stream_.seekp(static_cast<std::streamoff>(offset), std::ios::beg);
+    stream_.write(data.data(), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(stream_);
+#endif
+}
+
+FileHandleCache::FileHandleCache(std::size_t capacity, DirectoryCache* directories)
+    : capacity_(std::max<std::size_t>(capacity, 1))
+    , owned_directories_(directories == nullptr ? std::make_unique<DirectoryCache>() : nullptr)
+    , directories_(directories == nullptr ? owned_directories_.get() : directories) {}
+
+FileHandleCache::~FileHandleCache() = default;
+
+std::shared_ptr<OpenFile> FileHandleCache::acquire(const std::filesystem::path& path,
+                                                   bool create) {
+    auto key = path.string();
+    {
+        std::lock_guard lock(mutex_);
+        if (const auto it = index_.find(key); it != index_.end() && !create) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            return it->second->second;
+        }
+    }
+
+    // 打开文件不持锁，其他文件的分块不必等待
+    auto file = directories_->open_file(path, create);
+    if (!file) {
+        return nullptr;
+    }
+
+    std::shared_ptr<OpenFile> evicted;
+    std::lock_guard lock(mutex_);
+    if (const auto it = index_.find(key); it != index_.end()) {
+        it->second->second = file;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return file;
+    }
+    lru_.emplace_front(key, file);
+    index_.emplace(std::move(key), lru_.begin());
+    if (lru_.size() > capacity_) {
+        // 在锁外随 evicted 析构关闭
+        evicted = std::move(lru_.back().second);
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+    return file;
+}
+
+void FileHandleCache::release(const std::filesystem::path& path) {
+    std::shared_ptr<OpenFile> released;
+    std::lock_guard lock(mutex_);
+    const auto it = index_.find(path.string());
+    if (it == index_.end()) {
+        return;
+    }
+    released = std::move(it->second->second);
+    lru_.erase(it->second);
+    index_.erase(it);
+}
+
+std::size_t FileHandleCache::size() const {
+    std::lock_guard lock(mutex_);
+    return lru_.size();
+}
+} // namespace receiver
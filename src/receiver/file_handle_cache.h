@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#if !defined(__linux__)
+#include <fstream>
+#endif
+
+namespace receiver {
+
+class DirectoryCache;
+
+// 一个已打开的目标文件，按偏移写入，析构时关闭
+class OpenFile {
+  public:
+    // create 时创建或截断文件，否则只打开已存在的文件；不创建父目录。失败时返回空
+    static std::shared_ptr<OpenFile> open(const std::filesystem::path& path, bool create);
+
+#if defined(__linux__)
+    explicit OpenFile(int fd)
+        : fd_(fd) {}
+    ~OpenFile();
+#else
+    explicit OpenFile(std::fstream stream)
+        : stream_(std::move(stream)) {}
+#endif
+
+    OpenFile(const OpenFile&) = delete;
+    OpenFile& operator=(const OpenFile&) = delete;
+
+    // 同一文件不能在多个线程上同时写
+    bool write_at(std::uint64_t offset, std::string_view data);
+
+  private:
+#if defined(__linux__)
+    int fd_;
+#else
+    std::fstream stream_;
+#endif
+};
+
+// 接收端打开文件的 LRU 缓存。目标文件在第一个分块到达时才创建，
+// 同时最多保持 capacity 个打开的文件，超出时关闭最久未写的，之后它的分块到达时重新打开（不截断）。
+// 正在写入的文件由调用方持有的 shared_ptr 保活，被逐出后仍可写完当前分块。线程安全
+class FileHandleCache {
+  public:
+    static constexpr std::size_t kDefaultCapacity = 256;
+
+    // 文件经由 directories 打开；为空时使用自己的目录缓存
+    explicit FileHandleCache(std::size_t capacity = kDefaultCapacity,
+                             DirectoryCache* directories = nullptr);
+    ~FileHandleCache();
+
+    FileHandleCache(const FileHandleCache&) = delete;
+    FileHandleCache& operator=(const FileHandleCache&) = delete;
+
+    // 取得 path 的打开文件并标记为最近使用；create 时创建父目录并截断文件
+    std::shared_ptr<OpenFile> acquire(const std::filesystem::path& path, bool create);
+    // 文件写完后移出缓存，没有其他持有者时随即关闭
+    void release(const std::filesystem::path& path);
+
+    std::size_t size() const;
+    std::size_t capacity() const { return capacity_; }
+    DirectoryCache& directories() { return *directories_; }
+
+  private:
+    using Entry = std::pair<std::string, std::shared_ptr<OpenFile>>;
+
+    std::size_t capacity_;
+    std::unique_ptr<DirectoryCache> owned_directories_;
+    DirectoryCache* directories_;
+    std::list<Entry> lru_; // 最近使用的在前
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    mutable std::mutex mutex_;
+};
+} // namespace receiver
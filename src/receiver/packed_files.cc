@@ -0,0 +1,54 @@
+#include "packed_files.h"
+#include "util/data_block.h"
+#include <optional>
+#include <spdlog/spdlog.h>
+
+namespace receiver {
+
+namespace {
+bool verify(const PackedFile& file, util::VerifyPolicy policy, util::VerifyCost* cost) {
+    if (policy == transfer::TransferMetadataRequest::VERIFY_NONE || !file.expected_hash) {
+        return true;
+    }
+    const ConstDataBlock block(reinterpret_cast<const std::byte*>(file.data.data()),
+                               file.data.size());
+    auto hash = [&] { return util::hash::sha256(block); };
+    const auto actual = cost ? cost->track(block.size(), 0, hash) : hash();
+    return actual && util::hash::digest_equal(*actual, *file.expected_hash);
+}
+} // namespace
+
+std::vector<bool> write_packed_files(const std::vector<PackedFile>& files,
+                                     util::VerifyPolicy policy,
+                                     util::VerifyCost* cost,
+                                     DirectoryCache* directories) {
+    std::vector<bool> results(files.size(), false);
+    std::optional<DirectoryCache> local_directories;
+    if (directories == nullptr) {
+        directories = &local_directories.emplace();
+    }
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        const auto& file = files[i];
+        if (file.data.size() != file.expected_size) {
+            spdlog::warn("[receiver::write_packed_files] Size mismatch for {}: {} != {}",
+                         file.destination.string(),
+                         file.data.size(),
+                         file.expected_size);
+            continue;
+        }
+        if (!verify(file, policy, cost)) {
+            spdlog::warn("[receiver::write_packed_files] Hash mismatch for {}",
+                         file.destination.string());
+            continue;
+        }
+
+        const auto output = directories->open_file(file.destination, true);
+        results[i] = output && output->write_at(0, file.data);
+        if (!results[i]) {
+            spdlog::error("[receiver::write_packed_files] Failed to write {}",
+                          file.destination.string());
+        }
+    }
+    return results;
+}
+} // namespace receiver
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "directory_cache.h"
+#include "util/hash.h"
+#include "util/verify.h"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace receiver {
+
+// 打包发送的一个小文件，data 指向批次帧中的内容
+struct PackedFile {
+    std::filesystem::path destination;
+    std::string_view data;
+    std::uint64_t expected_size = 0;
+    std::optional<util::hash::Sha256Digest> expected_hash;
+};
+
+// 在当前线程上依次校验并写出 files，返回每个文件是否成功。
+// 每个文件只有一次 open、write 与 close，不 flush、不预分配；文件经由 directories 相对父目录创建，
+// 为空时使用仅在本次调用内有效的目录缓存。在计算线程池上调用，cost 非空时记录校验开销
+std::vector<bool> write_packed_files(const std::vector<PackedFile>& files,
+                                     util::VerifyPolicy policy,
+                                     util::VerifyCost* cost = nullptr,
+                                     DirectoryCache* directories = nullptr);
+} // namespace receiver
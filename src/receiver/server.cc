@@ -0,0 +1,173 @@
+#include "server.h"
+#include "asio/dispatch.hpp"
+#include "asio/post.hpp"
+#include "asio/redirect_error.hpp"
+#include "asio/use_awaitable.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <exception>
+
+namespace receiver {
+
+Server::Server(core::Executor& executor, ServerOptions options)
+    : executor_(executor)
+    , options_(std::move(options))
+    , strand_(executor.make_serial_executor(executor.get_io_context()))
+    , admission_(options_.max_sessions, options_.max_inflight_bytes)
+    , files_(options_.max_open_files, &directories_) {
+    // 额度释放可能发生在任意会话的线程上，统一回到 strand_ 遍历会话表
+    admission_.set_release_handler([this]() {
+        post_tracked(strand_, [this]() { resume_sessions(); });
+    });
+}
+
+Server::~Server() {
+    stop();
+}
+
+bool Server::start() {
+    if (!stopped()) {
+        spdlog::error("[receiver::Server::start] Server is already running");
+        return false;
+    }
+    listeners_.clear();
+    // 分片模式下每个分片一个监听，后续的监听绑定第一个监听实际使用的端口
+    for (std::size_t shard = 0; shard < executor_.get_shard_count(); ++shard) {
+        auto listener = std::make_unique<Listener>(executor_, executor_.get_io_context(shard));
+        const auto listen_port = listeners_.empty() ? options_.port : port();
+        try {
+            listener->acceptor.listen(listen_port);
+        } catch (const std::exception& e) {
+            if (listeners_.empty()) {
+                spdlog::error("[receiver::Server::start] Failed to listen on port {}: {}",
+                              listen_port,
+                              e.what());
+                return false;
+            }
+            // 不支持 SO_REUSEPORT 时只保留已成功的监听
+            spdlog::warn("[receiver::Server::start] Shard {} failed to listen on port {}: {}",
+                         shard,
+                         listen_port,
+                         e.what());
+            break;
+        }
+        listeners_.push_back(std::move(listener));
+    }
+    running_.store(true);
+    pending_.fetch_add(listeners_.size());
+    spdlog::info("[receiver::Server::start] Listening on port {} ({} listeners), max {} sessions",
+                 port(),
+                 listeners_.size(),
+                 admission_.max_sessions());
+    for (auto& listener : listeners_) {
+        executor_.spawn_on(listener->strand, accept_loop(*listener));
+    }
+    return true;
+}
+
+void Server::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    for (auto& listener : listeners_) {
+        post_tracked(listener->strand, [listener = listener.get()]() {
+            listener->acceptor.close();
+            listener->gate.cancel();
+            listener->backoff.cancel();
+        });
+    }
+    post_tracked(strand_, [this]() {
+        for (auto& [id, session] : sessions_) {
+            asio::dispatch(session->strand(), [session]() { session->close(); });
+        }
+    });
+}
+
+asio::awaitable<void> Server::accept_loop(Listener& listener) {
+    auto retry_delay = kAcceptRetryMin;
+    while (running_.load()) {
+        if (admission_.sessions() >= admission_.max_sessions()) {
+            spdlog::debug("[receiver::Server::accept_loop] {} sessions active, pausing accept",
+                          admission_.sessions());
+            asio::error_code ec;
+            co_await listener.gate.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+            continue;
+        }
+
+        // 连接接受到监听所在的分片上，会话的协程都在该分片上运行
+        auto socket = co_await listener.acceptor.accept(listener.context);
+        if (!running_.load()) {
+            break;
+        }
+        if (!socket) {
+            // 文件描述符耗尽等错误会立即再次出现，退避后再重试，避免空转
+            listener.backoff.expires_after(retry_delay);
+            asio::error_code ec;
+            co_await listener.backoff.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+            retry_delay = std::min(retry_delay * 2, kAcceptRetryMax);
+            continue;
+        }
+        retry_delay = kAcceptRetryMin;
+        // 多个监听同时被唤醒时名额可能已被其他监听占用，已接受的连接等到有名额为止
+        while (running_.load() && !admission_.try_admit()) {
+            asio::error_code ec;
+            co_await listener.gate.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+        }
+        if (!running_.load()) {
+            break;
+        }
+        // 会话在所属分片上构造：构造时启动的协程不会与构造函数并发执行
+        const auto id = next_id_.fetch_add(1);
+        accepted_.fetch_add(1);
+        auto session = std::make_shared<Session>(executor_,
+                                                 std::move(*socket),
+                                                 options_.save_dir,
+                                                 &admission_,
+                                                 &files_,
+                                                 [this, id]() {
+                                                     asio::post(strand_, [this, id]() {
+                                                         remove_session(id);
+                                                     });
+                                                 });
+        post_tracked(strand_, [this, id, session = std::move(session)]() mutable {
+            add_session(id, std::move(session));
+        });
+    }
+    pending_.fetch_sub(1);
+}
+
+void Server::add_session(std::uint64_t id, std::shared_ptr<Session> session) {
+    // 会话与监听不在同一个串行执行器上时，会话可能在登记之前就已结束
+    if (finished_early_.erase(id) > 0) {
+        release_session(id);
+        return;
+    }
+    // 投递期间已经 stop()，会话关闭后照常移除
+    if (!running_.load()) {
+        asio::dispatch(session->strand(), [session]() { session->close(); });
+    }
+    sessions_.emplace(id, std::move(session));
+}
+
+void Server::remove_session(std::uint64_t id) {
+    if (sessions_.erase(id) == 0) {
+        finished_early_.insert(id);
+        return;
+    }
+    release_session(id);
+}
+
+void Server::release_session(std::uint64_t id) {
+    admission_.leave();
+    for (auto& listener : listeners_) {
+        post_tracked(listener->strand, [listener = listener.get()]() { listener->gate.cancel(); });
+    }
+    spdlog::debug("[receiver::Server] Session {} finished, {} active", id, admission_.sessions());
+}
+
+void Server::resume_sessions() {
+    for (auto& [id, session] : sessions_) {
+        asio::dispatch(session->strand(), [session]() { session->resume_receive(); });
+    }
+}
+} // namespace receiver
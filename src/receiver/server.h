@@ -0,0 +1,120 @@
+#pragma once
+#include "admission.h"
+#include "asio/any_io_executor.hpp"
+#include "asio/awaitable.hpp"
+#include "asio/post.hpp"
+#include "asio/steady_timer.hpp"
+#include "core/executor.h"
+#include "core/net/acceptor.h"
+#include "directory_cache.h"
+#include "file_handle_cache.h"
+#include "session.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace receiver {
+
+struct ServerOptions {
+    std::uint16_t port = 0; // 0 表示由系统分配，通过 Server::port() 查询
+    std::string save_dir;
+    // 同时进行的会话数上限，达到后暂停 accept，新连接留在内核的监听队列中
+    std::size_t max_sessions = 64;
+    // 所有会话在途（已收到、尚未落盘）分块字节总量上限
+    std::size_t max_inflight_bytes = 256 * 1024 * 1024;
+    // 所有会话同时打开的目标文件数上限，超出时关闭最久未写的文件
+    std::size_t max_open_files = FileHandleCache::kDefaultCapacity;
+};
+
+// 多发送端接收服务：监听端口，每个连接一个 receiver::Session（各自的 socket 与串行执行器，
+// 位于接受它的监听所在的 io 分片），通过 Admission 限制并发会话数与在途字节。
+// 分片模式下每个分片一个监听 socket，都开启 SO_REUSEPORT，由内核把新连接分给各分片。
+// 会话的分块处理共用计算线程池，在途字节按会话平分，慢会话不会占满磁盘队列。
+// 会话在所有协程结束（对端断开或 stop()）后自动移除。
+// Server 必须比其会话活得更久：销毁前先 stop()，并等待 stopped() 为 true、active_sessions() 归零
+class Server {
+  public:
+    Server(core::Executor& executor, ServerOptions options);
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    // 开始监听并启动 accept 循环，监听失败时返回 false
+    bool start();
+    // 停止 accept 并关闭所有会话，可在任意线程调用
+    void stop();
+    // 未启动，或 stop() 之后所有 accept 循环与关闭操作都已结束
+    bool stopped() const { return !running_.load() && pending_.load() == 0; }
+
+    std::uint16_t port() const {
+        return listeners_.empty() ? 0 : listeners_.front()->acceptor.port();
+    }
+    std::size_t active_sessions() const { return admission_.sessions(); }
+    std::size_t accepted_sessions() const { return accepted_.load(); }
+    const Admission& admission() const { return admission_; }
+
+  private:
+    // 一个监听 socket 及其 accept 循环，都在所属分片的串行执行器上，接受的连接也留在该分片
+    struct Listener {
+        Listener(core::Executor& executor, asio::io_context& context)
+            : context(context)
+            , strand(executor.make_serial_executor(context))
+            , acceptor(executor, context)
+            , gate(strand, asio::steady_timer::time_point::max())
+            , backoff(strand) {}
+
+        asio::io_context& context;
+        asio::any_io_executor strand;
+        core::net::Acceptor acceptor;
+        // 会话数达到上限时在此等待，会话移除时唤醒。到期时间固定为最大值
+        asio::steady_timer gate;
+        // accept 出错后等待一段时间再重试
+        asio::steady_timer backoff;
+    };
+
+    // accept 连续出错时的重试间隔，每次加倍
+    static constexpr std::chrono::milliseconds kAcceptRetryMin{10};
+    static constexpr std::chrono::milliseconds kAcceptRetryMax{1000};
+
+    asio::awaitable<void> accept_loop(Listener& listener);
+    // 以下只在 strand_ 上调用
+    void add_session(std::uint64_t id, std::shared_ptr<Session> session);
+    void remove_session(std::uint64_t id);
+    void release_session(std::uint64_t id);
+    void resume_sessions();
+
+    // 投递访问 Server 的处理函数，执行完之前计入 pending_
+    template<typename Function>
+    void post_tracked(const asio::any_io_executor& executor, Function function) {
+        pending_.fetch_add(1);
+        asio::post(executor, [this, function = std::move(function)]() mutable {
+            function();
+            pending_.fetch_sub(1);
+        });
+    }
+
+    core::Executor& executor_;
+    ServerOptions options_;
+    asio::any_io_executor strand_;
+    std::vector<std::unique_ptr<Listener>> listeners_;
+    Admission admission_;
+    DirectoryCache directories_;
+    FileHandleCache files_;
+
+    std::unordered_map<std::uint64_t, std::shared_ptr<Session>> sessions_;
+    // 登记之前就已结束的会话
+    std::unordered_set<std::uint64_t> finished_early_;
+    std::atomic<std::uint64_t> next_id_{0};
+    std::atomic<bool> running_{false};
+    // 运行中的 accept 循环与尚未执行的 post_tracked 处理函数，归零前它们还会访问 Server
+    std::atomic<std::size_t> pending_{0};
+    std::atomic<std::size_t> accepted_{0};
+};
+} // namespace receiver
@@ -1,6 +1,10 @@
 #include "session.h"
 #include "asio/awaitable.hpp"
+#include "asio/co_spawn.hpp"
+#include "asio/use_awaitable.hpp"
+#include "packed_files.h"
 #include "util/data_block.h"
+#include "util/hash.h"
 #include <algorithm>
 #include <filesystem>
 #include <spdlog/spdlog.h>
@@ -11,7 +15,8 @@ asio::awaitable<void> Session::start() {
     co_await core::net::io::Session::start();
 }
 
-asio::awaitable<void> Session::handle_message(const MessageWrapper& message) {
+asio::awaitable<void> Session::handle_stream_message(std::uint32_t stream_id,
+                                                     const MessageWrapper& message) {
     spdlog::debug("[receiver::Session] Received message type: {}", message.type());
     ConstDataBlock data(reinterpret_cast<const std::byte*>(message.payload().data()),
                         message.payload().size());
@@ -22,7 +27,7 @@ asio::awaitable<void> Session::handle_message(const MessageWrapper& message) {
             spdlog::error("[receiver::Session] Failed to deserialize TransferMetadataRequest");
             co_return;
         }
-        co_await handle_metadata(request);
+        co_await handle_metadata(stream_id, request);
         co_return;
     }
     if (message.type() == "transfer.FileChunkRequest") {
@@ -36,38 +41,87 @@ asio::awaitable<void> Session::handle_message(const MessageWrapper& message) {
             request.file_relative_path(),
             request.chunk_index(),
             request.data().size());
-        co_await handle_file_chunk(request);
+        co_await handle_file_chunk(stream_id, request);
+        co_return;
+    }
+    if (message.type() == "transfer.FileBatchRequest") {
+        transfer::FileBatchRequest request;
+        if (!util::deserialize(data, request)) {
+            spdlog::error("[receiver::Session] Failed to deserialize FileBatchRequest");
+            co_return;
+        }
+        co_await handle_file_batch(stream_id, request);
         co_return;
     }
     co_return;
 }
 
-asio::awaitable<void> Session::handle_metadata(const transfer::TransferMetadataRequest& request) {
-    receivers_map_.clear();
-    file_paths_.clear();
-    completed_files_ = 0;
-
-    if (request.files().empty()) {
-        transfer::TransferMetadataResponse response;
-        response.set_status(transfer::TransferMetadataResponse::READY);
-        co_await send(response);
-        co_return;
+asio::awaitable<void> Session::handle_metadata(std::uint32_t stream_id,
+                                               const transfer::TransferMetadataRequest& request) {
+    const auto first = static_cast<std::size_t>(request.first_file_index());
+    std::shared_ptr<Transfer> transfer;
+    if (first == 0) {
+        // 同一个流上的新元数据开始一次新的传输，替换掉流上原有的
+        transfer = std::make_shared<Transfer>();
+        transfer->verify_policy = request.verify_policy();
+        verify_policy_ = request.verify_policy();
+        transfers_[stream_id] = transfer;
+    } else if (const auto it = transfers_.find(stream_id); it != transfers_.end()) {
+        transfer = it->second;
     }
 
     bool prepare_failed = false;
     std::string failure_message;
+    // 后续页只能紧接着上一页，传输已失败或清单已完整时丢弃
+    if (transfer == nullptr || transfer->manifest_complete
+        || first != transfer->file_paths.size()) {
+        prepare_failed = true;
+        failure_message = "Unexpected manifest page";
+        spdlog::error("[receiver::Session] Unexpected manifest page at file {} on stream {}",
+                      first,
+                      stream_id);
+    }
 
-    for (int i = 0; i < request.files_size(); ++i) {
+    for (int i = 0; !prepare_failed && i < request.files_size(); ++i) {
         const auto& file_info = request.files(i);
+        const auto file_index = first + static_cast<std::size_t>(i);
+
+        if (!transfer->file_indices.emplace(file_info.relative_path(), file_index).second) {
+            prepare_failed = true;
+            failure_message = "Duplicated file path: " + file_info.relative_path();
+            spdlog::error("[receiver::Session] Duplicate file path in metadata: {}",
+                          file_info.relative_path());
+            break;
+        }
 
         FilePath file_path;
         file_path.relative = std::filesystem::path(file_info.relative_path());
         file_path.absolute = std::filesystem::path(save_dir_) / file_path.relative;
-        file_path.file_index = static_cast<std::size_t>(i);
+        file_path.file_index = file_index;
+        file_path.size = file_info.size();
 
-        auto receiver = std::make_unique<SingleFileReceiver>(file_info.relative_path(),
+        // 打包的小文件随批次整体写出，这里不打开文件
+        if (file_info.packed()) {
+            file_path.packed = true;
+            file_path.expected_hash =
+                util::hash::to_digest(util::hash::as_block(file_info.hash()));
+            if (!file_info.hash().empty() && !file_path.expected_hash) {
+                prepare_failed = true;
+                failure_message = "Malformed file hash: " + file_info.relative_path();
+                spdlog::error("[receiver::Session] Malformed hash for packed file {}",
+                              file_info.relative_path());
+                break;
+            }
+            transfer->file_paths.push_back(std::move(file_path));
+            continue;
+        }
+
+        auto receiver = std::make_shared<SingleFileReceiver>(file_info.relative_path(),
                                                              file_info.hash(),
-                                                             file_info.size());
+                                                             file_info.size(),
+                                                             transfer->verify_policy,
+                                                             &transfer->verify_cost,
+                                                             files_);
 
         if (!receiver->prepare_storage(file_path.absolute)) {
             prepare_failed = true;
@@ -78,64 +132,133 @@ asio::awaitable<void> Session::handle_metadata(const transfer::TransferMetadataR
             break;
         }
 
-        auto [it, inserted] = receivers_map_.emplace(file_info.relative_path(), std::move(receiver));
-        if (!inserted) {
-            prepare_failed = true;
-            failure_message = "Duplicated file path: " + file_info.relative_path();
-            spdlog::error("[receiver::Session] Duplicate file path in metadata: {}",
-                          file_info.relative_path());
-            break;
-        }
-        file_paths_.push_back(std::move(file_path));
+        transfer->receivers_map.emplace(
+            file_info.relative_path(),
+            ReceiverSlot{std::move(receiver), asio::make_strand(executor_.get_thread_pool())});
+        transfer->file_paths.push_back(std::move(file_path));
     }
 
     transfer::TransferMetadataResponse response;
+    response.set_first_file_index(request.first_file_index());
     if (prepare_failed) {
-        receivers_map_.clear();
-        file_paths_.clear();
+        if (const auto it = transfers_.find(stream_id);
+            it != transfers_.end() && it->second == transfer) {
+            transfers_.erase(it);
+        }
         response.set_status(transfer::TransferMetadataResponse::FAILURE);
         response.set_message(failure_message);
-    } else {
-        response.set_status(transfer::TransferMetadataResponse::READY);
-        spdlog::info("[receiver::Session] Prepared to receive {} files", file_paths_.size());
+        co_await send(stream_id, response);
+        co_return;
     }
 
-    co_await send(response);
-    co_return;
+    // 各页并发处理、建目录的完成顺序不定，最后一页在让出执行之前标记清单完整，
+    // 不会被之后才建完目录的前一页覆盖
+    if (!request.more_pages()) {
+        transfer->manifest_complete = true;
+    }
+
+    // 本页涉及的目录在计算线程池上按父目录优先一次建好，之后的文件只需相对父目录 openat。
+    // 等待期间后续页可能先被确认，发送端按 first_file_index 对应
+    std::vector<std::filesystem::path> directories;
+    for (std::size_t i = first; i < transfer->file_paths.size(); ++i) {
+        auto directory = transfer->file_paths[i].absolute.parent_path();
+        if (directories.empty() || directories.back() != directory) {
+            directories.push_back(std::move(directory));
+        }
+    }
+    const bool directories_ok = co_await executor_.offload([&]() {
+        return files_->directories().create_all(std::move(directories),
+                                                &executor_.get_cpu_pool());
+    });
+    if (!directories_ok) {
+        spdlog::warn("[receiver::Session] Failed to create some directories on stream {}",
+                     stream_id);
+    }
+
+    response.set_status(transfer::TransferMetadataResponse::READY);
+    spdlog::info("[receiver::Session] Prepared to receive {} files on stream {}",
+                 transfer->file_paths.size(),
+                 stream_id);
+    co_await send(stream_id, response);
+    // 最后一页之前的文件可能都已完成，空传输也在这里结束
+    co_await finish_if_complete(stream_id, transfer);
+}
+
+asio::awaitable<Session::ChunkOutcome> Session::process_chunk(
+    std::shared_ptr<SingleFileReceiver> receiver, const transfer::FileChunkRequest& request) {
+    ChunkOutcome outcome;
+    outcome.accepted = receiver->handle_chunk(request);
+    if (!outcome.accepted || !receiver->is_complete()) {
+        co_return outcome;
+    }
+
+    spdlog::debug("[receiver::Session] File {} is complete, finalizing...",
+                  receiver->relative_path());
+    outcome.file_done = true;
+    std::tie(outcome.file_ok, outcome.expected_hash, outcome.actual_hash)
+        = receiver->finalize_and_verify();
+    co_return outcome;
 }
 
-asio::awaitable<void> Session::handle_file_chunk(const transfer::FileChunkRequest& request) {
+asio::awaitable<void> Session::handle_file_chunk(std::uint32_t stream_id,
+                                                 const transfer::FileChunkRequest& request) {
     transfer::FileChunkResponse chunk_response;
     chunk_response.set_file_relative_path(request.file_relative_path());
     chunk_response.set_chunk_index(request.chunk_index());
 
-    auto receiver_it = receivers_map_.find(request.file_relative_path());
-    if (receiver_it == receivers_map_.end()) {
+    std::shared_ptr<Transfer> transfer;
+    const ReceiverSlot* found = nullptr;
+    if (const auto it = transfers_.find(stream_id); it != transfers_.end()) {
+        transfer = it->second;
+        const auto receiver_it = transfer->receivers_map.find(request.file_relative_path());
+        if (receiver_it != transfer->receivers_map.end()) {
+            found = &receiver_it->second;
+        }
+    }
+    if (found == nullptr) {
         chunk_response.set_status(transfer::FileChunkResponse::FAILURE);
         chunk_response.set_message("Unknown file");
-        co_await send(chunk_response);
+        co_await send(stream_id, chunk_response);
         co_return;
     }
 
-    auto& receiver = *receiver_it->second;
-    if (!receiver.handle_chunk(request)) {
+    // 拷贝一份槽位：等待期间槽位可能因文件完成而从 receivers_map 中移除
+    const auto slot = *found;
+    auto& receiver = *slot.receiver;
+
+    const std::size_t chunk_bytes = request.data().size();
+    ++pending_chunks_;
+    inflight_bytes_ += chunk_bytes;
+    if (admission_ != nullptr) {
+        admission_->take(chunk_bytes);
+    }
+    const auto outcome = co_await asio::co_spawn(slot.strand,
+                                                 process_chunk(slot.receiver, request),
+                                                 asio::use_awaitable);
+    --pending_chunks_;
+    inflight_bytes_ -= chunk_bytes;
+    if (admission_ != nullptr) {
+        admission_->give_back(chunk_bytes);
+    }
+    resume_receive();
+
+    if (!outcome.accepted) {
         chunk_response.set_status(transfer::FileChunkResponse::FAILURE);
         chunk_response.set_message("Chunk validation failed");
-        co_await send(chunk_response);
+        co_await send(stream_id, chunk_response);
         co_return;
     }
 
     chunk_response.set_status(transfer::FileChunkResponse::RECEIVED);
-    co_await send(chunk_response);
+    co_await send(stream_id, chunk_response);
 
-    if (!receiver.is_complete()) {
-        spdlog::debug("[receiver::Session] File {} not complete yet, completed_chunks={}",
-                      receiver.relative_path(), receiver.completed_chunks());
+    if (!outcome.file_done) {
         co_return;
     }
 
-    spdlog::debug("[receiver::Session] File {} is complete, finalizing...", receiver.relative_path());
-    auto [file_ok, expected_hash, actual_hash] = receiver.finalize_and_verify();
+    const bool file_ok = outcome.file_ok;
+    const auto& expected_hash = outcome.expected_hash;
+    const auto& actual_hash = outcome.actual_hash;
 
     transfer::FileInfoResponse info_response;
     info_response.set_relative_path(receiver.relative_path());
@@ -144,9 +267,10 @@ asio::awaitable<void> Session::handle_file_chunk(const transfer::FileChunkReques
         spdlog::info("[receiver::Session] Completed file {}", receiver.relative_path());
     } else {
         info_response.set_status(transfer::FileInfoResponse::FAILURE);
-        if (!expected_hash.empty() && !actual_hash.empty() && expected_hash != actual_hash) {
+        if (expected_hash && actual_hash
+            && !util::hash::digest_equal(*expected_hash, *actual_hash)) {
             info_response.set_message("Hash mismatch");
-        } else if (!expected_hash.empty() && actual_hash.empty()) {
+        } else if (expected_hash && !actual_hash) {
             info_response.set_message("Failed to compute file hash");
         } else {
             info_response.set_message("File incomplete");
@@ -154,41 +278,136 @@ asio::awaitable<void> Session::handle_file_chunk(const transfer::FileChunkReques
         spdlog::warn("[receiver::Session] File {} verification failed", receiver.relative_path());
     }
 
-    co_await send(info_response);
+    co_await send(stream_id, info_response);
+
+    const auto file_entry = transfer->file_indices.find(receiver.relative_path());
+    if (file_entry != transfer->file_indices.end()) {
+        transfer->file_paths[file_entry->second].status =
+            file_ok ? FilePath::Status::Succeeded : FilePath::Status::Failed;
+    }
 
-    auto file_entry = std::find_if(file_paths_.begin(),
-                                   file_paths_.end(),
-                                   [&](const FilePath& path) {
-                                       return path.relative.string() == receiver.relative_path();
-                                   });
-    if (file_entry != file_paths_.end()) {
-        file_entry->status = file_ok ? FilePath::Status::Succeeded : FilePath::Status::Failed;
+    ++transfer->completed_files;
+    auto& receivers_map = transfer->receivers_map;
+    auto current = receivers_map.find(receiver.relative_path());
+    if (current != receivers_map.end() && current->second.receiver == slot.receiver) {
+        receivers_map.erase(current);
     }
 
-    ++completed_files_;
-    receivers_map_.erase(receiver_it);
+    co_await finish_if_complete(stream_id, transfer);
+    co_return;
+}
 
-    const bool all_done = completed_files_ >= file_paths_.size();
-    const bool all_success = std::all_of(file_paths_.begin(),
-                                         file_paths_.end(),
+asio::awaitable<void> Session::finish_if_complete(std::uint32_t stream_id,
+                                                  std::shared_ptr<Transfer> transfer) {
+    const auto& file_paths = transfer->file_paths;
+    if (!transfer->manifest_complete || transfer->completed_files < file_paths.size()) {
+        co_return;
+    }
+    const bool all_success = std::all_of(file_paths.begin(),
+                                         file_paths.end(),
                                          [](const FilePath& path) {
                                              return path.status == FilePath::Status::Succeeded;
                                          });
 
-    if (all_done) {
-        transfer::TransferMetadataResponse completion_response;
-        if (all_success) {
-            completion_response.set_status(transfer::TransferMetadataResponse::SUCCESS);
-        } else {
-            completion_response.set_status(transfer::TransferMetadataResponse::FAILURE);
-            completion_response.set_message("One or more files failed during transfer");
-        }
-        co_await send(completion_response);
-        
-        // 停止会话
+    const auto& cost = transfer->verify_cost;
+    spdlog::info("[receiver::Session] Verification cost: {}",
+                 cost.summary(transfer->verify_policy));
+    verify_cost_.record(cost.cpu_time(), cost.bytes_hashed(), cost.bytes_read());
+    const auto current_transfer = transfers_.find(stream_id);
+    if (current_transfer != transfers_.end() && current_transfer->second == transfer) {
+        transfers_.erase(current_transfer);
+    }
+
+    transfer::TransferMetadataResponse completion_response;
+    if (all_success) {
+        completion_response.set_status(transfer::TransferMetadataResponse::SUCCESS);
+    } else {
+        completion_response.set_status(transfer::TransferMetadataResponse::FAILURE);
+        completion_response.set_message("One or more files failed during transfer");
+    }
+    co_await send(stream_id, completion_response);
+
+    // 长连接留给发送端的下一次传输，否则在没有其他传输时停止会话
+    if (!keep_alive_ && transfers_.empty()) {
         stop();
     }
-    co_return;
+}
+
+asio::awaitable<void> Session::handle_file_batch(std::uint32_t stream_id,
+                                                 const transfer::FileBatchRequest& request) {
+    transfer::FileBatchResponse response;
+    response.set_batch_index(request.batch_index());
+
+    const auto it = transfers_.find(stream_id);
+    if (it == transfers_.end()) {
+        for (const auto& entry : request.entries()) {
+            response.add_failed_files(entry.file_index());
+        }
+        response.set_message("Unknown transfer");
+        co_await send(stream_id, response);
+        co_return;
+    }
+    // 等待落盘期间传输可能被同一流上的新元数据替换，持有它直到处理完成
+    const auto transfer = it->second;
+
+    // 只接受元数据中标记为打包、尚未完成的文件，越界的条目直接判为失败。
+    // 接受的文件在让出执行前标记为 Writing，同一批次或并发批次中重复的条目判为失败
+    std::vector<PackedFile> files;
+    std::vector<std::size_t> indices;
+    const auto& data = request.data();
+    for (const auto& entry : request.entries()) {
+        const auto index = static_cast<std::size_t>(entry.file_index());
+        const bool valid = index < transfer->file_paths.size()
+                           && transfer->file_paths[index].packed
+                           && transfer->file_paths[index].status == FilePath::Status::InProgress
+                           && entry.offset() <= data.size()
+                           && entry.length() <= data.size() - entry.offset();
+        if (!valid) {
+            response.add_failed_files(entry.file_index());
+            continue;
+        }
+        auto& file_path = transfer->file_paths[index];
+        file_path.status = FilePath::Status::Writing;
+        files.push_back({file_path.absolute,
+                         std::string_view(data).substr(entry.offset(), entry.length()),
+                         file_path.size,
+                         file_path.expected_hash});
+        indices.push_back(index);
+    }
+
+    const std::size_t batch_bytes = data.size();
+    ++pending_chunks_;
+    inflight_bytes_ += batch_bytes;
+    if (admission_ != nullptr) {
+        admission_->take(batch_bytes);
+    }
+    // 整批在计算线程池上一次写完，不占用 io 线程
+    const auto results = co_await executor_.offload([&]() {
+        return write_packed_files(
+            files, transfer->verify_policy, &transfer->verify_cost, &files_->directories());
+    });
+    --pending_chunks_;
+    inflight_bytes_ -= batch_bytes;
+    if (admission_ != nullptr) {
+        admission_->give_back(batch_bytes);
+    }
+    resume_receive();
+
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+        auto& file_path = transfer->file_paths[indices[i]];
+        file_path.status = results[i] ? FilePath::Status::Succeeded : FilePath::Status::Failed;
+        if (!results[i]) {
+            response.add_failed_files(static_cast<std::uint32_t>(indices[i]));
+        }
+        ++transfer->completed_files;
+    }
+    spdlog::debug("[receiver::Session] Wrote batch {} with {} files on stream {}",
+                  request.batch_index(),
+                  indices.size(),
+                  stream_id);
+
+    co_await send(stream_id, response);
+    co_await finish_if_complete(stream_id, transfer);
 }
 
 } // namespace receiver
@@ -1,9 +1,18 @@
 #pragma once
 #include "asio/awaitable.hpp"
+#include "asio/strand.hpp"
+#include "asio/thread_pool.hpp"
+#include "admission.h"
 #include "core/net/io/session.h"
+#include "directory_cache.h"
+#include "file_handle_cache.h"
 #include "single_file_receiver.h"
 #include "transfer.pb.h"
+#include "util/hash.h"
+#include "util/verify.h"
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
 
@@ -12,26 +21,109 @@ class Session : public core::net::io::Session {
   public:
     Session(core::Executor& executor, uint16_t port, std::string_view save_dir)
         : core::net::io::Session(executor, port)
+        , owned_files_(std::make_unique<FileHandleCache>())
+        , files_(owned_files_.get())
+        , save_dir_(save_dir) {}
+
+    // 由 receiver::Server 接受的连接；admission 为空时不参与全局额度。
+    // files 为各会话共享的打开文件缓存，为空时会话使用自己的缓存。
+    // 传输完成后会话继续等待同一连接上的下一次传输，直到对端断开
+    Session(core::Executor& executor,
+            asio::ip::tcp::socket socket,
+            std::string_view save_dir,
+            Admission* admission,
+            FileHandleCache* files,
+            std::function<void()> on_finished)
+        : core::net::io::Session(executor, std::move(socket), std::move(on_finished))
+        , admission_(admission)
+        , keep_alive_(true)
+        , owned_files_(files == nullptr ? std::make_unique<FileHandleCache>() : nullptr)
+        , files_(files == nullptr ? owned_files_.get() : files)
         , save_dir_(save_dir) {}
 
     asio::awaitable<void> start() override;
 
+    // 最近一次传输的校验策略
+    util::VerifyPolicy verify_policy() const { return verify_policy_; }
+    // 会话内已完成传输的校验开销累计
+    const util::VerifyCost& verify_cost() const { return verify_cost_; }
+
   private:
-    asio::awaitable<void> handle_message(const MessageWrapper& message) override;
+    asio::awaitable<void> handle_stream_message(std::uint32_t stream_id,
+                                                const MessageWrapper& message) override;
+
+    asio::awaitable<void> handle_metadata(std::uint32_t stream_id,
+                                          const transfer::TransferMetadataRequest& request);
+    asio::awaitable<void> handle_file_chunk(std::uint32_t stream_id,
+                                            const transfer::FileChunkRequest& request);
+    asio::awaitable<void> handle_file_batch(std::uint32_t stream_id,
+                                            const transfer::FileBatchRequest& request);
 
-    asio::awaitable<void> handle_metadata(const transfer::TransferMetadataRequest& request);
-    asio::awaitable<void> handle_file_chunk(const transfer::FileChunkRequest& request);
+    bool can_receive() const override {
+        return pending_chunks_ < kMaxPendingChunks
+               && (admission_ == nullptr || admission_->can_take(inflight_bytes_));
+    }
 
-    std::unordered_map<std::string, std::unique_ptr<SingleFileReceiver>> receivers_map_;
+    // 分块校验与落盘在线程池上执行，每个文件一个 strand 保证同一文件内按到达顺序处理
+    using PoolStrand = asio::strand<asio::thread_pool::executor_type>;
+    struct ReceiverSlot {
+        std::shared_ptr<SingleFileReceiver> receiver;
+        PoolStrand strand;
+    };
+
+    // 在 strand 上完成一个分块的处理，文件收齐时顺带完成整文件校验
+    struct ChunkOutcome {
+        bool accepted = false;
+        bool file_done = false;
+        bool file_ok = false;
+        SingleFileReceiver::OptionalDigest expected_hash;
+        SingleFileReceiver::OptionalDigest actual_hash;
+    };
+    static asio::awaitable<ChunkOutcome> process_chunk(std::shared_ptr<SingleFileReceiver> receiver,
+                                                       const transfer::FileChunkRequest& request);
+
+    // 已交给磁盘阶段但尚未完成的分块数上限，超出后暂停读取 socket
+    static constexpr std::size_t kMaxPendingChunks = 16;
+    std::size_t pending_chunks_ = 0;
+    std::size_t inflight_bytes_ = 0;
+    Admission* admission_ = nullptr;
+    bool keep_alive_ = false;
+    // 目标文件在第一个分块到达时才创建，打开的描述符数量由缓存限制
+    std::unique_ptr<FileHandleCache> owned_files_;
+    FileHandleCache* files_;
 
-    size_t completed_files_ = 0;
     struct FilePath {
         std::filesystem::path relative;
         std::filesystem::path absolute;
-        enum class Status { Succeeded, Failed, InProgress } status{Status::InProgress};
+        // Writing：打包文件已被某个批次认领、正在落盘，重复的条目据此拒绝
+        enum class Status { Succeeded, Failed, InProgress, Writing } status{Status::InProgress};
         std::size_t file_index;
+        std::uint64_t size = 0;
+        bool packed = false;       // 内容随 FileBatchRequest 到达，没有对应的接收器
+        std::optional<util::hash::Sha256Digest> expected_hash; // 仅打包文件使用
+    };
+
+    // 一次传输的状态。发送端的每个传输占用一个流，应答沿同一个流返回
+    struct Transfer {
+        std::unordered_map<std::string, ReceiverSlot> receivers_map;
+        std::vector<FilePath> file_paths;
+        std::unordered_map<std::string, std::size_t> file_indices; // 相对路径 -> 下标
+        // 清单分页到达，收到最后一页之前即使现有文件都已完成，传输也没有结束
+        bool manifest_complete = false;
+        size_t completed_files = 0;
+        util::VerifyPolicy verify_policy = transfer::TransferMetadataRequest::VERIFY_BOTH;
+        util::VerifyCost verify_cost;
     };
+    // 全部文件都已结束时发送整体完成应答并移除传输
+    asio::awaitable<void> finish_if_complete(std::uint32_t stream_id,
+                                             std::shared_ptr<Transfer> transfer);
+
+    // 进行中的传输，键为流 ID。分块处理期间持有 shared_ptr，传输被替换后仍可安全访问
+    std::unordered_map<std::uint32_t, std::shared_ptr<Transfer>> transfers_;
+
+    util::VerifyPolicy verify_policy_ = transfer::TransferMetadataRequest::VERIFY_BOTH;
+    util::VerifyCost verify_cost_;
+
     std::string save_dir_;
-    std::vector<FilePath> file_paths_;
 };
 } // namespace receiver
\ No newline at end of file
@@ -17,11 +17,18 @@ bool GetLastChunkFlag(const Message& message) {
 } // namespace
 
 SingleFileReceiver::SingleFileReceiver(std::string relative_path,
-                                       std::string expected_file_hash,
-                                       std::uint64_t file_size)
+                                       std::string_view expected_file_hash,
+                                       std::uint64_t file_size,
+                                       util::VerifyPolicy policy,
+                                       util::VerifyCost* cost,
+                                       FileHandleCache* files)
     : rel_path_(std::move(relative_path))
-    , expected_hash_(std::move(expected_file_hash))
-    , file_size_(file_size) {
+    , files_(files)
+    , file_size_(file_size)
+    , expected_hash_(util::hash::to_digest(util::hash::as_block(expected_file_hash)))
+    , hash_malformed_(!expected_file_hash.empty() && !expected_hash_.has_value())
+    , policy_(policy)
+    , cost_(cost) {
     expected_total_chunks_ = file_size_ == 0
                                  ? 1
                                  : (file_size_ + kDefaultChunkSize - 1) / kDefaultChunkSize;
@@ -29,29 +36,16 @@ SingleFileReceiver::SingleFileReceiver(std::string relative_path,
 }
 
 bool SingleFileReceiver::prepare_storage(const std::filesystem::path& dest_path) {
-    dest_path_ = dest_path;
-
-    std::error_code ec;
-    const auto parent = dest_path_.parent_path();
-    if (!parent.empty()) {
-        std::filesystem::create_directories(parent, ec);
-        if (ec) {
-            spdlog::error(
-                "[SingleFileReceiver::prepare_storage] Failed to create directories for {}: {}",
-                dest_path_.string(),
-                ec.message());
-            return false;
-        }
-    }
-
-    fs_.open(dest_path_, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
-    if (!fs_.is_open()) {
-        spdlog::error("[SingleFileReceiver::prepare_storage] Failed to open file: {}",
-                      dest_path_.string());
+    // 长度不符的摘要（如旧版本发送的十六进制串）无法校验，不能当作未提供而静默跳过
+    if (hash_malformed_) {
+        spdlog::error("[SingleFileReceiver::prepare_storage] Malformed file hash for {}",
+                      rel_path_);
         return false;
     }
-
+    dest_path_ = dest_path;
     storage_prepared_ = true;
+    created_ = false;
+    file_.reset();
     bytes_received_ = 0;
     completed_chunks_ = 0;
     last_chunk_received_ = false;
@@ -60,6 +54,26 @@ bool SingleFileReceiver::prepare_storage(const std::filesystem::path& dest_path)
     return true;
 }
 
+std::shared_ptr<OpenFile> SingleFileReceiver::open_file() {
+    const bool create = !created_;
+    std::shared_ptr<OpenFile> file;
+    if (files_ != nullptr) {
+        file = files_->acquire(dest_path_, create);
+    } else {
+        if (!file_) {
+            // 没有共享缓存时只有这一个文件，直接按路径创建父目录
+            std::error_code ec;
+            if (create && !dest_path_.parent_path().empty()) {
+                std::filesystem::create_directories(dest_path_.parent_path(), ec);
+            }
+            file_ = ec ? nullptr : OpenFile::open(dest_path_, create);
+        }
+        file = file_;
+    }
+    created_ = created_ || file != nullptr;
+    return file;
+}
+
 bool SingleFileReceiver::is_complete() const {
     if (finalized_) {
         return true;
@@ -99,13 +113,6 @@ bool SingleFileReceiver::handle_chunk(const transfer::FileChunkRequest& request)
         if (!prepare_storage(dest_path_)) {
             return false;
         }
-    } else if (!fs_.is_open()) {
-        fs_.open(dest_path_, std::ios::binary | std::ios::in | std::ios::out);
-        if (!fs_.is_open()) {
-            spdlog::error("[SingleFileReceiver::handle_chunk] Failed to reopen file: {}",
-                          dest_path_.string());
-            return false;
-        }
     }
 
     const std::uint64_t chunk_index = request.chunk_index();
@@ -126,33 +133,32 @@ bool SingleFileReceiver::handle_chunk(const transfer::FileChunkRequest& request)
     spdlog::debug("[SingleFileReceiver::handle_chunk] {} chunk {} - size={}, is_last={}", 
                   rel_path_, chunk_index, data.size(), is_last_chunk);
 
-    if (!request.hash().empty()) {
-        auto computed_hash = util::hash::sha256_hex(data_block);
-        if (!computed_hash || *computed_hash != request.hash()) {
+    if (util::verifies_chunks(policy_) && !request.hash().empty()) {
+        auto hash_chunk = [&] { return util::hash::sha256(data_block); };
+        auto computed_hash = cost_ ? cost_->track(data_block.size(), 0, hash_chunk) : hash_chunk();
+        if (!computed_hash
+            || !util::hash::digest_equal(*computed_hash, util::hash::as_block(request.hash()))) {
             chunk_info.status = ChunkInfo::Status::Failed;
             spdlog::warn("[SingleFileReceiver::handle_chunk] Hash mismatch for {} chunk {}",
                          rel_path_,
                          chunk_index);
             return false;
         }
-        chunk_info.hash = *computed_hash;
+        chunk_info.hash = computed_hash;
     } else {
-        chunk_info.hash.clear();
+        chunk_info.hash.reset();
     }
 
     const std::uint64_t offset = chunk_index * kDefaultChunkSize;
-    fs_.clear();
-    fs_.seekp(static_cast<std::streamoff>(offset), std::ios::beg);
-    if (!fs_) {
-        spdlog::error("[SingleFileReceiver::handle_chunk] Failed to seek to offset {} in {}",
-                      offset,
+    const auto file = open_file();
+    if (!file) {
+        spdlog::error("[SingleFileReceiver::handle_chunk] Failed to open file: {}",
                       dest_path_.string());
         return false;
     }
 
     if (!data.empty()) {
-        fs_.write(data.data(), static_cast<std::streamsize>(data.size()));
-        if (!fs_) {
+        if (!file->write_at(offset, data)) {
             spdlog::error("[SingleFileReceiver::handle_chunk] Failed to write chunk {} for file {}",
                           chunk_index,
                           dest_path_.string());
@@ -160,8 +166,6 @@ bool SingleFileReceiver::handle_chunk(const transfer::FileChunkRequest& request)
         }
     }
 
-    fs_.flush();
-
     chunk_info.offset = offset;
     chunk_info.size = static_cast<std::uint32_t>(data.size());
     chunk_info.is_last = is_last_chunk;
@@ -178,16 +182,24 @@ bool SingleFileReceiver::handle_chunk(const transfer::FileChunkRequest& request)
     return true;
 }
 
-std::tuple<bool, std::string, std::string> SingleFileReceiver::finalize_and_verify() {
-    if (fs_.is_open()) {
-        fs_.flush();
-        fs_.close();
+std::tuple<bool, SingleFileReceiver::OptionalDigest, SingleFileReceiver::OptionalDigest>
+SingleFileReceiver::finalize_and_verify() {
+    // 关闭后再做整文件校验，缓存中的描述符随之释放
+    file_.reset();
+    if (files_ != nullptr) {
+        files_->release(dest_path_);
     }
 
     finalized_ = true;
 
-    auto actual_hash_opt = util::hash::sha256_file_hex(dest_path_);
-    std::string actual_hash = actual_hash_opt.value_or(std::string());
+    // 整文件校验需要把刚写完的文件重新读一遍，策略不要求时整个跳过
+    OptionalDigest actual_hash;
+    const bool verify_file = util::verifies_file(policy_) && expected_hash_.has_value();
+    if (verify_file) {
+        auto hash_file = [&] { return util::hash::sha256_file(dest_path_); };
+        actual_hash = cost_ ? cost_->track(bytes_received_, bytes_received_, hash_file)
+                            : hash_file();
+    }
 
     bool chunk_count_ok = expected_total_chunks_ == 0
                           || completed_chunks_ >= expected_total_chunks_;
@@ -195,8 +207,9 @@ std::tuple<bool, std::string, std::string> SingleFileReceiver::finalize_and_veri
         chunk_count_ok = false;
     }
 
-    const bool hash_ok = expected_hash_.empty()
-                         || (actual_hash_opt && actual_hash == expected_hash_);
+    const bool hash_ok = !verify_file
+                         || (actual_hash
+                             && util::hash::digest_equal(*actual_hash, *expected_hash_));
     const bool success = chunk_count_ok && hash_ok;
 
     if (!success) {
@@ -211,12 +224,12 @@ std::tuple<bool, std::string, std::string> SingleFileReceiver::finalize_and_veri
             spdlog::warn("[SingleFileReceiver::finalize_and_verify] Hash mismatch for {} (expected "
                          "{}, actual {})",
                          rel_path_,
-                         expected_hash_,
-                         actual_hash);
+                         util::hash::to_hex(*expected_hash_),
+                         actual_hash ? util::hash::to_hex(*actual_hash) : std::string("<none>"));
         }
     }
 
-    return {success, expected_hash_, actual_hash};
+    return {success, verify_file ? expected_hash_ : std::nullopt, actual_hash};
 }
 
 } // namespace receiver
@@ -1,10 +1,15 @@
 #pragma once
 
+#include "file_handle_cache.h"
 #include "transfer.pb.h"
+#include "util/hash.h"
+#include "util/verify.h"
 #include <cstdint>
 #include <filesystem>
-#include <fstream>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <vector>
 
@@ -12,26 +17,40 @@ namespace receiver {
 
 class SingleFileReceiver {
   public:
+    // expected_file_hash 为 FileInfoRequest.hash 中的原始摘要，为空表示不校验。
+    // policy 未包含的校验步骤直接跳过；cost 非空时记录校验开销。
+    // files 非空时经由共享的打开文件缓存写入，否则文件从创建到完成一直保持打开
     SingleFileReceiver(std::string relative_path,
-                       std::string expected_file_hash,
-                       std::uint64_t file_size = 0);
+                       std::string_view expected_file_hash,
+                       std::uint64_t file_size = 0,
+                       util::VerifyPolicy policy = transfer::TransferMetadataRequest::VERIFY_BOTH,
+                       util::VerifyCost* cost = nullptr,
+                       FileHandleCache* files = nullptr);
 
     const std::string& relative_path() const { return rel_path_; }
     const std::filesystem::path& destination_path() const { return dest_path_; }
+    // 只记录目标路径，不做任何磁盘操作；文件在第一个分块写入时才创建。
+    // 期望摘要非空却不是 32 字节时返回 false
     bool prepare_storage(const std::filesystem::path& dest_path);
-    bool is_ready() const { return fs_.is_open(); }
+    bool is_ready() const { return storage_prepared_; }
     bool is_valid() const { return true; } // Receiver is always valid after construction
     bool is_complete() const;
     std::uint64_t completed_chunks() const { return completed_chunks_; }
 
     bool handle_chunk(const transfer::FileChunkRequest& request);
 
-    std::tuple<bool, std::string, std::string> finalize_and_verify();
+    using OptionalDigest = std::optional<util::hash::Sha256Digest>;
+    std::tuple<bool, OptionalDigest, OptionalDigest> finalize_and_verify();
 
   private:
+    // 取得可写的目标文件，第一次调用时创建（截断）
+    std::shared_ptr<OpenFile> open_file();
+
     std::string rel_path_;
     std::filesystem::path dest_path_;
-    std::fstream fs_;
+    FileHandleCache* files_;
+    std::shared_ptr<OpenFile> file_; // 没有缓存时自己持有
+    bool created_ = false;
     std::uint64_t completed_chunks_ = 0;
 
     struct ChunkInfo {
@@ -39,14 +58,17 @@ class SingleFileReceiver {
         Status status = Status::InProgress;
         std::uint64_t offset = 0;
         std::uint32_t size = 0;
-        std::string hash;
+        std::optional<util::hash::Sha256Digest> hash;
         bool is_last = false;
     };
     std::vector<ChunkInfo> chunks_;
 
     std::uint64_t expected_total_chunks_ = 0;
     std::uint64_t file_size_ = 0;
-    std::string expected_hash_;
+    std::optional<util::hash::Sha256Digest> expected_hash_;
+    bool hash_malformed_; // 摘要非空但不是 32 字节
+    util::VerifyPolicy policy_;
+    util::VerifyCost* cost_;
     bool storage_prepared_ = false;
     std::uint64_t bytes_received_ = 0;
     bool last_chunk_received_ = false;
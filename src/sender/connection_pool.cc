@@ -0,0 +1,245 @@
+#include "connection_pool.h"
+#include "asio/dispatch.hpp"
+#include "asio/post.hpp"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace sender {
+
+namespace {
+using Duration = std::chrono::steady_clock::duration;
+
+Duration sweep_period(Duration idle_timeout) {
+    return std::max<Duration>(idle_timeout / 2, std::chrono::milliseconds(1));
+}
+
+// 关闭期间会话可能结束并被移除，由投递的回调持有它直到 close() 执行
+void close_session(std::shared_ptr<Session> session) {
+    const auto strand = session->strand();
+    asio::dispatch(strand, [session = std::move(session)]() { session->close(); });
+}
+} // namespace
+
+ConnectionPool::ConnectionPool(core::Executor& executor, ConnectionPoolOptions options)
+    : executor_(executor)
+    , options_(options)
+    , strand_(executor.make_serial_executor(executor.get_io_context()))
+    , lifetime_(std::make_shared<Lifetime>())
+    , sweeper_(std::make_shared<core::timer::Periodic<>>(strand_,
+                                                          sweep_period(options.idle_timeout))) {
+    lifetime_->pool = this;
+    executor_.spawn_on(strand_, run_sweeper(sweeper_, lifetime_));
+}
+
+ConnectionPool::~ConnectionPool() {
+    close_all();
+    // 等待正在执行的回调返回，之后的回调看到空指针直接退出
+    std::lock_guard lock(lifetime_->mutex);
+    lifetime_->pool = nullptr;
+}
+
+asio::awaitable<void> ConnectionPool::run_sweeper(std::shared_ptr<core::timer::Periodic<>> sweeper,
+                                                  std::shared_ptr<Lifetime> lifetime) {
+    co_await sweeper->run([&lifetime]() {
+        with_pool(lifetime, [](ConnectionPool& pool) { pool.sweep_idle(); });
+    });
+}
+
+std::shared_ptr<Session> ConnectionPool::acquire(const std::string& host, std::uint16_t port) {
+    const Peer peer{host, port};
+    if (auto session = take_existing(peer)) {
+        return session;
+    }
+    return connect(peer);
+}
+
+std::shared_ptr<Session> ConnectionPool::take_existing(const Peer& peer) {
+    std::lock_guard lock(mutex_);
+    Connection* best = nullptr;
+    for (auto& [id, connection] : connections_) {
+        if (connection.peer != peer || connection.closing) {
+            continue;
+        }
+        // 空闲连接要确认仍然存活；使用中的连接可能还在建立，断开时由 transfer() 重试
+        const bool usable = connection.borrowers == 0 ? connection.session->is_running()
+                                                       : options_.multiplex;
+        if (!usable) {
+            continue;
+        }
+        // 借出最少的优先，其次是最近归还的，越新的连接拥塞窗口越可能还没有回落
+        if (best == nullptr || connection.borrowers < best->borrowers
+            || (connection.borrowers == best->borrowers
+                && connection.idle_since > best->idle_since)) {
+            best = &connection;
+        }
+    }
+    if (best == nullptr) {
+        return nullptr;
+    }
+    ++best->borrowers;
+    spdlog::debug("[ConnectionPool::acquire] Reusing connection to {}:{} ({} borrowers)",
+                  peer.host,
+                  peer.port,
+                  best->borrowers);
+    return best->session;
+}
+
+std::shared_ptr<Session> ConnectionPool::connect(const Peer& peer) {
+    // 持锁构造：结束回调是投递执行的，在会话登记进 connections_ 之前不会运行
+    std::lock_guard lock(mutex_);
+    const auto id = next_id_++;
+    // 会话可能比连接池活得久，回调只捕获 lifetime 与 io_context
+    auto& io_context = executor_.get_io_context();
+    auto on_finished = [&io_context, lifetime = lifetime_, id]() {
+        asio::post(io_context, [lifetime, id]() {
+            with_pool(lifetime, [id](ConnectionPool& pool) { pool.remove_session(id); });
+        });
+    };
+    auto session = std::make_shared<Session>(executor_, peer.host, peer.port, on_finished);
+    connections_.emplace(id, Connection{peer, session, 1});
+    spdlog::debug("[ConnectionPool::acquire] Opening connection to {}:{}", peer.host, peer.port);
+    return session;
+}
+
+std::shared_ptr<Session> ConnectionPool::mark_closing(Connection& connection) {
+    connection.closing = true;
+    return connection.session;
+}
+
+void ConnectionPool::release(std::shared_ptr<Session> session) {
+    if (!session) {
+        return;
+    }
+    std::vector<std::shared_ptr<Session>> evicted;
+    {
+        std::lock_guard lock(mutex_);
+        auto released = std::find_if(
+            connections_.begin(), connections_.end(), [&](const auto& entry) {
+                return entry.second.session == session;
+            });
+        if (released == connections_.end()) {
+            return;
+        }
+        auto& connection = released->second;
+        if (connection.borrowers > 0 && --connection.borrowers > 0) {
+            return;
+        }
+        connection.idle_since = std::chrono::steady_clock::now();
+        if (connection.closing) {
+            return;
+        }
+        if (closed_ || !session->is_running()) {
+            evicted.push_back(mark_closing(connection));
+        } else {
+            // 该对端的空闲连接超出上限时，从最久未用的开始关闭
+            std::vector<Connection*> idle;
+            for (auto& [id, other] : connections_) {
+                if (other.peer == connection.peer && other.borrowers == 0 && !other.closing) {
+                    idle.push_back(&other);
+                }
+            }
+            std::sort(idle.begin(), idle.end(), [](const Connection* a, const Connection* b) {
+                return a->idle_since < b->idle_since;
+            });
+            for (std::size_t i = 0; i + options_.max_idle_per_peer < idle.size(); ++i) {
+                evicted.push_back(mark_closing(*idle[i]));
+            }
+        }
+    }
+    for (auto& entry : evicted) {
+        close_session(std::move(entry));
+    }
+}
+
+asio::awaitable<bool> ConnectionPool::transfer(const std::string& host,
+                                               std::uint16_t port,
+                                               std::vector<std::filesystem::path> paths,
+                                               std::uint32_t weight) {
+    const Peer peer{host, port};
+    auto session = take_existing(peer);
+    const bool reused = session != nullptr;
+    if (!reused) {
+        session = connect(peer);
+    }
+
+    bool success = co_await session->transfer(paths, weight);
+    if (!success && reused && !session->is_running()) {
+        // 对端在连接空闲期间关闭了它，或共用的连接没能建立，换一个新连接重试一次
+        spdlog::info("[ConnectionPool::transfer] Connection to {}:{} was closed, reconnecting",
+                     host,
+                     port);
+        release(std::move(session));
+        session = connect(peer);
+        success = co_await session->transfer(std::move(paths), weight);
+    }
+    release(std::move(session));
+    co_return success;
+}
+
+void ConnectionPool::close_all() {
+    std::vector<std::shared_ptr<Session>> idle;
+    {
+        std::lock_guard lock(mutex_);
+        closed_ = true;
+        for (auto& [id, connection] : connections_) {
+            if (connection.borrowers == 0 && !connection.closing) {
+                idle.push_back(mark_closing(connection));
+            }
+        }
+    }
+    for (auto& session : idle) {
+        close_session(std::move(session));
+    }
+    // 在定时器所在的 strand 上取消，投递的回调持有 sweeper，清理协程先退出也不会访问已销毁的定时器
+    asio::dispatch(strand_, [sweeper = sweeper_]() { sweeper->cancel(); });
+}
+
+void ConnectionPool::sweep_idle() {
+    std::vector<std::shared_ptr<Session>> expired;
+    {
+        std::lock_guard lock(mutex_);
+        const auto deadline = std::chrono::steady_clock::now() - options_.idle_timeout;
+        for (auto& [id, connection] : connections_) {
+            if (connection.borrowers > 0 || connection.closing) {
+                continue;
+            }
+            if (connection.idle_since <= deadline || !connection.session->is_running()) {
+                spdlog::debug("[ConnectionPool] Closing idle connection to {}:{}",
+                              connection.peer.host,
+                              connection.peer.port);
+                expired.push_back(mark_closing(connection));
+            }
+        }
+    }
+    for (auto& session : expired) {
+        close_session(std::move(session));
+    }
+}
+
+void ConnectionPool::remove_session(std::uint64_t id) {
+    std::shared_ptr<Session> finished;
+    {
+        std::lock_guard lock(mutex_);
+        auto it = connections_.find(id);
+        if (it == connections_.end()) {
+            return;
+        }
+        finished = std::move(it->second.session);
+        connections_.erase(it);
+    }
+    // 在锁外销毁会话
+}
+
+std::size_t ConnectionPool::idle_count() const {
+    std::lock_guard lock(mutex_);
+    return static_cast<std::size_t>(
+        std::count_if(connections_.begin(), connections_.end(), [](const auto& entry) {
+            return entry.second.borrowers == 0 && !entry.second.closing;
+        }));
+}
+
+std::size_t ConnectionPool::open_count() const {
+    std::lock_guard lock(mutex_);
+    return connections_.size();
+}
+} // namespace sender
@@ -0,0 +1,108 @@
+#pragma once
+#include "asio/any_io_executor.hpp"
+#include "asio/awaitable.hpp"
+#include "core/executor.h"
+#include "core/timer/periodic.h"
+#include "session.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sender {
+
+struct ConnectionPoolOptions {
+    std::chrono::steady_clock::duration idle_timeout = std::chrono::seconds(60);
+    std::size_t max_idle_per_peer = 2;
+    // 发往同一对端的并发传输共用一个连接，各占连接上的一个流；关闭时每个传输独占一个连接
+    bool multiplex = true;
+};
+
+// 到对端的长连接池。传输结束后连接归还到池中保持空闲，之后发往同一对端的传输直接复用，
+// 省去 TCP 握手与慢启动，已经增长的拥塞窗口也得以保留。
+// 空闲超过 idle_timeout 的连接由定期清理关闭，每个对端最多保留 max_idle_per_peer 个空闲连接。
+// 开启 multiplex 时正在使用的连接也可以再借出，并发传输在同一连接上按流公平交错。
+// 线程安全。销毁前正在进行的 transfer() 必须已经结束；借出的会话、投递中的回调与定期清理
+// 可以晚于连接池结束，析构会等待正在执行的回调返回，之后到来的回调不再访问连接池
+class ConnectionPool {
+  public:
+    explicit ConnectionPool(core::Executor& executor, ConnectionPoolOptions options = {});
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // 借出到 host:port 的连接：优先复用（multiplex 时包括使用中的），没有可用的时新建一个
+    std::shared_ptr<Session> acquire(const std::string& host, std::uint16_t port);
+    // 传输结束后归还连接，已断开的连接直接丢弃
+    void release(std::shared_ptr<Session> session);
+
+    // 借连接、传输、归还，全部文件成功时返回 true。weight 为该传输在共用连接上的发送权重
+    asio::awaitable<bool> transfer(const std::string& host,
+                                   std::uint16_t port,
+                                   std::vector<std::filesystem::path> paths,
+                                   std::uint32_t weight = 1);
+
+    // 关闭所有空闲连接并停止定期清理，使用中的连接在归还时关闭
+    void close_all();
+
+    std::size_t idle_count() const;
+    // 尚未结束的连接数，包括空闲、使用中与正在关闭的
+    std::size_t open_count() const;
+
+  private:
+    struct Peer {
+        std::string host;
+        std::uint16_t port = 0;
+        bool operator==(const Peer&) const = default;
+    };
+    struct Connection {
+        Peer peer;
+        std::shared_ptr<Session> session;
+        std::size_t borrowers = 0; // 借出次数，为 0 时连接空闲
+        bool closing = false;
+        std::chrono::steady_clock::time_point idle_since;
+    };
+
+    // 没有可复用的连接时返回空
+    std::shared_ptr<Session> take_existing(const Peer& peer);
+    std::shared_ptr<Session> connect(const Peer& peer);
+    // 调用方持有 mutex_，返回需要在锁外关闭的会话
+    std::shared_ptr<Session> mark_closing(Connection& connection);
+    void sweep_idle();
+    void remove_session(std::uint64_t id);
+
+    // 会话结束回调与清理协程通过它访问连接池，析构时在 mutex 下置空 pool
+    struct Lifetime {
+        std::mutex mutex;
+        ConnectionPool* pool = nullptr;
+    };
+    // 连接池仍然存在时在 lifetime 的锁内执行 action
+    template<typename Action>
+    static void with_pool(const std::shared_ptr<Lifetime>& lifetime, Action&& action) {
+        std::lock_guard lock(lifetime->mutex);
+        if (lifetime->pool != nullptr) {
+            action(*lifetime->pool);
+        }
+    }
+    static asio::awaitable<void> run_sweeper(std::shared_ptr<core::timer::Periodic<>> sweeper,
+                                             std::shared_ptr<Lifetime> lifetime);
+
+    core::Executor& executor_;
+    const ConnectionPoolOptions options_;
+    asio::any_io_executor strand_;
+    std::shared_ptr<Lifetime> lifetime_;
+    // 清理协程持有它，协程结束前定时器不会销毁
+    std::shared_ptr<core::timer::Periodic<>> sweeper_;
+
+    mutable std::mutex mutex_;
+    bool closed_ = false;
+    std::unordered_map<std::uint64_t, Connection> connections_;
+    std::uint64_t next_id_ = 0;
+};
+} // namespace sender
@@ -0,0 +1,84 @@
+#include "file_scheduler.h"
+#include <algorithm>
+
+namespace sender {
+
+namespace {
+void order_files(std::vector<FileScheduler::File>& files, FileOrder order) {
+    const auto by_size = [](const FileScheduler::File& a, const FileScheduler::File& b) {
+        return a.size < b.size || (a.size == b.size && a.path < b.path);
+    };
+    switch (order) {
+    case FileOrder::SizeAscending:
+        std::sort(files.begin(), files.end(), by_size);
+        break;
+    case FileOrder::SizeDescending:
+        std::sort(files.begin(), files.end(), [&](const auto& a, const auto& b) {
+            return by_size(b, a);
+        });
+        break;
+    case FileOrder::Interleaved: {
+        std::sort(files.begin(), files.end(), by_size);
+        // 从两端交替取：最大、最小、次大、次小……
+        std::vector<FileScheduler::File> interleaved;
+        interleaved.reserve(files.size());
+        std::size_t low = 0;
+        std::size_t high = files.size();
+        while (low < high) {
+            interleaved.push_back(std::move(files[--high]));
+            if (low < high) {
+                interleaved.push_back(std::move(files[low++]));
+            }
+        }
+        files = std::move(interleaved);
+        break;
+    }
+    case FileOrder::ByPath:
+        std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) {
+            return a.path < b.path;
+        });
+        break;
+    }
+}
+} // namespace
+
+FileScheduler::FileScheduler(std::vector<File> files, FileSchedulerOptions options)
+    : max_active_(std::max<std::size_t>(options.max_active_files, 1))
+    , order_(options.order) {
+    add(std::move(files));
+}
+
+void FileScheduler::add(std::vector<File> files) {
+    std::size_t max_index = states_.size();
+    for (const auto& file : files) {
+        max_index = std::max(max_index, file.index + 1);
+    }
+    states_.resize(max_index, State::Finished);
+
+    order_files(files, order_);
+    queue_.reserve(queue_.size() + files.size());
+    for (const auto& file : files) {
+        queue_.push_back(file.index);
+        states_[file.index] = State::Pending;
+    }
+}
+
+std::optional<std::size_t> FileScheduler::next() {
+    if (active_ >= max_active_ || position_ >= queue_.size()) {
+        return std::nullopt;
+    }
+    const auto index = queue_[position_++];
+    states_[index] = State::Active;
+    ++active_;
+    return index;
+}
+
+bool FileScheduler::finish(std::size_t index) {
+    if (index >= states_.size() || states_[index] != State::Active) {
+        return false;
+    }
+    states_[index] = State::Finished;
+    --active_;
+    return true;
+}
+} // namespace sender
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace sender {
+
+// 文件的发送顺序
+enum class FileOrder {
+    SizeAscending,  // 小文件先发，尽快完成尽可能多的文件
+    SizeDescending, // 大文件先发，长尾最短
+    Interleaved,    // 大小交替：大文件保持管道满载，小文件穿插其间不必排在最后
+    ByPath,         // 按路径排序，同一目录的文件相邻，磁盘访问最接近顺序
+};
+
+struct FileSchedulerOptions {
+    // 同时在读取与发送中的文件数，0 按 1 处理
+    std::size_t max_active_files = 4;
+    FileOrder order = FileOrder::Interleaved;
+};
+
+// 一次传输内的文件调度：按 order 排好队，同时最多 max_active_files 个文件处于活动状态，
+// 一个文件结束（接收端确认或失败）后才开始下一个。
+// 避免大目录一次性打开所有文件、并行读取造成的随机寻道与 fd 耗尽。不是线程安全的
+class FileScheduler {
+  public:
+    struct File {
+        std::size_t index; // 调用方的文件下标
+        std::uint64_t size;
+        std::string path;
+    };
+
+    FileScheduler(std::vector<File> files, FileSchedulerOptions options);
+
+    // 追加一批文件（分页清单的后续页），排在已有文件之后，顺序策略只在这一批内部生效
+    void add(std::vector<File> files);
+
+    // 取出下一个可以开始的文件，活动文件已满或没有待发文件时返回 nullopt
+    std::optional<std::size_t> next();
+    // 标记活动文件 index 结束，未处于活动状态时返回 false（例如重复通知）
+    bool finish(std::size_t index);
+
+    std::size_t active_count() const { return active_; }
+    std::size_t pending_count() const { return queue_.size() - position_; }
+
+  private:
+    enum class State : std::uint8_t { Pending, Active, Finished };
+
+    std::size_t max_active_;
+    FileOrder order_;
+    std::vector<std::size_t> queue_; // 按发送顺序排列的文件下标
+    std::size_t position_ = 0;
+    std::size_t active_ = 0;
+    std::vector<State> states_; // 按调用方的文件下标索引
+};
+} // namespace sender
@@ -0,0 +1,343 @@
+#include "file_walker.h"
+#include <algorithm>
+#include <asio/post.hpp>
+#include <asio/redirect_error.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/this_coro.hpp>
+#include <asio/use_awaitable.hpp>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+#endif
+
+namespace sender {
+
+namespace {
+// 单个目录中每发现这么多文件就交给调用方一次，超大目录不必读完才开始发送
+constexpr std::size_t kFlushEntries = 256;
+
+#if defined(__linux__)
+struct LinuxDirent64 {
+    ino64_t d_ino;
+    off64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+enum class Kind { Other, File, Directory };
+
+struct FileStat {
+    Kind kind = Kind::Other;
+    std::uint64_t size = 0;
+    std::int64_t mtime_ns = 0;
+    std::uint64_t inode = 0;
+    std::uint64_t device = 0;
+    std::int64_t ctime_ns = 0;
+};
+
+// 相对目录描述符取文件属性；不要求网络文件系统与服务端同步元数据
+FileStat stat_at(int dir_fd, const char* name, bool follow) {
+    FileStat result;
+#if defined(STATX_BASIC_STATS)
+    struct statx stx {};
+    const int flags = AT_STATX_DONT_SYNC | (follow ? 0 : AT_SYMLINK_NOFOLLOW);
+    const unsigned mask = STATX_TYPE | STATX_SIZE | STATX_MTIME | STATX_CTIME | STATX_INO;
+    if (::statx(dir_fd, name, flags, mask, &stx) != 0) {
+        return result;
+    }
+    const auto mode = stx.stx_mode;
+    result.size = stx.stx_size;
+    result.mtime_ns = static_cast<std::int64_t>(stx.stx_mtime.tv_sec) * 1'000'000'000
+                      + stx.stx_mtime.tv_nsec;
+    result.ctime_ns = static_cast<std::int64_t>(stx.stx_ctime.tv_sec) * 1'000'000'000
+                      + stx.stx_ctime.tv_nsec;
+    result.inode = stx.stx_ino;
+    result.device = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+#else
+    struct stat st {};
+    if (::fstatat(dir_fd, name, &st, follow ? 0 : AT_SYMLINK_NOFOLLOW) != 0) {
+        return result;
+    }
+    const auto mode = st.st_mode;
+    result.size = static_cast<std::uint64_t>(st.st_size);
+    result.mtime_ns = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1'000'000'000
+                      + st.st_mtim.tv_nsec;
+    result.ctime_ns = static_cast<std::int64_t>(st.st_ctim.tv_sec) * 1'000'000'000
+                      + st.st_ctim.tv_nsec;
+    result.inode = st.st_ino;
+    result.device = st.st_dev;
+#endif
+    if (S_ISREG(mode)) {
+        result.kind = Kind::File;
+    } else if (S_ISDIR(mode)) {
+        result.kind = Kind::Directory;
+    }
+    return result;
+}
+#endif
+} // namespace
+
+struct FileWalker::State {
+    explicit State(core::Executor& executor)
+        : executor(executor) {}
+
+    core::Executor& executor;
+    std::atomic<bool> cancelled{false};
+
+    mutable std::mutex mutex;
+    std::deque<Entry> entries;
+    std::size_t pending_directories = 0; // 已提交、尚未读完的目录数（包括根路径任务）
+    // 等待中的 next() 登记的唤醒回调，有新文件或遍历结束时调用一次后清除
+    std::function<void()> waiter;
+    std::optional<std::filesystem::filesystem_error> error; // 第一个读取失败的目录
+
+    // 调用方持有 mutex
+    void wake() {
+        if (waiter) {
+            std::exchange(waiter, nullptr)();
+        }
+    }
+};
+
+FileWalker::FileWalker(core::Executor& executor, std::vector<std::filesystem::path> roots)
+    : roots_(std::move(roots))
+    , state_(std::make_shared<State>(executor)) {}
+
+FileWalker::~FileWalker() {
+    // 仍在计算线程池中的任务持有 state_，读到的目录不再展开
+    state_->cancelled.store(true, std::memory_order_relaxed);
+    std::lock_guard lock(state_->mutex);
+    state_->waiter = nullptr;
+}
+
+void FileWalker::start() {
+    started_ = true;
+    // 根路径的 stat 也放到计算线程池上，路径很多时不占用调用方的 io 线程
+    {
+        std::lock_guard lock(state_->mutex);
+        ++state_->pending_directories;
+    }
+    state_->executor.get_cpu_pool().submit([state = state_, roots = std::move(roots_)]() {
+        scan_roots(state, roots);
+        std::lock_guard lock(state->mutex);
+        if (--state->pending_directories == 0) {
+            state->wake();
+        }
+    });
+}
+
+void FileWalker::scan_roots(const std::shared_ptr<State>& state,
+                            const std::vector<std::filesystem::path>& roots) {
+    std::vector<Entry> files;
+    std::error_code ec;
+    for (const auto& root : roots) {
+        const auto status = std::filesystem::symlink_status(root, ec);
+        if (ec) {
+            continue;
+        }
+        if (std::filesystem::is_regular_file(status)) {
+            const auto size = std::filesystem::file_size(root, ec);
+            if (!ec) {
+                files.push_back({root.filename(), root, size});
+            }
+        } else if (std::filesystem::is_directory(status)) {
+            submit(state, {root, {}});
+        }
+    }
+    found(*state, files);
+}
+
+void FileWalker::submit(const std::shared_ptr<State>& state, Directory directory) {
+    if (state->cancelled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    {
+        std::lock_guard lock(state->mutex);
+        ++state->pending_directories;
+    }
+    state->executor.get_cpu_pool().submit([state, directory = std::move(directory)]() {
+        if (!state->cancelled.load(std::memory_order_relaxed)) {
+            scan(state, directory);
+        }
+        std::lock_guard lock(state->mutex);
+        if (--state->pending_directories == 0) {
+            state->wake();
+        }
+    });
+}
+
+void FileWalker::scan(const std::shared_ptr<State>& state, const Directory& directory) {
+    std::vector<Entry> files;
+    auto add_file = [&](std::string_view name, Entry entry) {
+        entry.relative = directory.relative / name;
+        entry.absolute = directory.absolute / name;
+        files.push_back(std::move(entry));
+        if (files.size() >= kFlushEntries) {
+            found(*state, files);
+        }
+    };
+
+#if defined(__linux__)
+    const int dir_fd = ::open(directory.absolute.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) {
+        return;
+    }
+    thread_local std::vector<char> buffer(64 * 1024);
+    while (!state->cancelled.load(std::memory_order_relaxed)) {
+        const auto bytes = ::syscall(SYS_getdents64, dir_fd, buffer.data(), buffer.size());
+        if (bytes < 0) {
+            // 读到一半失败时目录内容不完整，不能当作读完
+            failed(*state, directory.absolute, std::error_code(errno, std::generic_category()));
+            break;
+        }
+        if (bytes == 0) {
+            break;
+        }
+        for (long offset = 0; offset < bytes;) {
+            const auto* dirent = reinterpret_cast<const LinuxDirent64*>(buffer.data() + offset);
+            offset += dirent->d_reclen;
+            const std::string_view name(dirent->d_name);
+            if (name == "." || name == "..") {
+                continue;
+            }
+            if (dirent->d_type == DT_DIR) {
+                submit(state, {directory.absolute / name, directory.relative / name});
+                continue;
+            }
+            // 类型未知时先不跟随链接判断，指向目录的链接不进入；指向文件的链接按文件发送
+            auto stat = stat_at(dir_fd, dirent->d_name, dirent->d_type != DT_UNKNOWN);
+            if (dirent->d_type == DT_UNKNOWN && stat.kind == Kind::Directory) {
+                submit(state, {directory.absolute / name, directory.relative / name});
+                continue;
+            }
+            if (dirent->d_type == DT_UNKNOWN && stat.kind == Kind::Other) {
+                stat = stat_at(dir_fd, dirent->d_name, true);
+            }
+            if (stat.kind == Kind::File) {
+                add_file(
+                    name,
+                    {{}, {}, stat.size, stat.mtime_ns, stat.inode, stat.device, stat.ctime_ns});
+            }
+        }
+    }
+    ::close(dir_fd);
+#else
+    std::error_code ec;
+    std::filesystem::directory_iterator it(
+        directory.absolute, std::filesystem::directory_options::skip_permission_denied, ec);
+    if (ec) {
+        return;
+    }
+    for (; !ec && it != std::filesystem::directory_iterator{}
+           && !state->cancelled.load(std::memory_order_relaxed);
+         it.increment(ec)) {
+        const auto name = it->path().filename();
+        if (it->is_directory(ec) && !it->is_symlink(ec)) {
+            submit(state, {it->path(), directory.relative / name});
+            continue;
+        }
+        if (!it->is_regular_file(ec)) {
+            continue;
+        }
+        const auto size = it->file_size(ec);
+        const auto mtime = it->last_write_time(ec);
+        if (ec) {
+            ec.clear();
+            continue;
+        }
+        const auto mtime_ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch());
+        add_file(name.string(), {{}, {}, size, mtime_ns.count()});
+    }
+    if (ec) {
+        failed(*state, directory.absolute, ec);
+    }
+#endif
+    found(*state, files);
+}
+
+void FileWalker::failed(State& state,
+                        const std::filesystem::path& directory,
+                        std::error_code error) {
+    std::lock_guard lock(state.mutex);
+    if (!state.error) {
+        state.error.emplace("failed to read directory", directory, error);
+    }
+    // 清单已经不完整，停止展开其余目录，next() 尽快返回
+    state.cancelled.store(true, std::memory_order_relaxed);
+}
+
+void FileWalker::found(State& state, std::vector<Entry>& entries) {
+    if (entries.empty()) {
+        return;
+    }
+    std::lock_guard lock(state.mutex);
+    for (auto& entry : entries) {
+        state.entries.push_back(std::move(entry));
+    }
+    entries.clear();
+    state.wake();
+}
+
+asio::awaitable<std::vector<FileWalker::Entry>> FileWalker::next(std::size_t max) {
+    if (!started_) {
+        start();
+    }
+    const auto executor = co_await asio::this_coro::executor;
+    // 工作线程通过投递取消定时器唤醒这里；回调可能晚于本次 next() 到达，定时器由双方共同持有
+    const auto wake = std::make_shared<asio::steady_timer>(executor);
+    const auto page_deadline = std::chrono::steady_clock::now() + kMaxPageDelay;
+    std::vector<Entry> result;
+    while (true) {
+        {
+            std::lock_guard lock(state_->mutex);
+            const auto now = std::chrono::steady_clock::now();
+            // 凑不满一页时最多等待到 page_deadline，之后至少等到一个文件，不发送空页
+            const bool ready = state_->entries.size() >= max || state_->pending_directories == 0
+                               || (!state_->entries.empty() && now >= page_deadline);
+            if (ready) {
+                state_->waiter = nullptr;
+                const auto count = std::min(max, state_->entries.size());
+                result.reserve(count);
+                for (std::size_t i = 0; i < count; ++i) {
+                    result.push_back(std::move(state_->entries.front()));
+                    state_->entries.pop_front();
+                }
+                break;
+            }
+            state_->waiter = [executor, wake]() {
+                asio::post(executor, [wake]() { wake->cancel(); });
+            };
+            // 唤醒在开始等待之前到达时，最多晚一个 kMaxPageDelay 重新检查
+            wake->expires_at(now < page_deadline ? page_deadline : now + kMaxPageDelay);
+        }
+        asio::error_code ec;
+        co_await wake->async_wait(asio::redirect_error(asio::use_awaitable, ec));
+    }
+    co_return result;
+}
+
+std::optional<std::filesystem::filesystem_error> FileWalker::error() const {
+    std::lock_guard lock(state_->mutex);
+    return state_->error;
+}
+
+bool FileWalker::done() const {
+    std::lock_guard lock(state_->mutex);
+    return started_ && state_->pending_directories == 0 && state_->entries.empty();
+}
+} // namespace sender
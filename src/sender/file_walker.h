@@ -0,0 +1,71 @@
+#pragma once
+
+#include "core/executor.h"
+#include <asio/awaitable.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <system_error>
+#include <vector>
+
+namespace sender {
+
+// 并行遍历待发送的路径：各目录作为任务在执行器的计算线程池上并行读取，
+// 发现的文件进入队列，调用方按页取出，清单因此可以边遍历边发送。
+// Linux 上以 getdents64 读取目录、以 statx 相对目录描述符一次取得大小、修改时间与 inode，
+// 不再为每个文件重新解析完整路径。文件的顺序不确定。
+// next() 是协程，等待期间不占用线程；同一时间只能有一个 next() 在进行
+class FileWalker {
+  public:
+    struct Entry {
+        std::filesystem::path relative; // 相对所在的根目录；根本身是文件时为文件名
+        std::filesystem::path absolute;
+        std::uint64_t size;
+        // 以下属性来自遍历时的 statx，直接用作摘要缓存的键；inode 为 0 表示平台不提供
+        std::int64_t mtime_ns = 0;
+        std::uint64_t inode = 0;
+        std::uint64_t device = 0;
+        std::int64_t ctime_ns = 0;
+    };
+
+    FileWalker(core::Executor& executor, std::vector<std::filesystem::path> roots);
+    ~FileWalker();
+
+    FileWalker(const FileWalker&) = delete;
+    FileWalker& operator=(const FileWalker&) = delete;
+
+    // 取出最多 max 个文件，遍历结束后返回空。凑不满一页时最多等待 kMaxPageDelay，
+    // 已发现的文件先行返回。不存在或无法打开的路径与目录被跳过，不跟随指向目录的符号链接
+    asio::awaitable<std::vector<Entry>> next(std::size_t max);
+    bool done() const;
+    // 目录打开后读取失败时清单不完整，返回第一个错误并停止遍历；调用方应让传输失败
+    std::optional<std::filesystem::filesystem_error> error() const;
+
+    static constexpr auto kMaxPageDelay = std::chrono::milliseconds(50);
+
+  private:
+    struct Directory {
+        std::filesystem::path absolute;
+        std::filesystem::path relative;
+    };
+    // 遍历的共享状态。任务持有它，FileWalker 先销毁时尚未执行的任务直接结束
+    struct State;
+
+    void start();
+    static void submit(const std::shared_ptr<State>& state, Directory directory);
+    static void scan_roots(const std::shared_ptr<State>& state,
+                           const std::vector<std::filesystem::path>& roots);
+    static void scan(const std::shared_ptr<State>& state, const Directory& directory);
+    static void found(State& state, std::vector<Entry>& entries);
+    static void failed(State& state,
+                       const std::filesystem::path& directory,
+                       std::error_code error);
+
+    std::vector<std::filesystem::path> roots_;
+    bool started_ = false;
+    std::shared_ptr<State> state_;
+};
+} // namespace sender
@@ -1,99 +1,387 @@
 #include "session.h"
+#include "asio/co_spawn.hpp"
+#include "asio/redirect_error.hpp"
+#include "asio/use_awaitable.hpp"
 #include "core/executor.h"
+#include "file_walker.h"
 #include "transfer.pb.h"
 #include "util/data_block.h"
+#include "util/file_hash_cache.h"
 #include "util/hash.h"
+#include <algorithm>
 #include <cstdint>
+#include <exception>
+#include <fstream>
+#include <optional>
 #include <spdlog/spdlog.h>
 #include <string>
 
 namespace sender {
+namespace {
+// 遍历时 statx 取得的属性作为摘要缓存的键；平台不提供 inode 时为空，由缓存自己 stat
+std::optional<util::FileHashCache::FileKey> cache_key(const FileWalker::Entry& entry) {
+    if (entry.inode == 0) {
+        return std::nullopt;
+    }
+    return util::FileHashCache::FileKey{
+        entry.device, entry.inode, entry.size, entry.mtime_ns, entry.ctime_ns};
+}
+
+std::optional<util::hash::FileDigests> cache_lookup(util::FileHashCache& cache,
+                                                    const FileWalker::Entry& entry) {
+    const auto key = cache_key(entry);
+    return key ? cache.lookup(*key) : cache.lookup(entry.absolute);
+}
+} // namespace
+
 asio::awaitable<void> Session::start() {
     co_await core::net::io::Session::start();
-    metadata_request_.Clear();
+    // 长连接会话的传输由 transfer() 发起；构造时给出的文件只发送一次
+    if (keep_alive_ || started_) {
+        co_return;
+    }
+    started_ = true;
+    auto transfer = begin_transfer(0, paths_);
+    co_await send_metadata(*transfer);
+}
+
+asio::awaitable<bool> Session::transfer(std::vector<std::filesystem::path> paths,
+                                        std::uint32_t weight) {
+    co_return co_await asio::co_spawn(strand(),
+                                      run_transfer(std::move(paths), weight),
+                                      asio::use_awaitable);
+}
+
+std::shared_ptr<Session::Transfer> Session::begin_transfer(
+    std::uint32_t stream_id, std::vector<std::filesystem::path> paths) {
+    auto transfer = std::make_shared<Transfer>(strand());
+    transfer->stream_id = stream_id;
+    transfer->paths = std::move(paths);
+    transfers_[stream_id] = transfer;
+    return transfer;
+}
+
+asio::awaitable<bool> Session::run_transfer(std::vector<std::filesystem::path> paths,
+                                            std::uint32_t weight) {
+    const auto stream_id = next_stream_id_++;
+    auto transfer = begin_transfer(stream_id, std::move(paths));
+    set_stream_weight(stream_id, weight);
+
+    try {
+        co_await send_metadata(*transfer);
+    } catch (const std::exception& e) {
+        spdlog::warn("[Session::transfer] Failed to send metadata: {}", e.what());
+        finish_transfer(*transfer, false);
+    }
+    if (!is_running()) {
+        finish_transfer(*transfer, false);
+    }
+    while (!transfer->result.has_value()) {
+        transfer->done.expires_at(asio::steady_timer::time_point::max());
+        asio::error_code ec;
+        co_await transfer->done.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+    }
+    co_return *transfer->result;
+}
+
+void Session::finish_transfer(Transfer& transfer, bool success) {
+    if (!transfer.result.has_value()) {
+        transfer.result = success;
+    }
+    transfer.done.cancel();
+    // 结束后流不再使用，分块都已确认的发送器随传输一起释放
+    reset_stream_weight(transfer.stream_id);
+    const auto it = transfers_.find(transfer.stream_id);
+    if (it != transfers_.end() && it->second.get() == &transfer) {
+        transfers_.erase(it);
+    }
+}
+
+void Session::receive_stopped() {
+    // finish_transfer 会从 transfers_ 中移除，先取出来
+    auto transfers = std::move(transfers_);
+    transfers_.clear();
+    for (auto& [stream_id, transfer] : transfers) {
+        finish_transfer(*transfer, false);
+    }
+}
+
+asio::awaitable<void> Session::send_metadata(Transfer& transfer) {
+    FileWalker walker(executor_, transfer.paths);
     std::uint64_t total_size = 0;
     //!TODO: 这里的每个文件都读取了3次，考虑优化
-    prepare_file_paths();
+    // 失败应答会先结束传输，之后的页不再发送
+    while (!transfer.result.has_value()) {
+        const std::size_t first = transfer.file_paths.size();
+        transfer::TransferMetadataRequest page;
+        page.set_verify_policy(verify_policy_);
+        page.set_first_file_index(first);
 
-    for (std::size_t i = 0; i < file_paths_.size(); ++i) {
-        auto& file_path = file_paths_[i];
-        auto* file_info = metadata_request_.add_files();
-        file_info->set_relative_path(file_path.relative.string());
+        // 遍历与计算摘要都在计算线程池上进行，等待下一页时不占用线程
+        auto entries = co_await walker.next(kManifestPageSize);
+        const bool more_pages = !walker.done();
+        // 目录没能读完时清单不完整，不发送这一页，整个传输失败
+        if (const auto error = walker.error()) {
+            spdlog::error("[Session::send_metadata] {}", error->what());
+            finish_transfer(transfer, false);
+            co_return;
+        }
+        auto digests = co_await executor_.offload(
+            [&]() { return compute_page_digests(entries, transfer.verify_cost); });
 
-        const auto file_size = std::filesystem::file_size(file_path.absolute);
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            auto& entry = entries[i];
+            auto& digest = digests[i];
+            FilePath file_path{std::move(entry.relative),
+                               std::move(entry.absolute),
+                               FilePath::Status::InProgress,
+                               first + i};
+            auto& file_info = transfer.file_infos.emplace_back();
+            file_info.set_relative_path(file_path.relative.string());
+            file_info.set_size(entry.size);
+            total_size += entry.size;
+            // 打包文件整体只有一次写入，用整文件摘要代替分块摘要
+            file_path.packed = pack_threshold_ > 0 && entry.size <= pack_threshold_;
+            file_info.set_packed(file_path.packed);
 
-        file_info->set_size(file_size);
-        total_size += file_size;
+            if (digest && (file_path.packed || util::verifies_file(verify_policy_))) {
+                file_info.set_hash(digest->file.data(), digest->file.size());
+            }
+            if (digest && !file_path.packed && util::verifies_chunks(verify_policy_)) {
+                file_path.chunk_hashes = std::move(digest->chunks);
+            }
+            transfer.file_indices.emplace(file_info.relative_path(), first + i);
+            *page.add_files() = file_info;
+            transfer.file_paths.push_back(std::move(file_path));
+        }
 
-        const auto file_hash = util::hash::sha256_file_hex(file_path.absolute);
-        if (file_hash) {
-            file_info->set_hash(*file_hash); // 解引用 optional
+        page.set_total_size(total_size);
+        page.set_more_pages(more_pages);
+        transfer.pending_pages.emplace(first, entries.size());
+        transfer.file_senders.resize(transfer.file_paths.size());
+        co_await send(transfer.stream_id, page);
+        if (!more_pages) {
+            break;
         }
-        file_path.file_index = i;
     }
-    metadata_request_.set_total_size(total_size);
-    co_await send(metadata_request_);
+    util::FileHashCache::instance().flush();
 }
 
-void Session::prepare_file_paths() {
-    file_paths_.clear();
-
-    std::error_code status_ec;
+std::vector<std::optional<util::hash::FileDigests>> Session::compute_page_digests(
+    const std::vector<FileWalker::Entry>& entries, util::VerifyCost& cost) const {
+    std::vector<std::optional<util::hash::FileDigests>> result(entries.size());
+    if (verify_policy_ == transfer::TransferMetadataRequest::VERIFY_NONE) {
+        return result;
+    }
 
-    for (const auto& path : paths_) {
-        status_ec.clear();
-        const auto status = std::filesystem::symlink_status(path, status_ec);
-        if (status_ec) {
+    // 打包的小文件只需整文件摘要，缓存未命中的集中起来批量计算
+    auto& cache = util::FileHashCache::instance();
+    std::vector<std::size_t> small;
+    std::vector<std::filesystem::path> small_paths;
+    std::uint64_t small_bytes = 0;
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const auto& entry = entries[i];
+        if (pack_threshold_ == 0 || entry.size > pack_threshold_) {
+            result[i] = compute_digests(entry, cost);
             continue;
         }
-        if (std::filesystem::is_regular_file(status)) {
-            file_paths_.emplace_back(path.filename(), path, FilePath::Status::InProgress, 0);
+        if (auto cached = cache_lookup(cache, entry)) {
+            result[i] = std::move(cached);
             continue;
         }
-        if (!std::filesystem::is_directory(status)) {
-            continue;
+        small.push_back(i);
+        small_paths.push_back(entry.absolute);
+        small_bytes += entry.size;
+    }
+    if (small.empty()) {
+        return result;
+    }
+
+    const auto small_digests = cost.track(
+        small_bytes, small_bytes, [&]() { return util::hash::sha256_files(small_paths); });
+    for (std::size_t i = 0; i < small.size(); ++i) {
+        if (small_digests[i]) {
+            result[small[i]] = util::hash::FileDigests{*small_digests[i], {}};
+        }
+    }
+    return result;
+}
+
+std::optional<util::hash::FileDigests> Session::compute_digests(const FileWalker::Entry& entry,
+                                                                util::VerifyCost& cost) const {
+    // 未变化的文件直接复用缓存中的整文件与分块摘要，不产生校验开销
+    auto& cache = util::FileHashCache::instance();
+    if (auto cached = cache_lookup(cache, entry)) {
+        return cached;
+    }
+    const auto& path = entry.absolute;
+    const auto file_size = entry.size;
+
+    // 需要分块摘要时一次读取同时算出两种摘要并写入缓存；只要整文件摘要时不做多余的分块计算
+    const bool with_chunks = util::verifies_chunks(verify_policy_);
+    const auto bytes_hashed = with_chunks ? file_size * 2 : file_size;
+    auto compute = [&]() -> std::optional<util::hash::FileDigests> {
+        if (with_chunks) {
+            const auto key = cache_key(entry);
+            return key ? cache.get_or_compute(path, *key) : cache.get_or_compute(path);
         }
+        auto file_digest = util::hash::sha256_file(path);
+        if (!file_digest) {
+            return std::nullopt;
+        }
+        return util::hash::FileDigests{*file_digest, {}};
+    };
+    return cost.track(bytes_hashed, file_size, compute);
+}
 
-        std::error_code iter_ec;
-        auto it = std::filesystem::recursive_directory_iterator(
-            path, std::filesystem::directory_options::skip_permission_denied, iter_ec);
-        if (iter_ec) {
+void Session::start_page(const std::shared_ptr<Transfer>& transfer,
+                         std::size_t first_file_index) {
+    // 接收端建好一页的目录后才确认，各页的 READY 不一定按发出的顺序到达
+    const auto page = transfer->pending_pages.find(first_file_index);
+    if (page == transfer->pending_pages.end()) {
+        spdlog::warn("[Session::start_page] Unexpected READY for file {} on stream {}",
+                     first_file_index,
+                     transfer->stream_id);
+        return;
+    }
+    const auto [first, count] = *page;
+    transfer->pending_pages.erase(page);
+
+    std::vector<FileScheduler::File> files;
+    std::vector<std::size_t> packed;
+    for (std::size_t i = first; i < first + count; ++i) {
+        const auto& file_path = transfer->file_paths[i];
+        auto& info = transfer->file_infos[i];
+        if (file_path.packed) {
+            packed.push_back(i);
             continue;
         }
+        transfer->file_senders[i] = std::make_unique<SingleFileSender>(executor_,
+                                                                       *this,
+                                                                       info,
+                                                                       file_path.absolute,
+                                                                       file_path.chunk_hashes,
+                                                                       verify_policy_,
+                                                                       &transfer->verify_cost,
+                                                                       transfer->stream_id);
+        files.push_back({i, info.size(), info.relative_path()});
+    }
+    if (transfer->scheduler) {
+        transfer->scheduler->add(std::move(files));
+    } else {
+        transfer->scheduler.emplace(std::move(files), file_scheduling_);
+    }
+    schedule_files(transfer);
+    // 打包文件不占调度器名额，与大文件并行发送
+    if (!packed.empty()) {
+        spawn(send_batches(transfer, std::move(packed)));
+    }
+}
+
+void Session::schedule_files(const std::shared_ptr<Transfer>& transfer) {
+    while (auto index = transfer->scheduler->next()) {
+        // 协程持有传输，传输提前结束时发送器不会先于它销毁
+        spawn([transfer, sender = transfer->file_senders[*index].get()]()
+                  -> asio::awaitable<void> { co_await sender->send_file(); });
+    }
+}
+
+void Session::file_finished(const std::shared_ptr<Transfer>& transfer, std::size_t index) {
+    if (transfer->scheduler && transfer->scheduler->finish(index)) {
+        schedule_files(transfer);
+    }
+}
+
+asio::awaitable<void> Session::send_batches(std::shared_ptr<Transfer> transfer,
+                                            std::vector<std::size_t> indices) {
+    // 按路径排序，同一目录的文件连续读取与创建
+    std::sort(indices.begin(), indices.end(), [&](std::size_t a, std::size_t b) {
+        return transfer->file_paths[a].relative < transfer->file_paths[b].relative;
+    });
 
-        for (; it != std::filesystem::recursive_directory_iterator{}; it.increment(iter_ec)) {
-            if (iter_ec) {
+    struct BatchFile {
+        std::size_t index;
+        std::filesystem::path absolute;
+        std::uint64_t size;
+    };
+
+    std::uint64_t batch_index = 0;
+    std::size_t position = 0;
+    while (position < indices.size() && !transfer->result.has_value()) {
+        // 凑满一批：内容不超过一个分块，文件数不超过 kMaxFilesPerBatch。
+        // 路径先拷贝出来：读取期间 send_metadata 可能追加下一页，file_paths 会重新分配
+        std::vector<BatchFile> files;
+        std::uint64_t batch_bytes = 0;
+        while (position < indices.size() && files.size() < kMaxFilesPerBatch) {
+            const auto index = indices[position];
+            const auto size = transfer->file_infos[index].size();
+            if (!files.empty() && batch_bytes + size > kDefaultChunkSize) {
                 break;
             }
-            if (!is_regular_file(*it)) {
-                continue;
+            files.push_back({index, transfer->file_paths[index].absolute, size});
+            batch_bytes += size;
+            ++position;
+        }
+
+        transfer::FileBatchRequest request;
+        request.set_batch_index(batch_index++);
+        // 读取在计算线程池上完成；文件在元数据之后被改短时按实际长度发送，由接收端判为失败
+        co_await executor_.offload([&]() {
+            auto* data = request.mutable_data();
+            data->reserve(batch_bytes);
+            for (const auto& [index, absolute, size] : files) {
+                auto* entry = request.add_entries();
+                entry->set_file_index(static_cast<std::uint32_t>(index));
+                entry->set_offset(data->size());
+                const auto offset = data->size();
+                data->resize(offset + size);
+                std::ifstream file(absolute, std::ios::binary);
+                file.read(data->data() + offset, static_cast<std::streamsize>(size));
+                const auto read = file ? size : static_cast<std::uint64_t>(file.gcount());
+                data->resize(offset + read);
+                entry->set_length(read);
             }
-            file_paths_.emplace_back(it->path().lexically_relative(path),
-                                     it->path(),
-                                     FilePath::Status::InProgress,
-                                     0);
+        });
+
+        try {
+            co_await send(transfer->stream_id, request, {}, core::net::io::FramePriority::Bulk);
+        } catch (const std::exception& e) {
+            spdlog::warn("[Session::send_batches] Failed to send batch: {}", e.what());
+            co_return;
         }
     }
 }
 
-std::optional<std::size_t> Session::find_file_index(const std::string& relative_path) const {
-    for (std::size_t i = 0; i < file_paths_.size(); ++i) {
-        if (file_paths_[i].relative.string() == relative_path) {
-            return i;
-        }
+std::optional<std::size_t> Session::find_file_index(const Transfer& transfer,
+                                                    const std::string& relative_path) {
+    const auto it = transfer.file_indices.find(relative_path);
+    if (it == transfer.file_indices.end()) {
+        return std::nullopt;
     }
-    return std::nullopt;
+    return it->second;
 }
 
-SingleFileSender* Session::find_file_sender(const std::string& relative_path) {
-    auto index = find_file_index(relative_path);
-    if (!index || *index >= file_senders_.size()) {
+SingleFileSender* Session::find_file_sender(Transfer& transfer,
+                                            const std::string& relative_path) {
+    auto index = find_file_index(transfer, relative_path);
+    if (!index || *index >= transfer.file_senders.size()) {
         return nullptr;
     }
-    return file_senders_[*index].get();
+    return transfer.file_senders[*index].get();
 }
 
-asio::awaitable<void> Session::handle_message(const MessageWrapper& message) {
+asio::awaitable<void> Session::handle_stream_message(std::uint32_t stream_id,
+                                                     const MessageWrapper& message) {
+    const auto it = transfers_.find(stream_id);
+    if (it == transfers_.end()) {
+        spdlog::warn("[Session::handle_message] Received {} for unknown stream {}",
+                     message.type(),
+                     stream_id);
+        co_return;
+    }
+    // 处理期间传输可能结束并被移除，持有它直到本次处理完成
+    const auto transfer = it->second;
+
     ConstDataBlock data(reinterpret_cast<const std::byte*>(message.payload().data()),
                         message.payload().size());
 
@@ -104,39 +392,37 @@ asio::awaitable<void> Session::handle_message(const MessageWrapper& message) {
         }
 
         if (response.status() == transfer::TransferMetadataResponse::READY) {
-            for (const auto& file_path : file_paths_) {
-                file_senders_.emplace_back(
-                    std::make_unique<SingleFileSender>(executor_,
-                                                       *this,
-                                                       *metadata_request_.mutable_files(
-                                                           static_cast<int>(file_path.file_index)),
-                                                       file_path.absolute));
-            }
-            for (auto& sender : file_senders_) {
-                executor_.spawn(sender->send_file());
-            }
+            start_page(transfer, response.first_file_index());
         } else if (response.status() == transfer::TransferMetadataResponse::SUCCESS) {
             spdlog::info("[Session::handle_message] Transfer completed successfully");
-            // 停止会话
-            stop();
+            spdlog::info("[Session::handle_message] Verification cost: {}",
+                         transfer->verify_cost.summary(verify_policy_));
+            const auto& cost = transfer->verify_cost;
+            verify_cost_.record(cost.cpu_time(), cost.bytes_hashed(), cost.bytes_read());
+            finish_transfer(*transfer, true);
+            // 长连接会话留给下一次传输，否则停止会话
+            if (!keep_alive_) {
+                stop();
+            }
         } else if (response.status() == transfer::TransferMetadataResponse::FAILURE) {
             spdlog::error(
                 "[Session::handle_message] Transfer metadata response indicates failure: {}",
                 response.message());
+            finish_transfer(*transfer, false);
         }
     } else if (message.type() == "transfer.FileInfoResponse") {
         transfer::FileInfoResponse response;
         if (!util::deserialize(data, response)) {
             co_return;
         }
-        auto file_index = find_file_index(response.relative_path());
+        auto file_index = find_file_index(*transfer, response.relative_path());
         if (!file_index) {
             spdlog::warn("[Session::handle_message] Received response for unknown file: {}",
                          response.relative_path());
             co_return;
         }
 
-        auto& file_path = file_paths_[*file_index];
+        auto& file_path = transfer->file_paths[*file_index];
         if (response.status() == transfer::FileInfoResponse::SUCCESS) {
             spdlog::info("[Session::handle_message] File info accepted: {}",
                          response.relative_path());
@@ -149,13 +435,17 @@ asio::awaitable<void> Session::handle_message(const MessageWrapper& message) {
                           response.relative_path(),
                           response.message());
         }
+        file_finished(transfer, *file_index);
     } else if (message.type() == "transfer.FileChunkResponse") {
         transfer::FileChunkResponse response;
         if (!util::deserialize(data, response)) {
             co_return;
         }
 
-        auto* sender = find_file_sender(response.file_relative_path());
+        auto* sender = find_file_sender(*transfer, response.file_relative_path());
+        if (!sender) {
+            co_return;
+        }
 
         bool success = (response.status() == transfer::FileChunkResponse::RECEIVED);
         sender->update_chunk_status(response.chunk_index(), success);
@@ -165,6 +455,27 @@ asio::awaitable<void> Session::handle_message(const MessageWrapper& message) {
                           response.file_relative_path(),
                           response.chunk_index(),
                           response.message());
+            // 分块没有重传，文件不会再完成，让出活动名额
+            if (auto file_index = find_file_index(*transfer, response.file_relative_path())) {
+                transfer->file_paths[*file_index].status = FilePath::Status::Failed;
+                file_finished(transfer, *file_index);
+            }
+        }
+    } else if (message.type() == "transfer.FileBatchResponse") {
+        transfer::FileBatchResponse response;
+        if (!util::deserialize(data, response)) {
+            co_return;
+        }
+        for (const auto index : response.failed_files()) {
+            if (index < transfer->file_paths.size()) {
+                transfer->file_paths[index].status = FilePath::Status::Failed;
+            }
+        }
+        if (response.failed_files_size() > 0) {
+            spdlog::error("[Session::handle_message] Batch {} failed for {} files: {}",
+                          response.batch_index(),
+                          response.failed_files_size(),
+                          response.message());
         }
     }
     co_return;
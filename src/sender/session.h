@@ -1,42 +1,151 @@
 #pragma once
 #include "asio/awaitable.hpp"
+#include "asio/steady_timer.hpp"
+#include "file_scheduler.h"
+#include "file_walker.h"
 #include "single_file_sender.h"
 #include "transfer.pb.h"
+#include "util/verify.h"
+#include <concepts>
+#include <deque>
+#include <cstdint>
 #include <core/net/io/session.h>
+#include <filesystem>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <session.pb.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace sender {
 
 class Session : public core::net::io::Session {
   public:
     template<typename... FilePaths>
+        requires(std::constructible_from<std::filesystem::path, FilePaths> && ...)
     Session(core::Executor& executor, std::string_view host, uint16_t port, FilePaths&&... paths)
         : core::net::io::Session(executor, host, port)
         , paths_{std::filesystem::path(std::forward<FilePaths>(paths))...} {}
 
+    // 长连接会话（由 ConnectionPool 创建）：构造时只建立连接，之后通过 transfer()
+    // 在同一连接上发起多次传输，传输结束后会话不停止。on_finished 同 core::net::io::Session
+    Session(core::Executor& executor,
+            std::string_view host,
+            uint16_t port,
+            std::function<void()> on_finished)
+        : core::net::io::Session(executor, host, port, std::move(on_finished))
+        , keep_alive_(true) {}
+
+    // 在 0 号流上传输构造时给出的文件
     asio::awaitable<void> start() override;
 
-  private:
-    asio::awaitable<void> handle_message(const MessageWrapper& message) override;
+    // 在本连接上传输 paths 并等待结束，全部文件成功时返回 true，连接断开时返回 false。
+    // 可在任意执行器上调用。每次传输占用连接上的一个独立流，多个传输可以同时进行，
+    // 写出时按 weight 分享带宽，小传输不会被并行的大传输阻塞
+    asio::awaitable<bool> transfer(std::vector<std::filesystem::path> paths,
+                                   std::uint32_t weight = 1);
 
-    void prepare_file_paths();
+    // 需在传输开始（发送元数据）之前设置
+    void set_verify_policy(util::VerifyPolicy policy) { verify_policy_ = policy; }
+    util::VerifyPolicy verify_policy() const { return verify_policy_; }
+    // 会话内已完成传输的校验开销累计
+    const util::VerifyCost& verify_cost() const { return verify_cost_; }
 
-    std::optional<std::size_t> find_file_index(const std::string& relative_path) const;
+    // 文件的发送顺序与同时活动的文件数，需在传输收到 READY 之前设置
+    void set_file_scheduling(FileSchedulerOptions options) { file_scheduling_ = options; }
 
-    SingleFileSender* find_file_sender(const std::string& relative_path);
+    // 不超过 bytes 的文件打包进 FileBatchRequest 批量发送，0 表示不打包。需在发送元数据之前设置
+    void set_pack_threshold(std::uint64_t bytes) { pack_threshold_ = bytes; }
 
-    std::vector<std::filesystem::path> paths_;
-    std::vector<std::unique_ptr<SingleFileSender>> file_senders_;
+    static constexpr std::uint64_t kDefaultPackThreshold = 64 * 1024;
+    // 清单每页的文件数，接收端确认首页后数据即开始发送
+    static constexpr std::size_t kManifestPageSize = 1024;
+    // 单个批次的文件数上限，批次内容不超过 kDefaultChunkSize
+    static constexpr std::size_t kMaxFilesPerBatch = 1024;
 
+  private:
     struct FilePath {
         std::filesystem::path relative;
         std::filesystem::path absolute;
         enum class Status { Succeeded, Failed, InProgress } status{Status::InProgress};
-        std::size_t file_index; // 索引位置，对应 metadata_request.files(file_index)
+        std::size_t file_index; // 在整个清单中的下标，对应 file_infos[file_index]
+        std::vector<util::hash::Sha256Digest> chunk_hashes; // 预先算好的分块摘要，可能为空
+        bool packed = false; // 随批次发送，没有 SingleFileSender
     };
-    std::vector<FilePath> file_paths_;
-    transfer::TransferMetadataRequest metadata_request_;
+
+    // 一次传输的状态，按所在的流登记在 transfers_ 中
+    struct Transfer {
+        explicit Transfer(const asio::any_io_executor& executor)
+            : done(executor) {}
+
+        std::uint32_t stream_id = 0;
+        std::vector<std::filesystem::path> paths;
+        std::vector<FilePath> file_paths;
+        // 已发出的清单条目；SingleFileSender 引用其中的元素，deque 追加时不会移动它们
+        std::deque<transfer::FileInfoRequest> file_infos;
+        std::unordered_map<std::string, std::size_t> file_indices; // 相对路径 -> 下标
+        // 已发出、等待 READY 的清单页：起始下标 -> 文件数
+        std::unordered_map<std::size_t, std::size_t> pending_pages;
+        // 按文件下标索引，页被确认后才创建其中的发送器
+        std::vector<std::unique_ptr<SingleFileSender>> file_senders;
+        // 收到 READY 后创建，决定 file_senders 中哪些文件可以开始发送
+        std::optional<FileScheduler> scheduler;
+        util::VerifyCost verify_cost;
+        // 传输结果，run_transfer() 在 done 上等待它被设置
+        std::optional<bool> result;
+        asio::steady_timer done;
+    };
+
+    asio::awaitable<void> handle_stream_message(std::uint32_t stream_id,
+                                                const MessageWrapper& message) override;
+    void receive_stopped() override;
+
+    std::shared_ptr<Transfer> begin_transfer(std::uint32_t stream_id,
+                                             std::vector<std::filesystem::path> paths);
+    // 边遍历边分页发送清单，每页的摘要在计算线程池上算好后再发出
+    asio::awaitable<void> send_metadata(Transfer& transfer);
+    // 一页清单被接收端确认后开始发送其中的文件
+    void start_page(const std::shared_ptr<Transfer>& transfer, std::size_t first_file_index);
+    asio::awaitable<bool> run_transfer(std::vector<std::filesystem::path> paths,
+                                       std::uint32_t weight);
+    void finish_transfer(Transfer& transfer, bool success);
+
+    // 启动调度器允许的文件；一个文件结束后调用 file_finished 腾出名额
+    void schedule_files(const std::shared_ptr<Transfer>& transfer);
+    void file_finished(const std::shared_ptr<Transfer>& transfer, std::size_t index);
+
+    // 按路径顺序把打包文件分批读出并发送，每批一帧
+    asio::awaitable<void> send_batches(std::shared_ptr<Transfer> transfer,
+                                       std::vector<std::size_t> indices);
+
+    // 按校验策略准备一页文件的摘要，VERIFY_NONE 时不读取文件。在计算线程池上执行，只读访问成员。
+    // 打包文件只算整文件摘要（没有分块），多个小文件一起交给 sha256_files 批量计算。
+    // 遍历时取得的文件属性直接用于查摘要缓存，不再 stat
+    std::vector<std::optional<util::hash::FileDigests>> compute_page_digests(
+        const std::vector<FileWalker::Entry>& entries, util::VerifyCost& cost) const;
+    std::optional<util::hash::FileDigests> compute_digests(const FileWalker::Entry& entry,
+                                                           util::VerifyCost& cost) const;
+
+    static std::optional<std::size_t> find_file_index(const Transfer& transfer,
+                                                      const std::string& relative_path);
+
+    static SingleFileSender* find_file_sender(Transfer& transfer,
+                                              const std::string& relative_path);
+
+    std::vector<std::filesystem::path> paths_;
+    // 进行中的传输，键为流 ID。0 号流留给 start()，transfer() 从 1 开始分配
+    std::unordered_map<std::uint32_t, std::shared_ptr<Transfer>> transfers_;
+    std::uint32_t next_stream_id_ = 1;
+
+    util::VerifyPolicy verify_policy_ = transfer::TransferMetadataRequest::VERIFY_BOTH;
+    util::VerifyCost verify_cost_;
+    FileSchedulerOptions file_scheduling_;
+    std::uint64_t pack_threshold_ = kDefaultPackThreshold;
+
+    bool keep_alive_ = false;
+    bool started_ = false;
 };
 } // namespace sender
\ No newline at end of file
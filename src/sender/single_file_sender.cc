@@ -22,13 +22,35 @@ void SetLastChunkFlag(Message& message, bool value) {
 SingleFileSender::SingleFileSender(core::Executor& executor,
                                    core::net::io::Session& session,
                                    transfer::FileInfoRequest& file,
-                                   const std::filesystem::path& absolute_path)
+                                   const std::filesystem::path& absolute_path,
+                                   std::vector<util::hash::Sha256Digest> chunk_hashes,
+                                   util::VerifyPolicy policy,
+                                   util::VerifyCost* cost,
+                                   std::uint32_t stream_id)
     : executor_(executor)
     , session_(session)
-    , size_(file.size())
+    , stream_id_(stream_id)
     , file_path_(absolute_path)
     , relative_path_(file.relative_path())
-    , hash_(file.hash()) {}
+    , size_(file.size())
+    , hash_(util::hash::to_digest(util::hash::as_block(file.hash())))
+    , chunk_hashes_(std::move(chunk_hashes))
+    , verify_chunks_(util::verifies_chunks(policy))
+    , cost_(cost) {}
+
+std::optional<util::hash::Sha256Digest>
+SingleFileSender::chunk_hash_at(std::uint64_t chunk_index, ConstDataBlock data) const {
+    if (!verify_chunks_) {
+        return std::nullopt;
+    }
+    // 缓存的分块数与当前文件大小对不上时说明缓存已过期，回退到现场计算
+    const auto expected_chunks = (size_ + kDefaultChunkSize - 1) / kDefaultChunkSize;
+    if (chunk_hashes_.size() == expected_chunks && chunk_index < chunk_hashes_.size()) {
+        return chunk_hashes_[static_cast<std::size_t>(chunk_index)];
+    }
+    auto hash_chunk = [&] { return util::hash::sha256(data); };
+    return cost_ ? cost_->track(data.size(), 0, hash_chunk) : hash_chunk();
+}
 
 asio::awaitable<void> SingleFileSender::send_file() {
     std::ifstream file(file_path_, std::ios::binary);
@@ -37,7 +59,13 @@ asio::awaitable<void> SingleFileSender::send_file() {
         co_return;
     }
 
-    std::vector<std::byte> buffer(kDefaultBufferSize);
+    // 整个文件复用同一块池中的缓冲区，每个分块的数据复制进请求后即可覆盖
+    auto buffer = executor_.get_chunk_buffers().acquire();
+    if (!buffer || buffer.size() < kDefaultChunkSize) {
+        spdlog::error("[SingleFileSender::send_file] Failed to get buffer for file: {}",
+                      file_path_.string());
+        co_return;
+    }
 
     if (total_chunks_ == 0) {
         total_chunks_ = size_ == 0 ? 1 : (size_ + kDefaultChunkSize - 1) / kDefaultChunkSize;
@@ -52,17 +80,21 @@ asio::awaitable<void> SingleFileSender::send_file() {
         chunk_request.set_file_relative_path(relative_path_);
         chunk_request.set_chunk_index(0);
         chunk_request.set_data("", 0);
-        chunk_request.set_hash(hash_);
+        const auto empty_hash = chunk_hash_at(0, {});
+        if (empty_hash) {
+            chunk_request.set_hash(empty_hash->data(), empty_hash->size());
+        }
         SetLastChunkFlag(chunk_request, true);
 
         chunks_.emplace_back();
         auto& chunk_info = chunks_.back();
         chunk_info.offset = 0;
         chunk_info.size = 0;
-        chunk_info.hash = hash_;
+        chunk_info.hash = empty_hash;
         chunk_info.is_last = true;
 
-        executor_.spawn(session_.send(chunk_request));
+        session_.spawn(
+            session_.send(stream_id_, chunk_request, {}, core::net::io::FramePriority::Bulk));
 
         spdlog::info("[SingleFileSender::send_file] File sent successfully: {}, {} chunks",
                      file_path_.string(),
@@ -71,30 +103,38 @@ asio::awaitable<void> SingleFileSender::send_file() {
     }
 
     while (file && bytes_sent < size_) {
-        file.read(reinterpret_cast<char*>(buffer.data()), kDefaultChunkSize);
-        const auto bytes_read = static_cast<std::size_t>(file.gcount());
+        // 读取与分块摘要放到计算线程池上，io 线程只负责组包和发送
+        const auto [bytes_read, chunk_hash] = co_await executor_.offload([&]() {
+            file.read(reinterpret_cast<char*>(buffer.data()), kDefaultChunkSize);
+            const auto count = static_cast<std::size_t>(file.gcount());
+            auto hash = count > 0 ? chunk_hash_at(chunk_index, ConstDataBlock(buffer.data(), count))
+                                  : std::nullopt;
+            return std::pair{count, hash};
+        });
 
         if (bytes_read > 0) {
             bytes_sent += bytes_read;
 
             const bool is_last = bytes_sent >= size_;
-            auto chunk_hash = util::hash::sha256_hex(ConstDataBlock(buffer.data(), bytes_read));
 
             transfer::FileChunkRequest chunk_request;
             chunk_request.set_file_relative_path(relative_path_);
             chunk_request.set_chunk_index(chunk_index);
             chunk_request.set_data(buffer.data(), bytes_read);
-            chunk_request.set_hash(chunk_hash ? *chunk_hash : std::string());
+            if (chunk_hash) {
+                chunk_request.set_hash(chunk_hash->data(), chunk_hash->size());
+            }
             SetLastChunkFlag(chunk_request, is_last);
 
             chunks_.emplace_back();
             auto& chunk_info = chunks_.back();
             chunk_info.offset = bytes_sent - bytes_read;
             chunk_info.size = static_cast<std::uint32_t>(bytes_read);
-            chunk_info.hash = chunk_hash ? *chunk_hash : std::string();
+            chunk_info.hash = chunk_hash;
             chunk_info.is_last = is_last;
 
-            executor_.spawn(session_.send(chunk_request));
+            session_.spawn(
+                session_.send(stream_id_, chunk_request, {}, core::net::io::FramePriority::Bulk));
 
             chunk_index++;
         }
@@ -127,29 +167,37 @@ asio::awaitable<void> SingleFileSender::send_chunk(std::uint64_t chunk_index) {
         co_return;
     }
 
-    file.seekg(static_cast<std::streamoff>(chunk.offset), std::ios::beg);
-    std::vector<std::byte> buffer(chunk.size);
-    file.read(reinterpret_cast<char*>(buffer.data()), chunk.size);
-    const auto bytes_read = static_cast<std::size_t>(file.gcount());
+    // 分块缓冲区来自执行器的池，位于网卡所在的 NUMA 节点，数据复制进请求后随函数返回归还
+    auto buffer = executor_.get_chunk_buffers().acquire();
+    if (!buffer || buffer.size() < chunk.size) {
+        spdlog::error("[SingleFileSender::send_chunk] Failed to get buffer for chunk {}",
+                      chunk_index);
+        co_return;
+    }
+    const auto [bytes_read, chunk_hash] = co_await executor_.offload([&]() {
+        file.seekg(static_cast<std::streamoff>(chunk.offset), std::ios::beg);
+        file.read(reinterpret_cast<char*>(buffer.data()), chunk.size);
+        const auto count = static_cast<std::size_t>(file.gcount());
+        if (count == 0 || chunk.hash) {
+            return std::pair{count, chunk.hash};
+        }
+        return std::pair{count, chunk_hash_at(chunk_index, ConstDataBlock(buffer.data(), count))};
+    });
 
     if (bytes_read > 0) {
-        auto chunk_hash = chunk.hash;
-        if (chunk_hash.empty()) {
-            auto computed_hash = util::hash::sha256_hex(ConstDataBlock(buffer.data(), bytes_read));
-            if (computed_hash) {
-                chunk_hash = *computed_hash;
-                chunk.hash = chunk_hash;
-            }
-        }
+        chunk.hash = chunk_hash;
 
         transfer::FileChunkRequest chunk_request;
         chunk_request.set_file_relative_path(relative_path_);
         chunk_request.set_chunk_index(chunk_index);
         chunk_request.set_data(buffer.data(), bytes_read);
-        chunk_request.set_hash(chunk_hash);
+        if (chunk.hash) {
+            chunk_request.set_hash(chunk.hash->data(), chunk.hash->size());
+        }
         SetLastChunkFlag(chunk_request, chunk.is_last);
 
-        executor_.spawn(session_.send(chunk_request));
+        session_.spawn(
+            session_.send(stream_id_, chunk_request, {}, core::net::io::FramePriority::Bulk));
     }
 
     co_return;
@@ -3,9 +3,13 @@
 #include "core/executor.h"
 #include "core/net/io/session.h"
 #include "transfer.pb.h"
+#include "util/hash.h"
+#include "util/verify.h"
 #include <cstdint>
 #include <filesystem>
+#include <optional>
 #include <string>
+#include <vector>
 
 namespace sender {
 class SingleFileSender {
@@ -13,7 +17,11 @@ class SingleFileSender {
     SingleFileSender(core::Executor& executor,
                      core::net::io::Session& session,
                      transfer::FileInfoRequest& file,
-                     const std::filesystem::path& absolute_path);
+                     const std::filesystem::path& absolute_path,
+                     std::vector<util::hash::Sha256Digest> chunk_hashes = {},
+                     util::VerifyPolicy policy = transfer::TransferMetadataRequest::VERIFY_BOTH,
+                     util::VerifyCost* cost = nullptr,
+                     std::uint32_t stream_id = 0);
     ~SingleFileSender() = default;
 
     SingleFileSender(const SingleFileSender&) = delete;
@@ -25,22 +33,29 @@ class SingleFileSender {
     void update_chunk_status(std::uint64_t chunk_index, bool success);
 
   private:
+    std::optional<util::hash::Sha256Digest> chunk_hash_at(std::uint64_t chunk_index,
+                                                          ConstDataBlock data) const;
+
     core::Executor& executor_;
     struct ChunkInfo {
         enum class Status { InProgress, Completed, Failed };
         Status status = Status::InProgress;
         std::uint64_t offset = 0;
         std::uint32_t size = 0;
-        std::string hash;
+        std::optional<util::hash::Sha256Digest> hash;
         bool is_last = false;
     };
     std::vector<ChunkInfo> chunks_;
 
     core::net::io::Session& session_;
+    std::uint32_t stream_id_; // 所属传输在连接上的流
     std::filesystem::path file_path_; // 绝对路径，用于读取文件
     std::string relative_path_;       // 相对路径，用于协议
     std::uint64_t size_;
-    std::string hash_;
+    std::optional<util::hash::Sha256Digest> hash_;
+    std::vector<util::hash::Sha256Digest> chunk_hashes_; // 来自摘要缓存，可为空
+    bool verify_chunks_;
+    util::VerifyCost* cost_;
     std::uint64_t total_chunks_ = 0;
     std::uint64_t completed_chunks_ = 0;
     bool completion_announced_ = false;
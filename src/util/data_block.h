@@ -49,20 +49,14 @@ ConstDataBlock serialize(const T& message, MutDataBlock buffer) {
     return ConstDataBlock(buffer.data(), size);
 }
 
+// 空数据是所有字段都取默认值的合法消息（例如状态为 SUCCESS 的应答），消息边界由分帧保证
 template<ProtobufMessage T>
 bool deserialize(ConstDataBlock data, T& message) {
-    if (data.empty()) {
-        return false;
-    }
     return message.ParseFromArray(data.data(), static_cast<int>(data.size()));
 }
 
 template<ProtobufMessage T>
 std::optional<T> deserialize(ConstDataBlock data) {
-    if (data.empty()) {
-        return std::nullopt;
-    }
-
     T message;
     if (!message.ParseFromArray(data.data(), static_cast<int>(data.size()))) {
         return std::nullopt;
@@ -0,0 +1,477 @@
+#include "util/file_hash_cache.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <spdlog/spdlog.h>
+#include <string_view>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define XNN_HASH_CACHE_POSIX 1
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define XNN_HASH_CACHE_POSIX 0
+#endif
+
+namespace util {
+namespace {
+constexpr std::array<char, 8> kFileMagic = {'X', 'N', 'N', 'H', 'C', 'v', '1', '\0'};
+constexpr std::uint32_t kRecordMagic = 0x48524543; // "HREC"
+
+// 文件头：magic + chunk_size + 保留字段
+constexpr std::size_t kHeaderSize = kFileMagic.size() + sizeof(std::uint32_t) * 2;
+// 记录头：magic + chunk_count + device/inode/size/mtime/ctime/last_used + 整文件摘要
+constexpr std::size_t kRecordFixedSize = sizeof(std::uint32_t) * 2 + sizeof(std::uint64_t) * 6
+                                         + hash::kSha256Size;
+
+// 时间戳精度有限，刚修改过的文件可能在同一时间戳内再次被改写，这类文件不写入缓存
+constexpr std::chrono::seconds kRacyWindow{2};
+
+std::uint64_t now_ns() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::system_clock::now().time_since_epoch())
+                                          .count());
+}
+
+std::size_t expected_chunks(std::uint64_t size, std::size_t chunk_size) {
+    return static_cast<std::size_t>((size + chunk_size - 1) / chunk_size);
+}
+
+template<typename T>
+void put(std::vector<std::byte>& out, const T& value) {
+    const auto* bytes = reinterpret_cast<const std::byte*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template<typename T>
+T get(const std::byte*& cursor) {
+    T value;
+    std::memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return value;
+}
+
+void put_header(std::vector<std::byte>& out, std::size_t chunk_size) {
+    const auto* magic = reinterpret_cast<const std::byte*>(kFileMagic.data());
+    out.insert(out.end(), magic, magic + kFileMagic.size());
+    put(out, static_cast<std::uint32_t>(chunk_size));
+    put(out, std::uint32_t{0});
+}
+
+bool write_all(const std::filesystem::path& path,
+               const std::vector<std::byte>& data,
+               std::ios::openmode mode) {
+    std::ofstream file(path, std::ios::binary | mode);
+    if (!file) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(data.data()),
+               static_cast<std::streamsize>(data.size()));
+    file.flush();
+    return static_cast<bool>(file);
+}
+
+#if XNN_HASH_CACHE_POSIX
+// 旁路锁文件上的 flock，析构时释放
+class FileLock {
+  public:
+    FileLock(const std::filesystem::path& path, bool exclusive) {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            return;
+        }
+        if (::flock(fd_, exclusive ? LOCK_EX : LOCK_SH) != 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+    ~FileLock() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+    bool locked() const { return fd_ >= 0; }
+
+  private:
+    int fd_ = -1;
+};
+
+// 只读映射整个缓存文件
+class MappedFile {
+  public:
+    explicit MappedFile(const std::filesystem::path& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st {};
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            const auto size = static_cast<std::size_t>(st.st_size);
+            void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                data_ = static_cast<const std::byte*>(data);
+                size_ = size;
+            }
+        }
+        ::close(fd);
+    }
+    ~MappedFile() {
+        if (data_ != nullptr) {
+            ::munmap(const_cast<std::byte*>(data_), size_);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ConstDataBlock data() const { return {data_, size_}; }
+
+  private:
+    const std::byte* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+#endif
+} // namespace
+
+FileHashCache::~FileHashCache() {
+    if (is_open()) {
+        flush();
+    }
+}
+
+bool FileHashCache::open(const std::filesystem::path& path,
+                         std::size_t max_entries,
+                         std::size_t chunk_size) {
+#if XNN_HASH_CACHE_POSIX
+    std::lock_guard<std::mutex> lock(mutex_);
+    path_ = path;
+    lock_path_ = path;
+    lock_path_ += ".lock";
+    max_entries_ = std::max<std::size_t>(max_entries, 1);
+    chunk_size_ = chunk_size;
+    entries_.clear();
+
+    std::error_code ec;
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), ec);
+    }
+
+    FileLock file_lock(lock_path_, false);
+    if (!file_lock.locked()) {
+        spdlog::warn("[FileHashCache::open] Failed to lock {}, cache disabled",
+                     lock_path_.string());
+        path_.clear();
+        return false;
+    }
+    merge_from_disk();
+    spdlog::info("[FileHashCache::open] Loaded {} entries from {}",
+                 entries_.size(),
+                 path_.string());
+    return true;
+#else
+    (void) path;
+    (void) max_entries;
+    (void) chunk_size;
+    spdlog::warn("[FileHashCache::open] File hash cache is not supported on this platform");
+    return false;
+#endif
+}
+
+bool FileHashCache::is_open() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !path_.empty();
+}
+
+std::size_t FileHashCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+std::optional<FileHashCache::FileKey>
+FileHashCache::stat_key(const std::filesystem::path& file_path) {
+#if XNN_HASH_CACHE_POSIX
+    struct stat st {};
+    if (::stat(file_path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return std::nullopt;
+    }
+    FileKey key;
+    key.device = static_cast<std::uint64_t>(st.st_dev);
+    key.inode = static_cast<std::uint64_t>(st.st_ino);
+    key.size = static_cast<std::uint64_t>(st.st_size);
+#if defined(__APPLE__)
+    key.mtime_ns = static_cast<std::int64_t>(st.st_mtimespec.tv_sec) * 1'000'000'000
+                   + st.st_mtimespec.tv_nsec;
+    key.ctime_ns = static_cast<std::int64_t>(st.st_ctimespec.tv_sec) * 1'000'000'000
+                   + st.st_ctimespec.tv_nsec;
+#else
+    key.mtime_ns = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1'000'000'000
+                   + st.st_mtim.tv_nsec;
+    key.ctime_ns = static_cast<std::int64_t>(st.st_ctim.tv_sec) * 1'000'000'000
+                   + st.st_ctim.tv_nsec;
+#endif
+    return key;
+#else
+    (void) file_path;
+    return std::nullopt;
+#endif
+}
+
+std::optional<hash::FileDigests> FileHashCache::lookup(const std::filesystem::path& file_path) {
+    const auto key = stat_key(file_path);
+    if (!key) {
+        return std::nullopt;
+    }
+    return lookup(*key);
+}
+
+std::optional<hash::FileDigests> FileHashCache::lookup(const FileKey& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find({key.device, key.inode});
+    if (it == entries_.end() || !it->second.key.same_content(key)) {
+        return std::nullopt;
+    }
+    // 未变化的条目不必写回，最近使用时间随下一次整体重写持久化
+    it->second.last_used = now_ns();
+    return it->second.digests;
+}
+
+std::optional<hash::FileDigests>
+FileHashCache::get_or_compute(const std::filesystem::path& file_path) {
+    if (!is_open()) {
+        return hash::sha256_file_chunks(file_path, chunk_size_);
+    }
+
+    const auto key = stat_key(file_path);
+    if (!key) {
+        return hash::sha256_file_chunks(file_path, chunk_size_);
+    }
+    return get_or_compute(file_path, *key);
+}
+
+std::optional<hash::FileDigests>
+FileHashCache::get_or_compute(const std::filesystem::path& file_path, const FileKey& key) {
+    if (!is_open()) {
+        return hash::sha256_file_chunks(file_path, chunk_size_);
+    }
+    if (auto cached = lookup(key)) {
+        spdlog::debug("[FileHashCache::get_or_compute] Cache hit: {}", file_path.string());
+        return cached;
+    }
+
+    auto digests = hash::sha256_file_chunks(file_path, chunk_size_);
+    if (!digests) {
+        return digests;
+    }
+
+    // 摘要记在计算前取得的 key 下：计算期间文件被改写时 mtime / ctime 随之变化，
+    // 这条记录以后不会再命中，不必再 stat 一次确认。
+    // 只有 mtime 仍在时间戳精度窗口内时，改写可能不改变时间戳，这类文件不写入缓存
+    const auto racy_since = static_cast<std::int64_t>(now_ns())
+                            - std::chrono::nanoseconds(kRacyWindow).count();
+    if (key.mtime_ns < racy_since && key.ctime_ns < racy_since) {
+        store(key, *digests);
+    }
+    return digests;
+}
+
+void FileHashCache::store(const FileKey& key, const hash::FileDigests& digests) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (path_.empty() || digests.chunks.size() != expected_chunks(key.size, chunk_size_)) {
+        return;
+    }
+    auto& entry = entries_[{key.device, key.inode}];
+    entry.key = key;
+    entry.last_used = now_ns();
+    entry.dirty = true;
+    entry.digests = digests;
+}
+
+bool FileHashCache::flush() {
+#if XNN_HASH_CACHE_POSIX
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (path_.empty()) {
+        return false;
+    }
+
+    const auto dirty = static_cast<std::size_t>(
+        std::count_if(entries_.begin(), entries_.end(), [](const auto& item) {
+            return item.second.dirty;
+        }));
+    if (dirty == 0) {
+        return true;
+    }
+
+    FileLock file_lock(lock_path_, true);
+    if (!file_lock.locked()) {
+        spdlog::error("[FileHashCache::flush] Failed to lock {}", lock_path_.string());
+        return false;
+    }
+
+    // 先合并其它进程追加的记录，再决定追加还是整体重写。
+    // 损坏的记录之后追加的内容都无法再被读到，这时也要整体重写
+    const auto [records, complete] = merge_from_disk();
+    bool ok = false;
+    if (records == 0 || !complete || records + dirty > max_entries_ * 2) {
+        evict();
+        ok = rewrite();
+    } else {
+        ok = append_dirty();
+    }
+
+    if (ok) {
+        for (auto& [id, entry] : entries_) {
+            entry.dirty = false;
+        }
+    } else {
+        spdlog::error("[FileHashCache::flush] Failed to write {}", path_.string());
+    }
+    return ok;
+#else
+    return false;
+#endif
+}
+
+FileHashCache::MergeResult FileHashCache::merge_from_disk() {
+#if XNN_HASH_CACHE_POSIX
+    MappedFile mapped(path_);
+    const auto data = mapped.data();
+    if (data.size() < kHeaderSize
+        || std::memcmp(data.data(), kFileMagic.data(), kFileMagic.size()) != 0) {
+        return {0, data.empty()};
+    }
+
+    const std::byte* cursor = data.data() + kFileMagic.size();
+    const std::byte* const end = data.data() + data.size();
+    if (get<std::uint32_t>(cursor) != chunk_size_) {
+        // 分块大小变化后旧的分块摘要全部失效
+        return {0, false};
+    }
+    get<std::uint32_t>(cursor);
+
+    MergeResult result;
+    while (cursor != end) {
+        if (static_cast<std::size_t>(end - cursor) < kRecordFixedSize
+            || get<std::uint32_t>(cursor) != kRecordMagic) {
+            result.complete = false;
+            break;
+        }
+        const auto chunk_count = get<std::uint32_t>(cursor);
+        Entry entry;
+        entry.key.device = get<std::uint64_t>(cursor);
+        entry.key.inode = get<std::uint64_t>(cursor);
+        entry.key.size = get<std::uint64_t>(cursor);
+        entry.key.mtime_ns = get<std::int64_t>(cursor);
+        entry.key.ctime_ns = get<std::int64_t>(cursor);
+        entry.last_used = get<std::uint64_t>(cursor);
+        std::memcpy(entry.digests.file.data(), cursor, hash::kSha256Size);
+        cursor += hash::kSha256Size;
+
+        // 记录不完整（写入时进程崩溃）或与文件大小不符时停止解析
+        const auto chunk_bytes = static_cast<std::size_t>(chunk_count) * hash::kSha256Size;
+        if (chunk_count != expected_chunks(entry.key.size, chunk_size_)
+            || static_cast<std::size_t>(end - cursor) < chunk_bytes) {
+            result.complete = false;
+            break;
+        }
+        entry.digests.chunks.resize(chunk_count);
+        std::memcpy(entry.digests.chunks.data(), cursor, chunk_bytes);
+        cursor += chunk_bytes;
+        ++result.records;
+
+        auto& slot = entries_[{entry.key.device, entry.key.inode}];
+        if (slot.last_used < entry.last_used) {
+            slot = std::move(entry);
+        }
+    }
+    return result;
+#else
+    return {};
+#endif
+}
+
+bool FileHashCache::append_dirty() {
+    std::vector<std::byte> out;
+    std::error_code ec;
+    if (std::filesystem::file_size(path_, ec) == 0 || ec) {
+        put_header(out, chunk_size_);
+    }
+
+    for (const auto& [id, entry] : entries_) {
+        if (!entry.dirty) {
+            continue;
+        }
+        put(out, kRecordMagic);
+        put(out, static_cast<std::uint32_t>(entry.digests.chunks.size()));
+        put(out, entry.key.device);
+        put(out, entry.key.inode);
+        put(out, entry.key.size);
+        put(out, entry.key.mtime_ns);
+        put(out, entry.key.ctime_ns);
+        put(out, entry.last_used);
+        const auto* file_digest = entry.digests.file.data();
+        out.insert(out.end(), file_digest, file_digest + hash::kSha256Size);
+        for (const auto& chunk : entry.digests.chunks) {
+            out.insert(out.end(), chunk.begin(), chunk.end());
+        }
+    }
+    return write_all(path_, out, std::ios::app);
+}
+
+bool FileHashCache::rewrite() {
+    for (auto& [id, entry] : entries_) {
+        entry.dirty = true;
+    }
+
+    auto temp_path = path_;
+    temp_path += ".tmp";
+    std::error_code ec;
+    std::filesystem::remove(temp_path, ec);
+
+    // append_dirty() 以 path_ 为目标，这里临时切换到临时文件，写完再原子替换
+    std::swap(path_, temp_path);
+    const bool ok = append_dirty();
+    std::swap(path_, temp_path);
+    if (!ok) {
+        return false;
+    }
+
+    std::filesystem::rename(temp_path, path_, ec);
+    return !ec;
+}
+
+void FileHashCache::evict() {
+    if (entries_.size() <= max_entries_) {
+        return;
+    }
+
+    std::vector<std::uint64_t> last_used;
+    last_used.reserve(entries_.size());
+    for (const auto& [id, entry] : entries_) {
+        last_used.push_back(entry.last_used);
+    }
+    const auto drop = entries_.size() - max_entries_;
+    const auto nth = last_used.begin() + static_cast<std::ptrdiff_t>(drop - 1);
+    std::nth_element(last_used.begin(), nth, last_used.end());
+    const auto threshold = last_used[drop - 1];
+
+    std::size_t dropped = 0;
+    for (auto it = entries_.begin(); it != entries_.end() && dropped < drop;) {
+        if (it->second.last_used <= threshold) {
+            it = entries_.erase(it);
+            ++dropped;
+        } else {
+            ++it;
+        }
+    }
+}
+} // namespace util
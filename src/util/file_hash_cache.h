@@ -0,0 +1,108 @@
+#pragma once
+
+#include "util/data_block.h"
+#include "util/hash.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace util {
+// 持久化的文件摘要缓存。
+// 以 (device, inode) 定位条目，再用 size / mtime / ctime 校验文件是否变化，
+// 未变化的文件直接复用整文件摘要与分块摘要，不再重新读取计算。
+//
+// 磁盘格式为仅追加的记录日志：启动时 mmap 读入，新条目在 flush() 时追加到末尾，
+// 记录数超过上限两倍时按最近使用时间淘汰并整体重写。
+// 所有读写都在旁路锁文件（<path>.lock）上加 flock，多个进程可以共享同一个缓存文件。
+// 不支持 flock / stat inode 的平台上缓存不生效，get_or_compute() 退化为直接计算。
+class FileHashCache {
+  public:
+    static constexpr std::size_t kDefaultMaxEntries = 65536;
+
+    // 文件的身份 (device, inode) 与内容指纹 size / mtime / ctime
+    struct FileKey {
+        std::uint64_t device = 0;
+        std::uint64_t inode = 0;
+        std::uint64_t size = 0;
+        std::int64_t mtime_ns = 0;
+        std::int64_t ctime_ns = 0;
+
+        bool same_content(const FileKey& other) const {
+            return size == other.size && mtime_ns == other.mtime_ns && ctime_ns == other.ctime_ns;
+        }
+    };
+
+    FileHashCache() = default;
+    ~FileHashCache();
+
+    FileHashCache(const FileHashCache&) = delete;
+    FileHashCache& operator=(const FileHashCache&) = delete;
+
+    // 进程级共享实例，由 main 在启动时 open()
+    static FileHashCache& instance() {
+        static FileHashCache instance;
+        return instance;
+    }
+
+    // 加载缓存文件，文件不存在时视为空缓存。chunk_size 与文件记录不一致时丢弃旧内容
+    bool open(const std::filesystem::path& path,
+              std::size_t max_entries = kDefaultMaxEntries,
+              std::size_t chunk_size = kDefaultChunkSize);
+
+    bool is_open() const;
+
+    // 命中时返回缓存的摘要并刷新内存中的最近使用时间（不触发写回），
+    // 未命中或文件已变化时返回 nullopt
+    std::optional<hash::FileDigests> lookup(const std::filesystem::path& file_path);
+
+    // 先查缓存，未命中时计算并记录，只 stat 一次。计算期间文件发生变化时记录不会再命中
+    std::optional<hash::FileDigests> get_or_compute(const std::filesystem::path& file_path);
+
+    // 调用方已经取得文件属性（例如遍历目录时的 statx）时使用，不再 stat
+    std::optional<hash::FileDigests> lookup(const FileKey& key);
+    std::optional<hash::FileDigests> get_or_compute(const std::filesystem::path& file_path,
+                                                    const FileKey& key);
+
+    // 将新增或变化的条目追加到缓存文件；日志尾部损坏时改为整体重写
+    bool flush();
+
+    std::size_t size() const;
+
+  private:
+    struct Entry {
+        FileKey key;
+        std::uint64_t last_used = 0;
+        bool dirty = false;
+        hash::FileDigests digests;
+    };
+
+    using EntryId = std::pair<std::uint64_t, std::uint64_t>; // (device, inode)
+
+    // merge_from_disk() 的结果：complete 为 false 表示在文件末尾之前遇到了损坏或不完整的记录
+    struct MergeResult {
+        std::size_t records = 0;
+        bool complete = true;
+    };
+
+    static std::optional<FileKey> stat_key(const std::filesystem::path& file_path);
+
+    void store(const FileKey& key, const hash::FileDigests& digests);
+
+    // 以下函数要求调用方已持有 mutex_ 与文件锁
+    MergeResult merge_from_disk();
+    bool append_dirty();
+    bool rewrite();
+    void evict();
+
+    std::filesystem::path path_;
+    std::filesystem::path lock_path_;
+    std::size_t max_entries_ = kDefaultMaxEntries;
+    std::size_t chunk_size_ = kDefaultChunkSize;
+    std::map<EntryId, Entry> entries_;
+    mutable std::mutex mutex_;
+};
+} // namespace util
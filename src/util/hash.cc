@@ -1,8 +1,10 @@
 #include "util/hash.h"
+#include "util/sha256_multi_buffer.h"
 #include <fstream>
 #include <memory>
 #include <openssl/evp.h>
 #include <spdlog/spdlog.h>
+#include <string>
 #include <vector>
 
 namespace util::hash {
@@ -17,49 +19,63 @@ struct MdCtxDeleter {
 
 using MdCtxPtr = std::unique_ptr<EVP_MD_CTX, MdCtxDeleter>;
 
-[[nodiscard]] std::optional<MdCtxPtr> make_md_ctx() {
-    MdCtxPtr ctx{EVP_MD_CTX_new()};
+// sha256_files 每攒够这么多字节就计算一批，限制读入内存的文件总量
+constexpr std::size_t kFilesBatchBytes = 4 * 1024 * 1024;
+
+// 每个线程复用一个 EVP_MD_CTX，避免每次计算都分配与释放上下文；分配失败时下次重试
+[[nodiscard]] EVP_MD_CTX* thread_md_ctx() {
+    thread_local MdCtxPtr ctx;
     if (!ctx) {
-        spdlog::error("EVP_MD_CTX_new failed");
-        return std::nullopt;
+        ctx.reset(EVP_MD_CTX_new());
+        if (!ctx) {
+            spdlog::error("EVP_MD_CTX_new failed");
+        }
     }
-    return ctx;
+    return ctx.get();
 }
 
-[[nodiscard]] std::string to_hex(std::span<const std::byte> data) {
-    constexpr char kDigits[] = "0123456789abcdef";
-    std::string hex;
-    hex.reserve(data.size() * 2);
-    for (const auto value : data) {
-        const auto byte = std::to_integer<unsigned int>(value);
-        hex.push_back(kDigits[(byte >> 4U) & 0x0FU]);
-        hex.push_back(kDigits[byte & 0x0FU]);
+[[nodiscard]] std::optional<std::string> read_whole_file(const std::filesystem::path& file_path) {
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file) {
+        spdlog::error("Failed to open file: {}", file_path.string());
+        return std::nullopt;
     }
-    return hex;
-}
-} // namespace
-
-std::optional<std::array<std::byte, kSha256Size>> sha256(ConstDataBlock data) {
-    auto ctx_opt = make_md_ctx();
-    if (!ctx_opt) {
+    // 按打开时的大小一次读入；读取期间文件变长时多出的部分不计入
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(file_path, ec);
+    std::string content(ec ? 0 : static_cast<std::size_t>(size), '\0');
+    file.read(content.data(), static_cast<std::streamsize>(content.size()));
+    content.resize(static_cast<std::size_t>(file.gcount()));
+    if (file.bad()) {
+        spdlog::error("Error reading file: {}", file_path.string());
         return std::nullopt;
     }
-    auto& ctx = *ctx_opt;
+    return content;
+}
 
-    if (EVP_DigestInit_ex(ctx.get(), EVP_sha256(), nullptr) != 1) {
+[[nodiscard]] bool digest_init(EVP_MD_CTX* ctx) {
+    if (EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr) != 1) {
         spdlog::error("EVP_DigestInit_ex failed");
-        return std::nullopt;
+        return false;
     }
-    if (!data.empty()) {
-        if (EVP_DigestUpdate(ctx.get(), data.data(), data.size()) != 1) {
-            spdlog::error("EVP_DigestUpdate failed");
-            return std::nullopt;
-        }
+    return true;
+}
+
+[[nodiscard]] bool digest_update(EVP_MD_CTX* ctx, ConstDataBlock data) {
+    if (data.empty()) {
+        return true;
+    }
+    if (EVP_DigestUpdate(ctx, data.data(), data.size()) != 1) {
+        spdlog::error("EVP_DigestUpdate failed");
+        return false;
     }
+    return true;
+}
 
-    std::array<std::byte, kSha256Size> digest{};
+[[nodiscard]] std::optional<Sha256Digest> digest_final(EVP_MD_CTX* ctx) {
+    Sha256Digest digest{};
     unsigned int digest_size = 0;
-    if (EVP_DigestFinal_ex(ctx.get(), reinterpret_cast<unsigned char*>(digest.data()), &digest_size)
+    if (EVP_DigestFinal_ex(ctx, reinterpret_cast<unsigned char*>(digest.data()), &digest_size)
         != 1) {
         spdlog::error("EVP_DigestFinal_ex failed");
         return std::nullopt;
@@ -71,30 +87,125 @@ std::optional<std::array<std::byte, kSha256Size>> sha256(ConstDataBlock data) {
     return digest;
 }
 
+[[nodiscard]] std::optional<Sha256Digest> sha256_with(EVP_MD_CTX* ctx, ConstDataBlock data) {
+    if (ctx == nullptr || !digest_init(ctx) || !digest_update(ctx, data)) {
+        return std::nullopt;
+    }
+    return digest_final(ctx);
+}
+} // namespace
+
+std::string to_hex(ConstDataBlock data) {
+    constexpr char kDigits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(data.size() * 2);
+    for (const auto value : data) {
+        const auto byte = std::to_integer<unsigned int>(value);
+        hex.push_back(kDigits[(byte >> 4U) & 0x0FU]);
+        hex.push_back(kDigits[byte & 0x0FU]);
+    }
+    return hex;
+}
+
+std::optional<Sha256Digest> sha256(ConstDataBlock data) {
+    return sha256_with(thread_md_ctx(), data);
+}
+
 std::optional<std::string> sha256_hex(ConstDataBlock data) {
     const auto digest = sha256(data);
     if (!digest) {
         return std::nullopt;
     }
-    return to_hex(std::span<const std::byte>(digest->data(), digest->size()));
+    return to_hex(*digest);
 }
 
-std::optional<std::array<std::byte, kSha256Size>> sha256_file(
-    const std::filesystem::path& file_path) {
+std::optional<std::vector<Sha256Digest>> sha256_many(std::span<const ConstDataBlock> blocks) {
+    std::vector<Sha256Digest> digests(blocks.size());
+    if (blocks.empty()) {
+        return digests;
+    }
+
+    // 小块交给多缓冲内核按通道并行计算；大块单流吞吐已足够，且会拖住其它通道，仍走 EVP
+    const bool use_multi_buffer = detail::multi_buffer_available();
+    std::vector<ConstDataBlock> lane_inputs;
+    std::vector<std::size_t> lane_indices;
+
+    auto* ctx = thread_md_ctx();
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        if (use_multi_buffer && blocks[i].size() <= detail::kMultiBufferMaxSize) {
+            lane_inputs.push_back(blocks[i]);
+            lane_indices.push_back(i);
+            continue;
+        }
+        auto digest = sha256_with(ctx, blocks[i]);
+        if (!digest) {
+            return std::nullopt;
+        }
+        digests[i] = *digest;
+    }
+
+    if (!lane_inputs.empty()) {
+        std::vector<Sha256Digest> lane_digests(lane_inputs.size());
+        if (!detail::sha256_multi_buffer(lane_inputs, lane_digests)) {
+            return std::nullopt;
+        }
+        for (std::size_t i = 0; i < lane_indices.size(); ++i) {
+            digests[lane_indices[i]] = lane_digests[i];
+        }
+    }
+    return digests;
+}
+
+std::vector<std::optional<Sha256Digest>> sha256_files(
+    std::span<const std::filesystem::path> file_paths) {
+    std::vector<std::optional<Sha256Digest>> digests(file_paths.size());
+    std::vector<std::string> contents;
+    std::vector<std::size_t> indices;
+    std::size_t buffered = 0;
+
+    auto flush = [&]() {
+        std::vector<ConstDataBlock> blocks;
+        blocks.reserve(contents.size());
+        for (const auto& content : contents) {
+            blocks.push_back(as_block(content));
+        }
+        if (auto batch = sha256_many(blocks)) {
+            for (std::size_t i = 0; i < indices.size(); ++i) {
+                digests[indices[i]] = (*batch)[i];
+            }
+        }
+        contents.clear();
+        indices.clear();
+        buffered = 0;
+    };
+
+    for (std::size_t i = 0; i < file_paths.size(); ++i) {
+        auto content = read_whole_file(file_paths[i]);
+        if (!content) {
+            continue;
+        }
+        buffered += content->size();
+        contents.push_back(std::move(*content));
+        indices.push_back(i);
+        if (buffered >= kFilesBatchBytes) {
+            flush();
+        }
+    }
+    if (!contents.empty()) {
+        flush();
+    }
+    return digests;
+}
+
+std::optional<Sha256Digest> sha256_file(const std::filesystem::path& file_path) {
     std::ifstream file(file_path, std::ios::binary);
     if (!file) {
         spdlog::error("Failed to open file: {}", file_path.string());
         return std::nullopt;
     }
 
-    auto ctx_opt = make_md_ctx();
-    if (!ctx_opt) {
-        return std::nullopt;
-    }
-    auto& ctx = *ctx_opt;
-
-    if (EVP_DigestInit_ex(ctx.get(), EVP_sha256(), nullptr) != 1) {
-        spdlog::error("EVP_DigestInit_ex failed");
+    auto* ctx = thread_md_ctx();
+    if (ctx == nullptr || !digest_init(ctx)) {
         return std::nullopt;
     }
 
@@ -105,11 +216,8 @@ std::optional<std::array<std::byte, kSha256Size>> sha256_file(
         file.read(reinterpret_cast<char*>(buffer.data()), kBufferSize);
         const auto bytes_read = static_cast<std::size_t>(file.gcount());
 
-        if (bytes_read > 0) {
-            if (EVP_DigestUpdate(ctx.get(), buffer.data(), bytes_read) != 1) {
-                spdlog::error("EVP_DigestUpdate failed");
-                return std::nullopt;
-            }
+        if (!digest_update(ctx, ConstDataBlock(buffer.data(), bytes_read))) {
+            return std::nullopt;
         }
     }
 
@@ -118,18 +226,55 @@ std::optional<std::array<std::byte, kSha256Size>> sha256_file(
         return std::nullopt;
     }
 
-    std::array<std::byte, kSha256Size> digest{};
-    unsigned int digest_size = 0;
-    if (EVP_DigestFinal_ex(ctx.get(), reinterpret_cast<unsigned char*>(digest.data()), &digest_size)
-        != 1) {
-        spdlog::error("EVP_DigestFinal_ex failed");
+    return digest_final(ctx);
+}
+
+std::optional<FileDigests> sha256_file_chunks(const std::filesystem::path& file_path,
+                                              std::size_t chunk_size) {
+    if (chunk_size == 0) {
         return std::nullopt;
     }
-    if (digest_size != digest.size()) {
-        spdlog::error("Unexpected SHA-256 digest size: {}", digest_size);
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file) {
+        spdlog::error("Failed to open file: {}", file_path.string());
         return std::nullopt;
     }
-    return digest;
+
+    // 整文件摘要需要贯穿整个读取过程，单独持有一个上下文；分块摘要复用线程上下文
+    MdCtxPtr file_ctx{EVP_MD_CTX_new()};
+    auto* chunk_ctx = thread_md_ctx();
+    if (!file_ctx || chunk_ctx == nullptr || !digest_init(file_ctx.get())) {
+        return std::nullopt;
+    }
+
+    FileDigests digests;
+    std::vector<std::byte> buffer(chunk_size);
+    while (file) {
+        file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(chunk_size));
+        const auto bytes_read = static_cast<std::size_t>(file.gcount());
+        if (bytes_read == 0) {
+            break;
+        }
+
+        const ConstDataBlock block(buffer.data(), bytes_read);
+        auto chunk_digest = sha256_with(chunk_ctx, block);
+        if (!chunk_digest || !digest_update(file_ctx.get(), block)) {
+            return std::nullopt;
+        }
+        digests.chunks.push_back(*chunk_digest);
+    }
+
+    if (file.bad()) {
+        spdlog::error("Error reading file: {}", file_path.string());
+        return std::nullopt;
+    }
+
+    auto file_digest = digest_final(file_ctx.get());
+    if (!file_digest) {
+        return std::nullopt;
+    }
+    digests.file = *file_digest;
+    return digests;
 }
 
 std::optional<std::string> sha256_file_hex(const std::filesystem::path& file_path) {
@@ -137,6 +282,6 @@ std::optional<std::string> sha256_file_hex(const std::filesystem::path& file_pat
     if (!digest) {
         return std::nullopt;
     }
-    return to_hex(std::span<const std::byte>(digest->data(), digest->size()));
+    return to_hex(*digest);
 }
 } // namespace util::hash
@@ -2,16 +2,82 @@
 
 #include "util/data_block.h"
 #include <array>
+#include <cstdint>
+#include <cstring>
 #include <filesystem>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace util::hash {
 constexpr std::size_t kSha256Size = 32;
 
-std::optional<std::array<std::byte, kSha256Size>> sha256(ConstDataBlock data);
+// 协议与分块表中统一使用定长二进制摘要，十六进制仅用于日志输出
+using Sha256Digest = std::array<std::byte, kSha256Size>;
+
+std::optional<Sha256Digest> sha256(ConstDataBlock data);
 std::optional<std::string> sha256_hex(ConstDataBlock data);
 
-std::optional<std::array<std::byte, kSha256Size>> sha256_file(const std::filesystem::path& file_path);
+// 批量计算多个相互独立的缓冲区，结果与输入一一对应。
+// 复用同一个摘要上下文，CPU 支持时以多缓冲 SIMD 内核同时处理多个小缓冲区。
+std::optional<std::vector<Sha256Digest>> sha256_many(std::span<const ConstDataBlock> blocks);
+
+// 批量计算多个小文件的整文件摘要，结果与输入一一对应，读取失败的为 nullopt。
+// 文件整体读入内存后分批交给 sha256_many，只适合远小于分块大小的文件
+std::vector<std::optional<Sha256Digest>> sha256_files(
+    std::span<const std::filesystem::path> file_paths);
+
+std::optional<Sha256Digest> sha256_file(const std::filesystem::path& file_path);
 std::optional<std::string> sha256_file_hex(const std::filesystem::path& file_path);
+
+struct FileDigests {
+    Sha256Digest file;
+    std::vector<Sha256Digest> chunks; // 按 chunk_size 切分，空文件没有分块
+};
+
+// 一次读取同时得到整文件摘要与各分块摘要
+std::optional<FileDigests> sha256_file_chunks(const std::filesystem::path& file_path,
+                                              std::size_t chunk_size);
+
+std::string to_hex(ConstDataBlock data);
+
+inline std::string to_hex(const Sha256Digest& digest) {
+    return to_hex(ConstDataBlock(digest.data(), digest.size()));
+}
+
+inline ConstDataBlock as_block(std::string_view bytes) {
+    return {reinterpret_cast<const std::byte*>(bytes.data()), bytes.size()};
+}
+
+// 从 protobuf bytes 字段解析摘要，长度不符时返回 nullopt
+inline std::optional<Sha256Digest> to_digest(ConstDataBlock bytes) {
+    if (bytes.size() != kSha256Size) {
+        return std::nullopt;
+    }
+    Sha256Digest digest;
+    std::memcpy(digest.data(), bytes.data(), kSha256Size);
+    return digest;
+}
+
+// 按 8 字节定宽比较，无提前退出分支，编译器可直接向量化
+inline bool digest_equal(const Sha256Digest& lhs, ConstDataBlock rhs) {
+    if (rhs.size() != kSha256Size) {
+        return false;
+    }
+    std::uint64_t diff = 0;
+    for (std::size_t i = 0; i < kSha256Size; i += sizeof(std::uint64_t)) {
+        std::uint64_t a = 0;
+        std::uint64_t b = 0;
+        std::memcpy(&a, lhs.data() + i, sizeof(a));
+        std::memcpy(&b, rhs.data() + i, sizeof(b));
+        diff |= a ^ b;
+    }
+    return diff == 0;
+}
+
+inline bool digest_equal(const Sha256Digest& lhs, const Sha256Digest& rhs) {
+    return digest_equal(lhs, ConstDataBlock(rhs.data(), rhs.size()));
+}
 } // namespace util::hash
@@ -0,0 +1,254 @@
+#include "util/sha256_multi_buffer.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define XNN_HAS_AVX2_SHA256 1
+#include <cpuid.h>
+#include <immintrin.h>
+#else
+#define XNN_HAS_AVX2_SHA256 0
+#endif
+
+namespace util::hash::detail {
+namespace {
+bool fallback(std::span<const ConstDataBlock> inputs, std::span<Sha256Digest> outputs) {
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        auto digest = sha256(inputs[i]);
+        if (!digest) {
+            return false;
+        }
+        outputs[i] = *digest;
+    }
+    return true;
+}
+
+#if XNN_HAS_AVX2_SHA256
+constexpr std::size_t kBlockSize = 64;
+
+constexpr std::array<std::uint32_t, 64> kRoundConstants = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+constexpr std::array<std::uint32_t, 8> kInitialState = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+// 每个通道当前负责的输入。整块部分直接从输入读取，不足一块的尾部与填充拷贝到 tail 中
+struct Lane {
+    bool active = false;
+    std::size_t input_index = 0;
+    std::size_t offset = 0;
+    std::size_t full_end = 0;
+    std::size_t tail_blocks = 0;
+    std::size_t tail_done = 0;
+    alignas(32) std::array<std::byte, 2 * kBlockSize> tail{};
+
+    void load(std::size_t index, ConstDataBlock input) {
+        active = true;
+        input_index = index;
+        offset = 0;
+        tail_done = 0;
+        full_end = input.size() / kBlockSize * kBlockSize;
+
+        const std::size_t remain = input.size() - full_end;
+        tail.fill(std::byte{0});
+        if (remain > 0) {
+            std::memcpy(tail.data(), input.data() + full_end, remain);
+        }
+        tail[remain] = std::byte{0x80};
+        tail_blocks = remain + 1 + sizeof(std::uint64_t) <= kBlockSize ? 1 : 2;
+
+        const std::uint64_t bit_length = static_cast<std::uint64_t>(input.size()) * 8;
+        auto* length_pos = tail.data() + tail_blocks * kBlockSize - sizeof(std::uint64_t);
+        for (std::size_t i = 0; i < sizeof(std::uint64_t); ++i) {
+            length_pos[i] = static_cast<std::byte>(bit_length >> (56 - 8 * i));
+        }
+    }
+
+    const std::byte* block(ConstDataBlock input) const {
+        if (offset < full_end) {
+            return input.data() + offset;
+        }
+        return tail.data() + tail_done * kBlockSize;
+    }
+
+    // 前进一个块，返回该输入是否已全部处理
+    bool advance() {
+        if (offset < full_end) {
+            offset += kBlockSize;
+        } else {
+            ++tail_done;
+        }
+        return tail_done == tail_blocks;
+    }
+};
+
+inline std::uint32_t load_be32(const std::byte* p) {
+    return (std::to_integer<std::uint32_t>(p[0]) << 24) | (std::to_integer<std::uint32_t>(p[1]) << 16)
+           | (std::to_integer<std::uint32_t>(p[2]) << 8) | std::to_integer<std::uint32_t>(p[3]);
+}
+
+template<int N>
+__attribute__((target("avx2"))) inline __m256i rotr(__m256i x) {
+    return _mm256_or_si256(_mm256_srli_epi32(x, N), _mm256_slli_epi32(x, 32 - N));
+}
+
+__attribute__((target("avx2"))) inline __m256i add3(__m256i a, __m256i b, __m256i c) {
+    return _mm256_add_epi32(_mm256_add_epi32(a, b), c);
+}
+
+// state[i][lane] 为第 lane 路的第 i 个状态字，words[t][lane] 为第 lane 路当前块的第 t 个消息字
+__attribute__((target("avx2"))) void compress_lanes(std::uint32_t (&state)[8][kMultiBufferLanes],
+                                                    const std::uint32_t (&words)[16][kMultiBufferLanes]) {
+    __m256i w[64];
+    for (int t = 0; t < 16; ++t) {
+        w[t] = _mm256_load_si256(reinterpret_cast<const __m256i*>(words[t]));
+    }
+    for (int t = 16; t < 64; ++t) {
+        const __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr<7>(w[t - 15]), rotr<18>(w[t - 15])),
+                                            _mm256_srli_epi32(w[t - 15], 3));
+        const __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr<17>(w[t - 2]), rotr<19>(w[t - 2])),
+                                            _mm256_srli_epi32(w[t - 2], 10));
+        w[t] = _mm256_add_epi32(add3(w[t - 16], s0, w[t - 7]), s1);
+    }
+
+    __m256i v[8];
+    for (int i = 0; i < 8; ++i) {
+        v[i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[i]));
+    }
+    __m256i a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5], g = v[6], h = v[7];
+
+    for (int t = 0; t < 64; ++t) {
+        const __m256i big_s1 = _mm256_xor_si256(_mm256_xor_si256(rotr<6>(e), rotr<11>(e)), rotr<25>(e));
+        const __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        const __m256i k = _mm256_set1_epi32(static_cast<int>(kRoundConstants[t]));
+        const __m256i t1 = _mm256_add_epi32(add3(h, big_s1, ch), _mm256_add_epi32(k, w[t]));
+        const __m256i big_s0 = _mm256_xor_si256(_mm256_xor_si256(rotr<2>(a), rotr<13>(a)), rotr<22>(a));
+        const __m256i maj = _mm256_xor_si256(_mm256_xor_si256(_mm256_and_si256(a, b),
+                                                              _mm256_and_si256(a, c)),
+                                             _mm256_and_si256(b, c));
+        const __m256i t2 = _mm256_add_epi32(big_s0, maj);
+        h = g;
+        g = f;
+        f = e;
+        e = _mm256_add_epi32(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm256_add_epi32(t1, t2);
+    }
+
+    const __m256i out[8] = {a, b, c, d, e, f, g, h};
+    for (int i = 0; i < 8; ++i) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(state[i]), _mm256_add_epi32(v[i], out[i]));
+    }
+}
+
+__attribute__((target("avx2"))) void run_lanes(std::span<const ConstDataBlock> inputs,
+                                               std::span<Sha256Digest> outputs) {
+    std::array<Lane, kMultiBufferLanes> lanes;
+    alignas(32) std::uint32_t state[8][kMultiBufferLanes];
+    alignas(32) std::uint32_t words[16][kMultiBufferLanes];
+    alignas(32) static constexpr std::array<std::byte, kBlockSize> kIdleBlock{};
+
+    std::size_t next_input = 0;
+    auto assign = [&](std::size_t lane_index) {
+        auto& lane = lanes[lane_index];
+        if (next_input >= inputs.size()) {
+            lane.active = false;
+            return;
+        }
+        lane.load(next_input, inputs[next_input]);
+        for (std::size_t i = 0; i < 8; ++i) {
+            state[i][lane_index] = kInitialState[i];
+        }
+        ++next_input;
+    };
+
+    for (std::size_t lane_index = 0; lane_index < kMultiBufferLanes; ++lane_index) {
+        assign(lane_index);
+    }
+
+    std::size_t active_lanes = std::min(inputs.size(), kMultiBufferLanes);
+    while (active_lanes > 0) {
+        for (std::size_t lane_index = 0; lane_index < kMultiBufferLanes; ++lane_index) {
+            const auto& lane = lanes[lane_index];
+            const std::byte* block = lane.active ? lane.block(inputs[lane.input_index])
+                                                 : kIdleBlock.data();
+            for (std::size_t t = 0; t < 16; ++t) {
+                words[t][lane_index] = load_be32(block + t * 4);
+            }
+        }
+
+        compress_lanes(state, words);
+
+        for (std::size_t lane_index = 0; lane_index < kMultiBufferLanes; ++lane_index) {
+            auto& lane = lanes[lane_index];
+            if (!lane.active || !lane.advance()) {
+                continue;
+            }
+
+            auto& digest = outputs[lane.input_index];
+            for (std::size_t i = 0; i < 8; ++i) {
+                const std::uint32_t word = state[i][lane_index];
+                digest[i * 4] = static_cast<std::byte>(word >> 24);
+                digest[i * 4 + 1] = static_cast<std::byte>(word >> 16);
+                digest[i * 4 + 2] = static_cast<std::byte>(word >> 8);
+                digest[i * 4 + 3] = static_cast<std::byte>(word);
+            }
+
+            assign(lane_index);
+            if (!lane.active) {
+                --active_lanes;
+            }
+        }
+    }
+}
+
+bool cpu_has_avx2() {
+    return __builtin_cpu_supports("avx2");
+}
+
+bool cpu_has_sha_extensions() {
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) == 0) {
+        return false;
+    }
+    return (ebx & (1U << 29)) != 0;
+}
+#endif
+} // namespace
+
+bool multi_buffer_available() {
+#if XNN_HAS_AVX2_SHA256
+    static const bool available = cpu_has_avx2() && !cpu_has_sha_extensions();
+    return available;
+#else
+    return false;
+#endif
+}
+
+bool sha256_multi_buffer(std::span<const ConstDataBlock> inputs, std::span<Sha256Digest> outputs) {
+    if (outputs.size() != inputs.size()) {
+        return false;
+    }
+#if XNN_HAS_AVX2_SHA256
+    static const bool has_avx2 = cpu_has_avx2();
+    if (has_avx2) {
+        run_lanes(inputs, outputs);
+        return true;
+    }
+#endif
+    return fallback(inputs, outputs);
+}
+} // namespace util::hash::detail
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "util/hash.h"
+#include <cstddef>
+#include <span>
+
+// 多缓冲 SHA-256 内核，供 util::hash::sha256_many 使用。
+// 将多个相互独立的输入按 SIMD 通道交错，每个通道各自维护一份哈希状态，
+// 某个通道的输入处理完毕后立即装载下一个输入，保证通道尽量满载。
+namespace util::hash::detail {
+// AVX2 下每个 256 位寄存器容纳 8 路 32 位字
+constexpr std::size_t kMultiBufferLanes = 8;
+
+// 超过该大小的输入独占通道时间过长，交给单流实现（SHA-NI / OpenSSL 汇编）更划算
+constexpr std::size_t kMultiBufferMaxSize = 64 * 1024;
+
+// CPU 支持 AVX2 且没有 SHA 指令扩展时返回 true；有 SHA-NI 时单流实现已经更快
+bool multi_buffer_available();
+
+// outputs.size() 必须等于 inputs.size()。
+// CPU 不支持 AVX2 时逐个调用 sha256() 计算，结果一致。
+bool sha256_multi_buffer(std::span<const ConstDataBlock> inputs, std::span<Sha256Digest> outputs);
+} // namespace util::hash::detail
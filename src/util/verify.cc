@@ -0,0 +1,28 @@
+#include "util/verify.h"
+#include <fmt/format.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <time.h>
+#endif
+
+namespace util {
+std::chrono::nanoseconds VerifyCost::thread_cpu_time() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec ts{};
+    if (::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+        return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+    }
+#endif
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch());
+}
+
+std::string VerifyCost::summary(VerifyPolicy policy) const {
+    const auto cpu_ms = std::chrono::duration<double, std::milli>(cpu_time()).count();
+    return fmt::format("policy={}, cpu={:.3f} ms, hashed={} bytes, extra_read={} bytes",
+                       transfer::TransferMetadataRequest::VerifyPolicy_Name(policy),
+                       cpu_ms,
+                       bytes_hashed(),
+                       bytes_read());
+}
+} // namespace util
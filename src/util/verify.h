@@ -0,0 +1,67 @@
+#pragma once
+
+#include "transfer.pb.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace util {
+using VerifyPolicy = transfer::TransferMetadataRequest::VerifyPolicy;
+
+inline bool verifies_chunks(VerifyPolicy policy) {
+    return policy == transfer::TransferMetadataRequest::VERIFY_BOTH
+           || policy == transfer::TransferMetadataRequest::VERIFY_CHUNK;
+}
+
+inline bool verifies_file(VerifyPolicy policy) {
+    return policy == transfer::TransferMetadataRequest::VERIFY_BOTH
+           || policy == transfer::TransferMetadataRequest::VERIFY_FILE;
+}
+
+// 统计一次会话中校验本身消耗的 CPU 时间与 I/O，便于按需求选择最便宜的校验级别。
+// 分块可能在线程池的多个线程上并发校验，计数均为原子量。
+class VerifyCost {
+  public:
+    // 在当前线程上执行 fn 并计入其 CPU 时间。
+    // bytes_hashed 为参与摘要计算的字节数，bytes_read 为仅为校验而额外读取的磁盘字节数
+    template<typename Fn>
+    auto track(std::uint64_t bytes_hashed, std::uint64_t bytes_read, Fn&& fn) {
+        const auto begin = thread_cpu_time();
+        auto result = std::forward<Fn>(fn)();
+        record(thread_cpu_time() - begin, bytes_hashed, bytes_read);
+        return result;
+    }
+
+    void record(std::chrono::nanoseconds cpu_time,
+                std::uint64_t bytes_hashed,
+                std::uint64_t bytes_read) {
+        cpu_ns_.fetch_add(static_cast<std::uint64_t>(cpu_time.count()), std::memory_order_relaxed);
+        bytes_hashed_.fetch_add(bytes_hashed, std::memory_order_relaxed);
+        bytes_read_.fetch_add(bytes_read, std::memory_order_relaxed);
+    }
+
+    std::chrono::nanoseconds cpu_time() const {
+        return std::chrono::nanoseconds(cpu_ns_.load(std::memory_order_relaxed));
+    }
+    std::uint64_t bytes_hashed() const { return bytes_hashed_.load(std::memory_order_relaxed); }
+    std::uint64_t bytes_read() const { return bytes_read_.load(std::memory_order_relaxed); }
+
+    void reset() {
+        cpu_ns_.store(0, std::memory_order_relaxed);
+        bytes_hashed_.store(0, std::memory_order_relaxed);
+        bytes_read_.store(0, std::memory_order_relaxed);
+    }
+
+    std::string summary(VerifyPolicy policy) const;
+
+  private:
+    // 当前线程的 CPU 时间；平台不支持时退化为单调时钟
+    static std::chrono::nanoseconds thread_cpu_time();
+
+    std::atomic<std::uint64_t> cpu_ns_{0};
+    std::atomic<std::uint64_t> bytes_hashed_{0};
+    std::atomic<std::uint64_t> bytes_read_{0};
+};
+} // namespace util
@@ -0,0 +1,252 @@
+#include "gtest/gtest.h"
+#include <asio/awaitable.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/use_awaitable.hpp>
+#include <atomic>
+#include <chrono>
+#include <core/channel.h>
+#include <core/executor.h>
+#include <core/pipeline.h>
+#include <future>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+class ChannelTest : public ::testing::Test {
+  protected:
+    // 两个线程运行 io_context，生产者与消费者真正并发
+    core::Executor executor{2, 2};
+    std::thread runner;
+
+    void SetUp() override {
+        runner = std::thread([this]() { executor.start(); });
+    }
+
+    void TearDown() override {
+        executor.stop();
+        if (runner.joinable()) {
+            runner.join();
+        }
+    }
+};
+
+asio::awaitable<void> sleep_for(std::chrono::milliseconds duration) {
+    asio::steady_timer timer(co_await asio::this_coro::executor, duration);
+    co_await timer.async_wait(asio::use_awaitable);
+}
+} // namespace
+
+TEST_F(ChannelTest, PushBlocksWhenFull) {
+    core::Channel<int> channel(2);
+    std::atomic<int> pushed{0};
+    std::promise<void> done;
+    auto future = done.get_future();
+
+    executor.spawn([&]() -> asio::awaitable<void> {
+        for (int i = 0; i < 5; ++i) {
+            co_await channel.push(i);
+            pushed.fetch_add(1);
+        }
+        done.set_value();
+    });
+
+    std::this_thread::sleep_for(50ms);
+    EXPECT_EQ(pushed.load(), 2);
+    EXPECT_EQ(channel.size(), 2U);
+
+    std::vector<int> received;
+    std::promise<void> drained;
+    executor.spawn([&]() -> asio::awaitable<void> {
+        for (int i = 0; i < 5; ++i) {
+            received.push_back(*co_await channel.pop());
+        }
+        drained.set_value();
+    });
+
+    ASSERT_EQ(future.wait_for(1s), std::future_status::ready);
+    ASSERT_EQ(drained.get_future().wait_for(1s), std::future_status::ready);
+    EXPECT_EQ(received, (std::vector<int>{0, 1, 2, 3, 4}));
+}
+
+TEST_F(ChannelTest, CloseWakesReceiversAfterDrain) {
+    core::Channel<int> channel(4);
+    std::promise<std::vector<int>> done;
+    auto future = done.get_future();
+
+    executor.spawn([&]() -> asio::awaitable<void> {
+        std::vector<int> received;
+        while (auto value = co_await channel.pop()) {
+            received.push_back(*value);
+        }
+        done.set_value(received);
+    });
+    executor.spawn([&]() -> asio::awaitable<void> {
+        co_await channel.push(1);
+        co_await sleep_for(20ms);
+        co_await channel.push(2);
+        channel.close();
+        EXPECT_FALSE(co_await channel.push(3));
+    });
+
+    ASSERT_EQ(future.wait_for(1s), std::future_status::ready);
+    EXPECT_EQ(future.get(), (std::vector<int>{1, 2}));
+}
+
+// 多个生产者与消费者混用单个与批量接口，每个元素恰好被取出一次
+TEST_F(ChannelTest, MultiProducerMultiConsumerDeliversEachItemOnce) {
+    constexpr int kProducers = 4;
+    constexpr int kConsumers = 4;
+    constexpr int kItems = 20000;
+    core::Channel<int> channel(64);
+    std::vector<std::atomic<int>> seen(kProducers * kItems);
+    std::atomic<int> producers_left{kProducers};
+    std::atomic<int> consumers_left{kConsumers};
+    std::promise<void> done;
+    auto future = done.get_future();
+
+    for (int p = 0; p < kProducers; ++p) {
+        executor.spawn([&, p]() -> asio::awaitable<void> {
+            const int base = p * kItems;
+            if (p % 2 == 0) {
+                for (int i = 0; i < kItems; ++i) {
+                    co_await channel.push(base + i);
+                }
+            } else {
+                for (int i = 0; i < kItems; i += 100) {
+                    std::vector<int> batch;
+                    for (int j = i; j < i + 100; ++j) {
+                        batch.push_back(base + j);
+                    }
+                    co_await channel.push_batch(std::move(batch));
+                }
+            }
+            if (producers_left.fetch_sub(1) == 1) {
+                channel.close();
+            }
+        });
+    }
+    for (int c = 0; c < kConsumers; ++c) {
+        executor.spawn([&, c]() -> asio::awaitable<void> {
+            while (true) {
+                std::vector<int> values;
+                if (c % 2 == 0) {
+                    if (auto value = co_await channel.pop()) {
+                        values.push_back(*value);
+                    }
+                } else {
+                    values = co_await channel.pop_batch(32);
+                }
+                if (values.empty()) {
+                    break;
+                }
+                for (int value : values) {
+                    seen[value].fetch_add(1);
+                }
+            }
+            if (consumers_left.fetch_sub(1) == 1) {
+                done.set_value();
+            }
+        });
+    }
+
+    ASSERT_EQ(future.wait_for(10s), std::future_status::ready);
+    int wrong = 0;
+    for (auto& count : seen) {
+        wrong += count.load() == 1 ? 0 : 1;
+    }
+    EXPECT_EQ(wrong, 0);
+}
+
+// 末级处理慢时各级通道被填满，源头受到背压，且每级排队数不超过深度
+TEST_F(ChannelTest, PipelineAppliesBackpressure) {
+    constexpr int kItems = 200;
+    core::Pipeline pipeline(executor, 4);
+    auto& source = pipeline.make_channel<int>();
+    auto& squared = pipeline.make_channel<long long>();
+    std::atomic<long long> sum{0};
+    std::atomic<int> produced{0};
+
+    pipeline.stage(
+        "square",
+        source,
+        squared,
+        [](int value) -> asio::awaitable<long long> {
+            co_return static_cast<long long>(value) * value;
+        },
+        2);
+    pipeline.sink("sum", squared, [&sum](long long value) -> asio::awaitable<void> {
+        co_await sleep_for(1ms);
+        sum.fetch_add(value);
+    });
+
+    std::promise<void> done;
+    auto future = done.get_future();
+    executor.spawn([&]() -> asio::awaitable<void> {
+        for (int i = 0; i < kItems; ++i) {
+            co_await source.push(i);
+            produced.fetch_add(1);
+        }
+        source.close();
+        co_await pipeline.join();
+        done.set_value();
+    });
+
+    std::this_thread::sleep_for(30ms);
+    // 尚未被末级处理完的元素最多为：两级通道各 4 个、平方级 2 个工作协程、
+    // 末级 1 个正在处理的元素以及源头手中的 1 个
+    const int in_flight = produced.load();
+    const auto occupancy = pipeline.occupancy();
+    ASSERT_EQ(occupancy.size(), 2U);
+    EXPECT_LE(in_flight - static_cast<int>(occupancy[1].processed), 4 + 4 + 2 + 1 + 1);
+    EXPECT_EQ(occupancy[0].name, "square");
+    EXPECT_EQ(occupancy[1].capacity, 4U);
+    EXPECT_LE(occupancy[1].queued, 4U);
+
+    ASSERT_EQ(future.wait_for(5s), std::future_status::ready);
+    long long expected = 0;
+    for (long long i = 0; i < kItems; ++i) {
+        expected += i * i;
+    }
+    EXPECT_EQ(sum.load(), expected);
+    EXPECT_EQ(pipeline.occupancy()[1].processed, static_cast<std::size_t>(kItems));
+}
+
+// 前面的级在末级添加前就已退出时，join() 仍要等到末级处理完
+TEST_F(ChannelTest, PipelineJoinWaitsForLateSink) {
+    core::Pipeline pipeline(executor, 4);
+    auto& source = pipeline.make_channel<int>();
+    auto& squared = pipeline.make_channel<long long>();
+    std::atomic<long long> sum{0};
+
+    std::promise<void> filled;
+    executor.spawn([&]() -> asio::awaitable<void> {
+        for (int i = 1; i <= 3; ++i) {
+            co_await source.push(i);
+        }
+        source.close();
+        filled.set_value();
+    });
+    ASSERT_EQ(filled.get_future().wait_for(1s), std::future_status::ready);
+
+    pipeline.stage("square", source, squared, [](int value) -> asio::awaitable<long long> {
+        co_return static_cast<long long>(value) * value;
+    });
+    // 让平方级取空输入并退出
+    std::this_thread::sleep_for(30ms);
+    pipeline.sink("sum", squared, [&sum](long long value) -> asio::awaitable<void> {
+        co_await sleep_for(5ms);
+        sum.fetch_add(value);
+    });
+
+    std::promise<long long> done;
+    auto future = done.get_future();
+    executor.spawn([&]() -> asio::awaitable<void> {
+        co_await pipeline.join();
+        done.set_value(sum.load());
+    });
+
+    ASSERT_EQ(future.wait_for(5s), std::future_status::ready);
+    EXPECT_EQ(future.get(), 1 + 4 + 9);
+}
@@ -1,8 +1,12 @@
 #include "gtest/gtest.h"
 #include <asio/awaitable.hpp>
+#include <atomic>
 #include <chrono>
 #include <core/executor.h>
 #include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
 
 using namespace std::chrono_literals;
 
@@ -25,3 +29,144 @@ TEST(CoroutineTest, ExecutorTest) {
         runner.join();
     }
 }
+
+TEST(CoroutineTest, OffloadReturnsResultOnCallerStrand) {
+    core::Executor executor(2);
+    auto strand = executor.make_strand();
+    std::promise<std::pair<int, bool>> done;
+    auto future = done.get_future();
+
+    executor.spawn_on(strand, [&]() -> asio::awaitable<void> {
+        const auto io_thread = std::this_thread::get_id();
+        std::thread::id worker_thread;
+        const int result = co_await executor.offload([&worker_thread]() {
+            worker_thread = std::this_thread::get_id();
+            return 42;
+        });
+        // 计算在工作线程上执行，结果回到 strand 上继续
+        done.set_value({result, worker_thread != io_thread && strand.running_in_this_thread()});
+    });
+
+    std::thread runner([&executor]() { executor.start(); });
+
+    ASSERT_EQ(future.wait_for(500ms), std::future_status::ready);
+    const auto [result, resumed_on_strand] = future.get();
+    EXPECT_EQ(result, 42);
+    EXPECT_TRUE(resumed_on_strand);
+
+    executor.stop();
+    if (runner.joinable()) {
+        runner.join();
+    }
+}
+
+TEST(CoroutineTest, OffloadRunsNestedTasks) {
+    constexpr int kTasks = 64;
+    core::Executor executor(4);
+    std::atomic<int> finished{0};
+    std::promise<void> done;
+    auto future = done.get_future();
+
+    for (int i = 0; i < kTasks; ++i) {
+        executor.spawn([&]() -> asio::awaitable<void> {
+            // 工作线程内再次提交的任务进入本地队列，空闲线程会把它们窃取走
+            co_await executor.offload([&executor]() {
+                for (int j = 0; j < 4; ++j) {
+                    executor.get_cpu_pool().submit([]() {});
+                }
+            });
+            if (finished.fetch_add(1) + 1 == kTasks) {
+                done.set_value();
+            }
+        });
+    }
+
+    std::thread runner([&executor]() { executor.start(); });
+
+    ASSERT_EQ(future.wait_for(2s), std::future_status::ready);
+    EXPECT_EQ(finished.load(), kTasks);
+
+    executor.stop();
+    if (runner.joinable()) {
+        runner.join();
+    }
+}
+
+// fn 抛出的异常回到调用方的 strand 上重新抛出，工作线程不受影响
+TEST(CoroutineTest, OffloadRethrowsOnCaller) {
+    core::Executor executor(2);
+    auto strand = executor.make_strand();
+    std::promise<std::pair<std::string, bool>> done;
+    auto future = done.get_future();
+
+    executor.spawn_on(strand, [&]() -> asio::awaitable<void> {
+        try {
+            co_await executor.offload([]() -> int { throw std::runtime_error("offload failed"); });
+            done.set_value({"", false});
+        } catch (const std::runtime_error& e) {
+            done.set_value({e.what(), strand.running_in_this_thread()});
+        }
+    });
+
+    std::thread runner([&executor]() { executor.start(); });
+
+    ASSERT_EQ(future.wait_for(500ms), std::future_status::ready);
+    const auto [message, on_strand] = future.get();
+    EXPECT_EQ(message, "offload failed");
+    EXPECT_TRUE(on_strand);
+
+    executor.stop();
+    if (runner.joinable()) {
+        runner.join();
+    }
+}
+
+// 线程池停止后提交的任务不会执行，调用方以 operation_aborted 恢复而不是永远挂起
+TEST(CoroutineTest, OffloadAbortsWhenPoolStopped) {
+    core::Executor executor(1);
+    std::promise<bool> done;
+    auto future = done.get_future();
+    executor.get_cpu_pool().stop();
+
+    executor.spawn([&]() -> asio::awaitable<void> {
+        try {
+            co_await executor.offload([]() {});
+            done.set_value(false);
+        } catch (const asio::system_error& e) {
+            done.set_value(e.code() == asio::error::operation_aborted);
+        }
+    });
+
+    std::thread runner([&executor]() { executor.start(); });
+
+    ASSERT_EQ(future.wait_for(500ms), std::future_status::ready);
+    EXPECT_TRUE(future.get());
+
+    executor.stop();
+    if (runner.joinable()) {
+        runner.join();
+    }
+}
+
+// 传入的执行器不是 io_context 的执行器（例如已经是 strand）时退化为再包一层 strand
+TEST(CoroutineTest, SerialExecutorAcceptsNonIoContextExecutor) {
+    core::Executor executor;
+    const asio::any_io_executor strand = executor.make_strand();
+    auto serial = executor.make_serial_executor(strand);
+    std::promise<void> done;
+    auto future = done.get_future();
+
+    executor.spawn_on(serial, [&done]() -> asio::awaitable<void> {
+        done.set_value();
+        co_return;
+    });
+
+    std::thread runner([&executor]() { executor.start(); });
+
+    ASSERT_EQ(future.wait_for(500ms), std::future_status::ready);
+
+    executor.stop();
+    if (runner.joinable()) {
+        runner.join();
+    }
+}
@@ -0,0 +1,102 @@
+#include "gtest/gtest.h"
+#include <asio/awaitable.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/use_awaitable.hpp>
+#include <atomic>
+#include <chrono>
+#include <core/executor.h>
+#include <future>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+namespace {
+core::MetricsOptions fast_metrics() {
+    core::MetricsOptions options;
+    options.probe_interval = 5ms;
+    options.window = 50ms;
+    options.lag_warning = 0ms;
+    return options;
+}
+
+// 等待下一个完整的统计窗口结束
+void wait_windows(int count = 3) {
+    std::this_thread::sleep_for(count * 60ms);
+}
+} // namespace
+
+TEST(ExecutorMetricsTest, ReportsBlockingHandlerAndLoopLag) {
+    core::Executor executor(1);
+    executor.set_metrics_options(fast_metrics());
+    std::promise<void> done;
+    auto future = done.get_future();
+
+    std::thread runner([&executor]() { executor.start(); });
+    std::this_thread::sleep_for(20ms);
+
+    // 模拟在处理函数中同步计算哈希，阻塞事件循环
+    executor.spawn([&done]() -> asio::awaitable<void> {
+        std::this_thread::sleep_for(120ms);
+        done.set_value();
+        co_return;
+    });
+    ASSERT_EQ(future.wait_for(1s), std::future_status::ready);
+
+    bool found = false;
+    for (int i = 0; i < 20 && !found; ++i) {
+        const auto metrics = executor.metrics();
+        found = metrics.longest_handler >= 100ms;
+        if (found) {
+            EXPECT_GE(metrics.max_loop_lag, 50ms);
+            EXPECT_NE(metrics.longest_handler_site.find("executor_metrics_tests.cc"),
+                      std::string::npos)
+                << metrics.longest_handler_site;
+        } else {
+            std::this_thread::sleep_for(10ms);
+        }
+    }
+    EXPECT_TRUE(found);
+
+    executor.stop();
+    if (runner.joinable()) {
+        runner.join();
+    }
+}
+
+TEST(ExecutorMetricsTest, CountsHandlersAndActiveCoroutines) {
+    core::Executor executor(1);
+    executor.set_metrics_options(fast_metrics());
+    std::atomic<bool> release{false};
+    std::atomic<int> finished{0};
+
+    for (int i = 0; i < 3; ++i) {
+        executor.spawn([&]() -> asio::awaitable<void> {
+            asio::steady_timer timer(co_await asio::this_coro::executor);
+            while (!release.load()) {
+                timer.expires_after(1ms);
+                co_await timer.async_wait(asio::use_awaitable);
+            }
+            finished.fetch_add(1);
+        });
+    }
+    EXPECT_EQ(executor.metrics().active_coroutines, 3U);
+
+    std::thread runner([&executor]() { executor.start(); });
+    wait_windows();
+
+    const auto busy = executor.metrics();
+    EXPECT_EQ(busy.active_coroutines, 3U);
+    EXPECT_GT(busy.handlers_per_second, 100.0);
+
+    release.store(true);
+    for (int i = 0; i < 100 && finished.load() < 3; ++i) {
+        std::this_thread::sleep_for(5ms);
+    }
+    wait_windows(1);
+    EXPECT_EQ(executor.metrics().active_coroutines, 0U);
+
+    executor.stop();
+    if (runner.joinable()) {
+        runner.join();
+    }
+}
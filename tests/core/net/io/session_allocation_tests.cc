@@ -0,0 +1,125 @@
+#include "core/executor.h"
+#include "core/net/io/session.h"
+#include "transfer.pb.h"
+#include <asio/version.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <new>
+#include <thread>
+
+// 统计测试期间全局 operator new 的调用次数，只在 g_counting 打开时计数。
+// 替换全局分配函数会影响同一程序中的所有测试，这个文件单独构建为 allocation_tests。
+// 替换函数不内联，编译器不会把内联后的 free 与调用方的 operator new 误判为不匹配
+#if defined(__GNUC__)
+#define ALLOCATION_NOINLINE __attribute__((noinline))
+#else
+#define ALLOCATION_NOINLINE
+#endif
+
+namespace {
+std::atomic<bool> g_counting{false};
+std::atomic<std::size_t> g_allocations{0};
+} // namespace
+
+ALLOCATION_NOINLINE void* operator new(std::size_t size) {
+    if (g_counting.load(std::memory_order_relaxed)) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* pointer = std::malloc(size > 0 ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+ALLOCATION_NOINLINE void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+ALLOCATION_NOINLINE void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+namespace {
+constexpr int kWarmupRoundTrips = 200;
+constexpr int kMeasuredRoundTrips = 2000;
+
+// 稳态下每次往返（两条消息）允许的堆分配次数，剩余的主要是 protobuf 解析时分配的字符串。
+// 旧版 asio 每类内存块只缓存一块，嵌套的协程帧仍会访问堆，预算相应放宽
+#if defined(ASIO_VERSION) && ASIO_VERSION >= 102400
+constexpr double kMaxAllocationsPerRoundTrip = 16;
+#else
+constexpr double kMaxAllocationsPerRoundTrip = 40;
+#endif
+
+class EchoSession : public core::net::io::Session {
+  public:
+    EchoSession(core::Executor& executor, std::uint16_t port)
+        : core::net::io::Session(executor, port) {}
+
+  private:
+    asio::awaitable<void> handle_message(const MessageWrapper& message) override {
+        transfer::FileChunkResponse response;
+        if (response.ParseFromString(message.payload())) {
+            co_await send(response);
+        }
+    }
+};
+
+class PingSession : public core::net::io::Session {
+  public:
+    PingSession(core::Executor& executor, std::uint16_t port)
+        : core::net::io::Session(executor, "127.0.0.1", port) {}
+
+    asio::awaitable<void> ping() {
+        transfer::FileChunkResponse request;
+        request.set_chunk_index(round_trips_.load());
+        request.set_status(transfer::FileChunkResponse::RECEIVED);
+        co_await send(request);
+    }
+
+    std::atomic<int> round_trips_{0};
+    std::atomic<bool> done_{false};
+
+  private:
+    asio::awaitable<void> handle_message(const MessageWrapper&) override {
+        const int count = round_trips_.fetch_add(1) + 1;
+        if (count == kWarmupRoundTrips) {
+            g_allocations.store(0);
+            g_counting.store(true);
+        }
+        if (count == kWarmupRoundTrips + kMeasuredRoundTrips) {
+            g_counting.store(false);
+            done_.store(true);
+            co_return;
+        }
+        co_await ping();
+    }
+};
+} // namespace
+
+TEST(SessionAllocationTest, SteadyStateMessagesAvoidHeap) {
+    core::Executor executor(1, 1);
+    EchoSession server(executor, 15300);
+    PingSession client(executor, 15300);
+    client.spawn(client.ping());
+
+    std::thread runner([&executor]() { executor.start(); });
+
+    const auto start = std::chrono::steady_clock::now();
+    while (!client.done_.load()
+           && std::chrono::steady_clock::now() - start < std::chrono::seconds(20)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    g_counting.store(false);
+
+    executor.stop();
+    if (runner.joinable()) {
+        runner.join();
+    }
+
+    ASSERT_TRUE(client.done_.load());
+    const auto per_round_trip = static_cast<double>(g_allocations.load()) / kMeasuredRoundTrips;
+    EXPECT_LE(per_round_trip, kMaxAllocationsPerRoundTrip);
+}
@@ -0,0 +1,79 @@
+#include "core/executor.h"
+#include "core/net/io/session.h"
+#include "transfer.pb.h"
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+constexpr int kBulkFrames = 32;
+
+// 记录消息的到达顺序
+class RecordingSession : public core::net::io::Session {
+  public:
+    RecordingSession(core::Executor& executor, std::uint16_t port)
+        : core::net::io::Session(executor, port) {}
+
+    std::vector<std::string> arrivals() const {
+        std::lock_guard lock(mutex_);
+        return arrivals_;
+    }
+
+  private:
+    asio::awaitable<void> handle_message(const MessageWrapper& message) override {
+        std::lock_guard lock(mutex_);
+        arrivals_.push_back(message.type());
+        co_return;
+    }
+
+    mutable std::mutex mutex_;
+    std::vector<std::string> arrivals_;
+};
+
+class ClientSession : public core::net::io::Session {
+  public:
+    ClientSession(core::Executor& executor, std::uint16_t port)
+        : core::net::io::Session(executor, "127.0.0.1", port) {}
+};
+} // namespace
+
+// 同一个流上数据帧积压时，之后发出的控制帧在下一个帧边界就写出，不等积压排空
+TEST(SessionPriorityTest, ControlFramesPreemptQueuedBulk) {
+    core::Executor executor(1, 1);
+    RecordingSession server(executor, 15310);
+    ClientSession client(executor, 15310);
+
+    client.spawn([&]() -> asio::awaitable<void> {
+        transfer::FileChunkRequest chunk;
+        chunk.set_data(std::string(256 * 1024, 'x'));
+        for (int i = 0; i < kBulkFrames; ++i) {
+            chunk.set_chunk_index(i);
+            client.spawn(client.send(1, chunk, {}, core::net::io::FramePriority::Bulk));
+        }
+        transfer::FileChunkResponse ack;
+        ack.set_chunk_index(0);
+        co_await client.send(1, ack);
+    }());
+
+    std::thread runner([&executor]() { executor.start(); });
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (server.arrivals().size() < kBulkFrames + 1
+           && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    executor.stop();
+    runner.join();
+
+    const auto arrivals = server.arrivals();
+    ASSERT_EQ(arrivals.size(), kBulkFrames + 1u);
+    std::size_t ack_position = 0;
+    while (arrivals[ack_position] != "transfer.FileChunkResponse") {
+        ++ack_position;
+    }
+    // 只可能排在正在写出的那一个数据帧之后
+    EXPECT_LE(ack_position, 1u);
+}
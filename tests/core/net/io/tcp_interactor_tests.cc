@@ -1,8 +1,14 @@
 #include "core/executor.h"
 #include "core/net/io/tcp_interactor.h"
+#include "core/timer/deadline.h"
 #include "transfer.pb.h"
 #include <asio/ip/tcp.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/system_error.hpp>
+#include <asio/this_coro.hpp>
+#include <asio/use_awaitable.hpp>
 #include <atomic>
+#include <chrono>
 #include <gtest/gtest.h>
 #include <thread>
 
@@ -142,3 +148,221 @@ TEST_F(TcpInteractorTest, MultipleMessages) {
     RunExecutor(executor, done);
     EXPECT_EQ(received_count.load(), kCount);
 }
+
+TEST_F(TcpInteractorTest, ShardedListenersShareOnePort) {
+    core::Executor executor(1, 2, core::IoMode::Sharded);
+    ASSERT_EQ(executor.get_shard_count(), 2U);
+    EXPECT_NE(&executor.next_io_context(), &executor.next_io_context());
+
+    // 两个分片在同一端口上监听，新连接由内核分给其中一个
+    asio::ip::tcp::socket first_socket(executor.get_io_context(0));
+    asio::ip::tcp::socket second_socket(executor.get_io_context(1));
+    asio::ip::tcp::socket client_socket(executor.get_io_context(0));
+
+    TcpInteractor first(executor, first_socket, 14680);
+    TcpInteractor second(executor, second_socket, 14680);
+    TcpInteractor client(executor, client_socket, "127.0.0.1", 14680);
+
+    first.start();
+    second.start();
+    client.start();
+
+    std::atomic<bool> done{false};
+    std::atomic<int> received_by{0};
+
+    executor.spawn_on(client.strand(), [&]() -> asio::awaitable<void> {
+        transfer::FileInfoRequest req;
+        req.set_relative_path("sharded.txt");
+        co_await client.send_message(req);
+    });
+
+    // 分片模式下会话直接运行在所属分片的 io_context 上
+    auto receive_on = [&](TcpInteractor& server, int id) {
+        auto& shard = executor.get_io_context(static_cast<size_t>(id - 1));
+        executor.spawn_on(server.strand(), [&server, &shard, &done, &received_by, id]()
+                                               -> asio::awaitable<void> {
+            auto message = co_await server.receive_message<transfer::FileInfoRequest>();
+            if (message && message->relative_path() == "sharded.txt"
+                && shard.get_executor().running_in_this_thread()) {
+                received_by.store(id);
+                done.store(true);
+            }
+        });
+    };
+    receive_on(first, 1);
+    receive_on(second, 2);
+
+    RunExecutor(executor, done);
+
+    EXPECT_TRUE(done.load());
+    EXPECT_NE(received_by.load(), 0);
+}
+
+// 对端不发送数据时，接收在截止时间到达后以 timed_out 结束，且不早于截止时间
+TEST_F(TcpInteractorTest, ReceiveTimesOutAtDeadline) {
+    core::Executor executor;
+    asio::ip::tcp::socket server_socket(executor.get_io_context());
+    asio::ip::tcp::socket client_socket(executor.get_io_context());
+
+    TcpInteractor server(executor, server_socket, 14653);
+    TcpInteractor client(executor, client_socket, "127.0.0.1", 14653);
+
+    server.start();
+    client.start();
+
+    std::atomic<bool> done{false};
+    asio::error_code error;
+    std::chrono::steady_clock::duration waited{};
+
+    executor.spawn_on(server.strand(), [&]() -> asio::awaitable<void> {
+        std::byte storage[64];
+        MutDataBlock buffer(storage, sizeof(storage));
+        co_await server.receive(buffer); // 触发 accept 完成后再计时
+        const auto start = std::chrono::steady_clock::now();
+        const auto deadline = core::timer::Deadline::after(std::chrono::milliseconds(50));
+        try {
+            buffer = MutDataBlock(storage, sizeof(storage));
+            co_await server.receive(buffer, deadline);
+        } catch (const asio::system_error& e) {
+            error = e.code();
+        }
+        waited = std::chrono::steady_clock::now() - start;
+        done.store(true);
+    });
+    executor.spawn_on(client.strand(), [&]() -> asio::awaitable<void> {
+        const std::byte first{1};
+        co_await client.send(ConstDataBlock(&first, 1));
+    });
+
+    RunExecutor(executor, done);
+
+    ASSERT_TRUE(done.load());
+    EXPECT_EQ(error, asio::error::timed_out);
+    EXPECT_GE(waited, std::chrono::milliseconds(50));
+    EXPECT_LT(waited, std::chrono::milliseconds(500));
+}
+
+// 连接级截止时间约束之后的每次收发，单次传入的更晚截止时间不能放宽它
+TEST_F(TcpInteractorTest, ConnectionDeadlineBoundsNestedReceive) {
+    core::Executor executor;
+    asio::ip::tcp::socket server_socket(executor.get_io_context());
+    asio::ip::tcp::socket client_socket(executor.get_io_context());
+
+    TcpInteractor server(executor, server_socket, 14654);
+    TcpInteractor client(executor, client_socket, "127.0.0.1", 14654);
+
+    server.start();
+    client.start();
+
+    std::atomic<bool> done{false};
+    asio::error_code error;
+    int received = 0;
+
+    executor.spawn_on(server.strand(), [&]() -> asio::awaitable<void> {
+        server.set_deadline(core::timer::Deadline::after(std::chrono::milliseconds(100)));
+        const auto loose = core::timer::Deadline::after(std::chrono::seconds(10));
+        try {
+            while (true) {
+                std::byte storage[64];
+                MutDataBlock buffer(storage, sizeof(storage));
+                co_await server.receive(buffer, loose);
+                ++received;
+            }
+        } catch (const asio::system_error& e) {
+            error = e.code();
+        }
+        done.store(true);
+    });
+    executor.spawn_on(client.strand(), [&]() -> asio::awaitable<void> {
+        const std::byte first{1};
+        co_await client.send(ConstDataBlock(&first, 1));
+    });
+
+    RunExecutor(executor, done, 2);
+
+    ASSERT_TRUE(done.load());
+    EXPECT_EQ(error, asio::error::timed_out);
+    EXPECT_GE(received, 1);
+}
+
+// 截止时间只中止被限时的那一次接收，同一 socket 上先挂起的接收继续等待并收到之后的数据
+TEST_F(TcpInteractorTest, DeadlineCancelsOnlyItsOwnOperation) {
+    core::Executor executor;
+    asio::ip::tcp::socket server_socket(executor.get_io_context());
+    asio::ip::tcp::socket client_socket(executor.get_io_context());
+
+    TcpInteractor server(executor, server_socket, 14655);
+    TcpInteractor client(executor, client_socket, "127.0.0.1", 14655);
+
+    server.start();
+    client.start();
+
+    std::atomic<bool> timed_out{false};
+    std::atomic<bool> done{false};
+    asio::error_code error;
+    std::byte received{0};
+
+    executor.spawn_on(server.strand(), [&]() -> asio::awaitable<void> {
+        std::byte storage[1];
+        MutDataBlock buffer(storage, sizeof(storage));
+        co_await server.receive(buffer); // 连接建立后再挂起两个接收
+        executor.spawn_on(server.strand(), [&]() -> asio::awaitable<void> {
+            std::byte timed_storage[1];
+            MutDataBlock timed_buffer(timed_storage, sizeof(timed_storage));
+            try {
+                co_await server.receive(
+                    timed_buffer, core::timer::Deadline::after(std::chrono::milliseconds(50)));
+            } catch (const asio::system_error& e) {
+                error = e.code();
+            }
+            timed_out.store(true);
+        });
+        buffer = MutDataBlock(storage, sizeof(storage));
+        co_await server.receive(buffer);
+        received = storage[0];
+        done.store(true);
+    });
+    executor.spawn_on(client.strand(), [&]() -> asio::awaitable<void> {
+        const std::byte first{1};
+        co_await client.send(ConstDataBlock(&first, 1));
+        while (!timed_out.load()) {
+            asio::steady_timer delay(co_await asio::this_coro::executor,
+                                     std::chrono::milliseconds(10));
+            co_await delay.async_wait(asio::use_awaitable);
+        }
+        const std::byte second{2};
+        co_await client.send(ConstDataBlock(&second, 1));
+    });
+
+    RunExecutor(executor, done);
+
+    ASSERT_TRUE(done.load());
+    EXPECT_EQ(error, asio::error::timed_out);
+    EXPECT_EQ(received, std::byte{2});
+}
+
+// 已关闭的 socket 上收发不能当作成功
+TEST_F(TcpInteractorTest, SendOnClosedSocketThrowsNotConnected) {
+    core::Executor executor;
+    asio::ip::tcp::socket socket(executor.get_io_context());
+    socket.open(asio::ip::tcp::v4());
+    TcpInteractor interactor(executor, socket);
+    socket.close();
+
+    std::atomic<bool> done{false};
+    asio::error_code error;
+    executor.spawn_on(interactor.strand(), [&]() -> asio::awaitable<void> {
+        const std::byte data{1};
+        try {
+            co_await interactor.send(ConstDataBlock(&data, 1));
+        } catch (const asio::system_error& e) {
+            error = e.code();
+        }
+        done.store(true);
+    });
+
+    RunExecutor(executor, done);
+
+    ASSERT_TRUE(done.load());
+    EXPECT_EQ(error, asio::error::not_connected);
+}
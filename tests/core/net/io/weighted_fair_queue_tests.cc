@@ -0,0 +1,65 @@
+#include "core/net/io/weighted_fair_queue.h"
+#include <gtest/gtest.h>
+#include <map>
+#include <vector>
+
+using core::net::io::WeightedFairQueue;
+
+TEST(WeightedFairQueueTest, KeepsOrderWithinStream) {
+    WeightedFairQueue<int> queue;
+    for (int i = 0; i < 5; ++i) {
+        queue.push(7, 100, i);
+    }
+    for (int i = 0; i < 5; ++i) {
+        const auto next = queue.pop();
+        ASSERT_TRUE(next.has_value());
+        EXPECT_EQ(next->first, 7u);
+        EXPECT_EQ(next->second, i);
+    }
+    EXPECT_FALSE(queue.pop().has_value());
+    EXPECT_TRUE(queue.empty());
+}
+
+// 大流已经积压时新到的小流不用等它排空
+TEST(WeightedFairQueueTest, SmallStreamIsNotBlockedByBacklog) {
+    WeightedFairQueue<int> queue;
+    for (int i = 0; i < 100; ++i) {
+        queue.push(1, 64 * 1024, i);
+    }
+    queue.pop();
+    queue.push(2, 100, -1);
+
+    const auto next = queue.pop();
+    ASSERT_TRUE(next.has_value());
+    EXPECT_EQ(next->first, 2u);
+    EXPECT_EQ(queue.size(), 99u);
+}
+
+TEST(WeightedFairQueueTest, SharesByWeight) {
+    WeightedFairQueue<int> queue;
+    queue.set_weight(1, 3);
+    for (int i = 0; i < 400; ++i) {
+        queue.push(1, 1000, i);
+        queue.push(2, 1000, i);
+    }
+
+    // 两个流都忙碌时，前 200 个元素大致按 3:1 分配
+    std::map<std::uint32_t, int> popped;
+    for (int i = 0; i < 200; ++i) {
+        ++popped[queue.pop()->first];
+    }
+    EXPECT_NEAR(popped[1], 150, 2);
+    EXPECT_NEAR(popped[2], 50, 2);
+}
+
+TEST(WeightedFairQueueTest, DrainReturnsEverything) {
+    WeightedFairQueue<int> queue;
+    queue.push(1, 10, 1);
+    queue.push(2, 10, 2);
+    queue.push(1, 10, 3);
+
+    std::vector<int> drained;
+    queue.drain([&](std::uint32_t, int item) { drained.push_back(item); });
+    EXPECT_EQ(drained, (std::vector<int>{1, 3, 2}));
+    EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,109 @@
+#include "gtest/gtest.h"
+#include <asio/awaitable.hpp>
+#include <chrono>
+#include <core/buffer_pool.h>
+#include <core/executor.h>
+#include <core/numa.h>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <thread>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+using namespace std::chrono_literals;
+
+namespace {
+void write_file(const std::filesystem::path& path, const std::string& content) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream(path) << content;
+}
+} // namespace
+
+TEST(NumaTest, ParsesCpuList) {
+    EXPECT_EQ(core::numa::parse_cpu_list("0-3,8,10-11\n"),
+              (std::vector<std::size_t>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(core::numa::parse_cpu_list("5"), (std::vector<std::size_t>{5}));
+    EXPECT_EQ(core::numa::parse_cpu_list("x,3-1,2"), (std::vector<std::size_t>{2}));
+    EXPECT_TRUE(core::numa::parse_cpu_list("").empty());
+}
+
+TEST(NumaTest, DetectsNicNodeFromSysfs) {
+    const auto root = std::filesystem::temp_directory_path() / "xnn_numa_sysfs";
+    std::filesystem::remove_all(root);
+    write_file(root / "class/net/eth1/device/numa_node", "1\n");
+    write_file(root / "class/net/veth0/device/numa_node", "-1\n");
+    write_file(root / "devices/system/node/node1/cpulist", "8-11\n");
+    write_file(root / "route", "Iface\tDestination\tGateway\n"
+                               "eth0\t000200C0\t00000000\n"
+                               "eth1\t00000000\t010200C0\n");
+
+    EXPECT_EQ(core::numa::interface_node("eth1", root), 1);
+    EXPECT_EQ(core::numa::interface_node("veth0", root), std::nullopt);
+    EXPECT_EQ(core::numa::interface_node("missing", root), std::nullopt);
+    EXPECT_EQ(core::numa::node_cpus(1, root), (std::vector<std::size_t>{8, 9, 10, 11}));
+    EXPECT_TRUE(core::numa::node_cpus(2, root).empty());
+    EXPECT_EQ(core::numa::default_route_interface(root / "route"), "eth1");
+
+    std::filesystem::remove_all(root);
+}
+
+TEST(NumaTest, BufferPoolReusesBuffers) {
+    core::BufferPool pool(64 * 1024, 1, 0);
+    auto buffer = pool.acquire();
+    ASSERT_TRUE(buffer);
+    EXPECT_EQ(buffer.size(), 64U * 1024);
+    buffer.data()[buffer.size() - 1] = std::byte{1};
+    auto* first = buffer.data();
+    buffer.reset();
+    EXPECT_EQ(pool.cached(), 1U);
+
+    auto again = pool.acquire();
+    EXPECT_EQ(again.data(), first);
+    auto other = pool.acquire();
+    ASSERT_TRUE(other);
+    EXPECT_NE(other.data(), first);
+
+    // 超过缓存上限的缓冲区直接释放
+    again.reset();
+    other.reset();
+    EXPECT_EQ(pool.cached(), 1U);
+}
+
+#if defined(__linux__)
+TEST(NumaTest, ExecutorPinsIoAndPoolThreads) {
+    core::Executor executor(2, 1, core::IoMode::Sharded);
+    core::AffinityOptions options;
+    options.io_cpus = {0};
+    options.pool_cpus = {0};
+    executor.set_affinity(options);
+
+    auto pinned_to_cpu0 = []() {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        sched_getaffinity(0, sizeof(set), &set);
+        return CPU_COUNT(&set) == 1 && CPU_ISSET(0, &set);
+    };
+
+    std::promise<std::pair<bool, bool>> done;
+    auto future = done.get_future();
+    executor.spawn([&]() -> asio::awaitable<void> {
+        const bool io_pinned = pinned_to_cpu0();
+        const bool pool_pinned = co_await executor.offload(pinned_to_cpu0);
+        done.set_value({io_pinned, pool_pinned});
+    });
+
+    std::thread runner([&executor]() { executor.start(); });
+    ASSERT_EQ(future.wait_for(1s), std::future_status::ready);
+    const auto [io_pinned, pool_pinned] = future.get();
+    EXPECT_TRUE(io_pinned);
+    EXPECT_TRUE(pool_pinned);
+
+    executor.stop();
+    if (runner.joinable()) {
+        runner.join();
+    }
+}
+#endif
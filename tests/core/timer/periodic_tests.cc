@@ -0,0 +1,102 @@
+#include "core/timer/periodic.h"
+#include "timer_test_fixture.h"
+#include <asio/awaitable.hpp>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+long long ms_between(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count();
+}
+} // namespace
+
+// 任务耗时不会推迟后续周期：第 k 次执行位于 start + k * period 之后不远处
+TEST_F(TimerTest, PeriodicKeepsAbsoluteSchedule) {
+    constexpr int kTicks = 10;
+    auto strand = executor.make_strand();
+    auto periodic = std::make_shared<core::timer::Periodic<>>(strand, 20ms);
+    std::promise<std::vector<Clock::time_point>> done;
+    auto future = done.get_future();
+    const auto start = Clock::now();
+
+    executor.spawn_on(strand, [&, periodic]() -> asio::awaitable<void> {
+        std::vector<Clock::time_point> ticks;
+        co_await periodic->run([&]() {
+            ticks.push_back(Clock::now());
+            std::this_thread::sleep_for(8ms); // 模拟耗时的任务
+            if (ticks.size() == kTicks) {
+                periodic->cancel();
+            }
+        });
+        done.set_value(ticks);
+    });
+
+    ASSERT_EQ(future.wait_for(2s), std::future_status::ready);
+    const auto ticks = future.get();
+    ASSERT_EQ(ticks.size(), static_cast<size_t>(kTicks));
+    for (int k = 0; k < kTicks; ++k) {
+        EXPECT_GE(ms_between(start, ticks[k]), 20 * (k + 1));
+    }
+    // 若每轮都重新计时，十轮至少需要 280ms
+    EXPECT_LT(ms_between(start, ticks.back()), 20 * kTicks + 40);
+}
+
+TEST_F(TimerTest, PeriodicJitterStaysWithinBound) {
+    constexpr int kTicks = 8;
+    auto strand = executor.make_strand();
+    auto periodic = std::make_shared<core::timer::Periodic<>>(strand, 20ms, 5ms);
+    std::promise<std::vector<Clock::time_point>> done;
+    auto future = done.get_future();
+    const auto start = Clock::now();
+
+    executor.spawn_on(strand, [&, periodic]() -> asio::awaitable<void> {
+        std::vector<Clock::time_point> ticks;
+        co_await periodic->run(
+            [&]() -> asio::awaitable<void> {
+                ticks.push_back(Clock::now());
+                if (ticks.size() == kTicks) {
+                    periodic->cancel();
+                }
+                co_return;
+            },
+            true);
+        done.set_value(ticks);
+    });
+
+    ASSERT_EQ(future.wait_for(2s), std::future_status::ready);
+    const auto ticks = future.get();
+    ASSERT_EQ(ticks.size(), static_cast<size_t>(kTicks));
+    for (int k = 0; k < kTicks; ++k) {
+        EXPECT_GE(ms_between(start, ticks[k]), 20 * k);
+        EXPECT_LT(ms_between(start, ticks[k]), 20 * k + 5 + 15);
+    }
+}
+
+// cancel 立即唤醒等待中的 run，而不是等到下一个周期
+TEST_F(TimerTest, PeriodicCancelStopsPromptly) {
+    auto strand = executor.make_strand();
+    auto periodic = std::make_shared<core::timer::Periodic<>>(strand, 10s);
+    std::atomic<int> runs{0};
+    std::promise<void> done;
+    auto future = done.get_future();
+
+    executor.spawn_on(strand, [&, periodic]() -> asio::awaitable<void> {
+        co_await periodic->run([&]() { runs.fetch_add(1); });
+        done.set_value();
+    });
+
+    std::this_thread::sleep_for(20ms);
+    const auto cancelled_at = Clock::now();
+    periodic->cancel();
+    ASSERT_EQ(future.wait_for(500ms), std::future_status::ready);
+    EXPECT_LT(ms_between(cancelled_at, Clock::now()), 100);
+    EXPECT_EQ(runs.load(), 0);
+}
@@ -1,4 +1,5 @@
 #include "core/timer/spawn_with_timeout.h"
+#include "core/timer/timer_wheel.h"
 #include "timer_test_fixture.h"
 #include <asio/awaitable.hpp>
 #include <asio/steady_timer.hpp>
@@ -111,3 +112,27 @@ TEST_F(TimerTest, SpawnWithTimeoutImmediateCompletion) {
     ASSERT_TRUE(result.has_value());
     EXPECT_EQ(result.value(), "immediate");
 }
+
+// 任务先完成时，|| 通过取消槽取消时间轮上的超时，不必等满超时时间
+TEST_F(TimerTest, SpawnWithTimeoutWheelTimerReturnsOnCompletion) {
+    std::promise<std::optional<int>> result_promise;
+    auto future = result_promise.get_future();
+
+    executor.spawn([&result_promise]() -> asio::awaitable<void> {
+        auto task = []() -> asio::awaitable<int> {
+            asio::steady_timer timer(co_await asio::this_coro::executor, 20ms);
+            co_await timer.async_wait(asio::use_awaitable);
+            co_return 789;
+        };
+
+        auto result =
+            co_await core::timer::spawn_with_timeout<core::timer::WheelTimer>(task(), 10s);
+        result_promise.set_value(result);
+        co_return;
+    });
+
+    ASSERT_EQ(future.wait_for(500ms), std::future_status::ready);
+    auto result = future.get();
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result.value(), 789);
+}
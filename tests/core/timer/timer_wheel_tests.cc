@@ -0,0 +1,179 @@
+#include "core/timer/spawn_after_delay.h"
+#include "core/timer/spawn_at.h"
+#include "core/timer/timer_wheel.h"
+#include "timer_test_fixture.h"
+#include <asio/awaitable.hpp>
+#include <asio/bind_cancellation_slot.hpp>
+#include <asio/cancellation_signal.hpp>
+#include <asio/post.hpp>
+#include <asio/redirect_error.hpp>
+#include <asio/use_awaitable.hpp>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <optional>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+long long elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()
+                                                                 - start)
+        .count();
+}
+} // namespace
+
+TEST_F(TimerTest, WheelTimerFiresAfterExpiry) {
+    std::promise<std::pair<long long, bool>> done;
+    auto future = done.get_future();
+
+    executor.spawn([&done]() -> asio::awaitable<void> {
+        const auto start = std::chrono::steady_clock::now();
+        core::timer::WheelTimer timer(co_await asio::this_coro::executor, 50ms);
+        asio::error_code ec;
+        co_await timer.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+        done.set_value({elapsed_ms(start), !ec});
+    });
+
+    ASSERT_EQ(future.wait_for(500ms), std::future_status::ready);
+    const auto [elapsed, ok] = future.get();
+    EXPECT_TRUE(ok);
+    EXPECT_GE(elapsed, 50);
+    EXPECT_LE(elapsed, 100);
+}
+
+TEST_F(TimerTest, WheelTimerCancelAbortsWait) {
+    std::promise<asio::error_code> done;
+    auto future = done.get_future();
+    auto timer = std::make_shared<std::unique_ptr<core::timer::WheelTimer>>();
+
+    executor.spawn([&done, timer]() -> asio::awaitable<void> {
+        *timer = std::make_unique<core::timer::WheelTimer>(co_await asio::this_coro::executor, 10s);
+        asio::error_code ec;
+        co_await (*timer)->async_wait(asio::redirect_error(asio::use_awaitable, ec));
+        done.set_value(ec);
+    });
+    executor.spawn([timer]() -> asio::awaitable<void> {
+        asio::steady_timer delay(co_await asio::this_coro::executor, 20ms);
+        co_await delay.async_wait(asio::use_awaitable);
+        EXPECT_EQ((*timer)->cancel(), 1U);
+    });
+
+    ASSERT_EQ(future.wait_for(500ms), std::future_status::ready);
+    EXPECT_EQ(future.get(), asio::error::operation_aborted);
+}
+
+// 超过第 0 层一圈（256 个 tick）的定时器需要从上层下放后才会到期
+TEST_F(TimerTest, WheelTimersAcrossLevelsFireInOrder) {
+    constexpr int kTimers = 40;
+    std::promise<std::vector<int>> done;
+    auto future = done.get_future();
+    auto order = std::make_shared<std::vector<int>>();
+    auto remaining = std::make_shared<std::atomic<int>>(kTimers);
+
+    for (int i = 0; i < kTimers; ++i) {
+        const auto delay = 10ms * (i + 1);
+        executor.spawn([&done, order, remaining, delay, i]() -> asio::awaitable<void> {
+            const auto start = std::chrono::steady_clock::now();
+            core::timer::WheelTimer timer(co_await asio::this_coro::executor, delay);
+            co_await timer.async_wait(asio::use_awaitable);
+            EXPECT_GE(std::chrono::steady_clock::now() - start, delay);
+            order->push_back(i);
+            if (remaining->fetch_sub(1) == 1) {
+                done.set_value(*order);
+            }
+        });
+    }
+
+    ASSERT_EQ(future.wait_for(2s), std::future_status::ready);
+    const auto fired = future.get();
+    ASSERT_EQ(fired.size(), static_cast<size_t>(kTimers));
+    for (int i = 0; i < kTimers; ++i) {
+        EXPECT_EQ(fired[i], i);
+    }
+}
+
+TEST_F(TimerTest, TimerTemplatesRunOnWheel) {
+    std::promise<long long> delayed;
+    std::promise<long long> scheduled;
+    auto delayed_future = delayed.get_future();
+    auto scheduled_future = scheduled.get_future();
+    const auto start = std::chrono::steady_clock::now();
+
+    executor.spawn([&]() -> asio::awaitable<void> {
+        co_await core::timer::spawn_after_delay<core::timer::WheelTimer>(
+            [&]() -> asio::awaitable<void> {
+                delayed.set_value(elapsed_ms(start));
+                co_return;
+            },
+            60);
+    });
+    executor.spawn([&]() -> asio::awaitable<void> {
+        const auto at = start + 80ms;
+        co_await core::timer::spawn_at<core::timer::WheelTimer>(
+            [&]() -> asio::awaitable<void> {
+                scheduled.set_value(elapsed_ms(start));
+                co_return;
+            },
+            at);
+    });
+
+    ASSERT_EQ(delayed_future.wait_for(500ms), std::future_status::ready);
+    ASSERT_EQ(scheduled_future.wait_for(500ms), std::future_status::ready);
+    EXPECT_GE(delayed_future.get(), 60);
+    EXPECT_GE(scheduled_future.get(), 80);
+}
+
+// 用很小的 tick 让随机超时跨越多层，检查每个定时器都不早于设定时间到期
+TEST(TimerWheelTest, RandomTimersNeverFireEarly) {
+    asio::io_context io_context(1);
+    asio::make_service<core::timer::TimerWheel>(io_context, std::chrono::microseconds(10));
+
+    constexpr int kTimers = 2000;
+    std::vector<std::unique_ptr<core::timer::WheelTimer>> timers;
+    std::atomic<int> fired{0};
+    std::atomic<int> early{0};
+    std::uint32_t seed = 12345;
+    for (int i = 0; i < kTimers; ++i) {
+        seed = seed * 1664525U + 1013904223U;
+        const auto delay = std::chrono::microseconds(seed % 300000);
+        auto& timer = *timers.emplace_back(
+            std::make_unique<core::timer::WheelTimer>(io_context.get_executor(), delay));
+        timer.async_wait([&, expiry = timer.expiry()](const asio::error_code& ec) {
+            if (!ec) {
+                fired.fetch_add(1);
+                early.fetch_add(std::chrono::steady_clock::now() < expiry ? 1 : 0);
+            }
+        });
+    }
+    // 一部分在到期前取消
+    for (int i = 0; i < kTimers; i += 4) {
+        timers[i]->cancel();
+    }
+
+    io_context.run_for(2s);
+    EXPECT_EQ(fired.load(), kTimers - kTimers / 4);
+    EXPECT_EQ(early.load(), 0);
+    EXPECT_EQ(asio::use_service<core::timer::TimerWheel>(io_context).size(), 0U);
+}
+
+// 通过处理函数关联的取消槽取消时，等待以 operation_aborted 结束并从时间轮上摘下
+TEST(TimerWheelTest, CancellationSlotRemovesWait) {
+    asio::io_context io_context(1);
+    core::timer::WheelTimer timer(io_context.get_executor(), 10s);
+    asio::cancellation_signal signal;
+    std::optional<asio::error_code> result;
+    timer.async_wait(asio::bind_cancellation_slot(
+        signal.slot(), [&result](const asio::error_code& ec) { result = ec; }));
+
+    auto& wheel = asio::use_service<core::timer::TimerWheel>(io_context);
+    EXPECT_EQ(wheel.size(), 1U);
+    asio::post(io_context, [&signal]() { signal.emit(asio::cancellation_type::terminal); });
+
+    io_context.run_for(1s);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, asio::error::operation_aborted);
+    EXPECT_EQ(wheel.size(), 0U);
+}
@@ -0,0 +1,60 @@
+#include "core/work_stealing_pool.h"
+#include "receiver/directory_cache.h"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+class DirectoryCacheTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        root_ = std::filesystem::current_path() / "directory_cache_root";
+        std::filesystem::remove_all(root_);
+    }
+
+    void TearDown() override { std::filesystem::remove_all(root_); }
+
+    static std::string ReadFile(const std::filesystem::path& path) {
+        std::ifstream input(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+    }
+
+    std::filesystem::path root_;
+};
+
+// 清单中的目录（含重复与缺失的中间目录）在线程池上一次建好
+TEST_F(DirectoryCacheTest, CreatesManifestDirectoriesInParallel) {
+    std::vector<std::filesystem::path> directories;
+    for (int i = 0; i < 50; ++i) {
+        const auto top = root_ / ("t" + std::to_string(i % 5));
+        directories.push_back(top / ("d" + std::to_string(i)) / "leaf");
+        directories.push_back(top);
+    }
+
+    core::WorkStealingPool pool(4);
+    receiver::DirectoryCache cache;
+    EXPECT_TRUE(cache.create_all(directories, &pool));
+    for (const auto& directory : directories) {
+        EXPECT_TRUE(std::filesystem::is_directory(directory)) << directory;
+    }
+}
+
+// 文件相对缓存的父目录创建；缓存的目录被外部删除后重新建立
+TEST_F(DirectoryCacheTest, OpensFilesRelativeToCachedDirectories) {
+    receiver::DirectoryCache cache;
+    const auto path = root_ / "a" / "b" / "file.txt";
+
+    auto file = cache.open_file(path, true);
+    ASSERT_NE(file, nullptr);
+    EXPECT_TRUE(file->write_at(0, "first"));
+    file.reset();
+    EXPECT_EQ(ReadFile(path), "first");
+
+    std::filesystem::remove_all(root_ / "a");
+    file = cache.open_file(path, true);
+    ASSERT_NE(file, nullptr);
+    EXPECT_TRUE(file->write_at(0, "second"));
+    file.reset();
+    EXPECT_EQ(ReadFile(path), "second");
+}
@@ -0,0 +1,47 @@
+#include "receiver/packed_files.h"
+#include "transfer.pb.h"
+#include "util/hash.h"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+class PackedFilesTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        received_dir_ = std::filesystem::current_path() / "packed_received";
+        std::filesystem::remove_all(received_dir_);
+    }
+
+    void TearDown() override { std::filesystem::remove_all(received_dir_); }
+
+    static std::string ReadFile(const std::filesystem::path& path) {
+        std::ifstream input(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+    }
+
+    std::filesystem::path received_dir_;
+};
+
+TEST_F(PackedFilesTest, WritesVerifiedFilesAndRejectsMismatches) {
+    // 批次内容依次为三个文件
+    const std::string data = "alphabetagamma";
+    const std::string_view view(data);
+    const auto alpha_hash = util::hash::sha256(util::hash::as_block(view.substr(0, 5)));
+    const auto wrong_hash = util::hash::sha256(util::hash::as_block("other"));
+
+    const std::vector<receiver::PackedFile> files = {
+        {received_dir_ / "a" / "alpha.txt", view.substr(0, 5), 5, alpha_hash},
+        {received_dir_ / "a" / "beta.txt", view.substr(5, 4), 4, wrong_hash},
+        {received_dir_ / "b" / "gamma.txt", view.substr(9, 5), 6, std::nullopt},
+    };
+    const auto results =
+        receiver::write_packed_files(files, transfer::TransferMetadataRequest::VERIFY_BOTH);
+
+    EXPECT_EQ(results, (std::vector<bool>{true, false, false}));
+    EXPECT_EQ(ReadFile(received_dir_ / "a" / "alpha.txt"), "alpha");
+    // 校验或长度不符的文件不写出
+    EXPECT_FALSE(std::filesystem::exists(received_dir_ / "a" / "beta.txt"));
+    EXPECT_FALSE(std::filesystem::exists(received_dir_ / "b" / "gamma.txt"));
+}
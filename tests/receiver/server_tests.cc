@@ -0,0 +1,475 @@
+#include "core/executor.h"
+#include "core/net/io/frame.h"
+#include "receiver/admission.h"
+#include "receiver/server.h"
+#include "session.pb.h"
+#include "transfer.pb.h"
+#include "util/hash.h"
+#include <asio/co_spawn.hpp>
+#include <asio/ip/tcp.hpp>
+#include <asio/read.hpp>
+#include <asio/this_coro.hpp>
+#include <asio/use_awaitable.hpp>
+#include <asio/write.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::string file_content(int sender, int file) {
+    std::string content(4096 + sender * 16 + file, '\0');
+    for (std::size_t i = 0; i < content.size(); ++i) {
+        content[i] = static_cast<char>('A' + (i + sender + file) % 26);
+    }
+    return content;
+}
+
+std::string relative_path(int sender, int file) {
+    return "sender_" + std::to_string(sender) + "/file_" + std::to_string(file) + ".bin";
+}
+
+// 按 frame.h 的格式在 0 号流上收发一帧
+template<typename T>
+asio::awaitable<void> write_message(asio::ip::tcp::socket& socket, const T& message) {
+    MessageWrapper wrapper;
+    wrapper.set_type(T::descriptor()->full_name());
+    wrapper.set_payload(message.SerializeAsString());
+    const auto bytes = wrapper.SerializeAsString();
+    std::array<std::byte, core::net::io::kFrameHeaderSize> header;
+    core::net::io::encode_frame_header({static_cast<std::uint32_t>(bytes.size()), 0},
+                                       header.data());
+    const std::array<asio::const_buffer, 2> buffers{asio::buffer(header), asio::buffer(bytes)};
+    co_await asio::async_write(socket, buffers, asio::use_awaitable);
+}
+
+asio::awaitable<MessageWrapper> read_message(asio::ip::tcp::socket& socket) {
+    std::array<std::byte, core::net::io::kFrameHeaderSize> header;
+    co_await asio::async_read(socket, asio::buffer(header), asio::use_awaitable);
+    std::vector<char> buffer(core::net::io::decode_frame_header(header.data()).length);
+    co_await asio::async_read(socket, asio::buffer(buffer), asio::use_awaitable);
+    MessageWrapper wrapper;
+    wrapper.ParseFromArray(buffer.data(), static_cast<int>(buffer.size()));
+    co_return wrapper;
+}
+
+// 最简发送端：一问一答地发送 files 个单分块文件，全部成功时返回 true
+asio::awaitable<bool> send_files(std::uint16_t port, int sender, int files) {
+    asio::ip::tcp::socket socket(co_await asio::this_coro::executor);
+    co_await socket.async_connect({asio::ip::make_address("127.0.0.1"), port},
+                                  asio::use_awaitable);
+
+    transfer::TransferMetadataRequest metadata;
+    metadata.set_verify_policy(transfer::TransferMetadataRequest::VERIFY_BOTH);
+    for (int i = 0; i < files; ++i) {
+        const auto content = file_content(sender, i);
+        auto* info = metadata.add_files();
+        info->set_relative_path(relative_path(sender, i));
+        info->set_size(content.size());
+        const auto digest = util::hash::sha256(util::hash::as_block(content));
+        info->set_hash(std::string(reinterpret_cast<const char*>(digest->data()), digest->size()));
+        metadata.set_total_size(metadata.total_size() + content.size());
+    }
+    co_await write_message(socket, metadata);
+
+    transfer::TransferMetadataResponse ready;
+    ready.ParseFromString((co_await read_message(socket)).payload());
+    if (ready.status() != transfer::TransferMetadataResponse::READY) {
+        co_return false;
+    }
+
+    bool completed = false;
+    for (int i = 0; i < files && !completed; ++i) {
+        const auto content = file_content(sender, i);
+        transfer::FileChunkRequest chunk;
+        chunk.set_file_relative_path(relative_path(sender, i));
+        chunk.set_chunk_index(0);
+        chunk.set_data(content);
+        chunk.set_hash(metadata.files(i).hash());
+        chunk.set_is_last_chunk(true);
+        co_await write_message(socket, chunk);
+
+        // 每个文件依次收到分块应答与文件应答，最后一个文件之后还有整体完成应答
+        while (true) {
+            const auto message = co_await read_message(socket);
+            if (message.type() == "transfer.FileInfoResponse") {
+                transfer::FileInfoResponse info;
+                info.ParseFromString(message.payload());
+                if (info.status() != transfer::FileInfoResponse::SUCCESS) {
+                    co_return false;
+                }
+                break;
+            }
+            if (message.type() == "transfer.TransferMetadataResponse") {
+                completed = true;
+                transfer::TransferMetadataResponse response;
+                response.ParseFromString(message.payload());
+                if (response.status() != transfer::TransferMetadataResponse::SUCCESS) {
+                    co_return false;
+                }
+                break;
+            }
+        }
+    }
+    while (!completed) {
+        const auto message = co_await read_message(socket);
+        if (message.type() == "transfer.TransferMetadataResponse") {
+            transfer::TransferMetadataResponse response;
+            response.ParseFromString(message.payload());
+            co_return response.status() == transfer::TransferMetadataResponse::SUCCESS;
+        }
+    }
+    co_return true;
+}
+
+struct BatchOutcome {
+    std::vector<std::uint32_t> failed_files;
+    bool transfer_succeeded = false;
+};
+
+// 打包发送 files 个小文件：清单标记为 packed，内容放在一个批次里，条目按 order 排列（可以重复）
+asio::awaitable<BatchOutcome> send_packed_batch(std::uint16_t port,
+                                                int files,
+                                                std::vector<std::uint32_t> order) {
+    asio::ip::tcp::socket socket(co_await asio::this_coro::executor);
+    co_await socket.async_connect({asio::ip::make_address("127.0.0.1"), port},
+                                  asio::use_awaitable);
+
+    transfer::TransferMetadataRequest metadata;
+    for (int i = 0; i < files; ++i) {
+        const auto content = file_content(0, i);
+        auto* info = metadata.add_files();
+        info->set_relative_path(relative_path(0, i));
+        info->set_size(content.size());
+        info->set_packed(true);
+        const auto digest = util::hash::sha256(util::hash::as_block(content));
+        info->set_hash(std::string(reinterpret_cast<const char*>(digest->data()), digest->size()));
+        metadata.set_total_size(metadata.total_size() + content.size());
+    }
+    co_await write_message(socket, metadata);
+    transfer::TransferMetadataResponse ready;
+    ready.ParseFromString((co_await read_message(socket)).payload());
+    if (ready.status() != transfer::TransferMetadataResponse::READY) {
+        co_return BatchOutcome{};
+    }
+
+    transfer::FileBatchRequest batch;
+    std::string data;
+    for (const auto index : order) {
+        const auto content = file_content(0, static_cast<int>(index));
+        auto* entry = batch.add_entries();
+        entry->set_file_index(index);
+        entry->set_offset(data.size());
+        entry->set_length(content.size());
+        data += content;
+    }
+    batch.set_data(data);
+    co_await write_message(socket, batch);
+
+    BatchOutcome outcome;
+    while (true) {
+        const auto message = co_await read_message(socket);
+        if (message.type() == "transfer.FileBatchResponse") {
+            transfer::FileBatchResponse response;
+            response.ParseFromString(message.payload());
+            outcome.failed_files.assign(response.failed_files().begin(),
+                                        response.failed_files().end());
+        } else if (message.type() == "transfer.TransferMetadataResponse") {
+            transfer::TransferMetadataResponse response;
+            response.ParseFromString(message.payload());
+            outcome.transfer_succeeded =
+                response.status() == transfer::TransferMetadataResponse::SUCCESS;
+            co_return outcome;
+        }
+    }
+}
+
+// 分两页发送打包文件的清单：首页的文件各在一个多层目录里，建目录比只有一个文件的第二页慢，
+// 第二页通常先被确认。随后一个批次发送全部内容，返回整体结果
+asio::awaitable<bool> send_two_page_manifest(std::uint16_t port, int first_page_files) {
+    asio::ip::tcp::socket socket(co_await asio::this_coro::executor);
+    co_await socket.async_connect({asio::ip::make_address("127.0.0.1"), port},
+                                  asio::use_awaitable);
+
+    const int total_files = first_page_files + 1;
+    auto page_path = [&](int i) {
+        return i < first_page_files ? "deep_" + std::to_string(i) + "/a/b/c/file.bin"
+                                    : std::string("last.bin");
+    };
+    for (const int page_index : {0, 1}) {
+        transfer::TransferMetadataRequest page;
+        page.set_verify_policy(transfer::TransferMetadataRequest::VERIFY_NONE);
+        page.set_first_file_index(page_index == 0 ? 0 : first_page_files);
+        page.set_more_pages(page_index == 0);
+        const int begin = page_index == 0 ? 0 : first_page_files;
+        const int end = page_index == 0 ? first_page_files : total_files;
+        for (int i = begin; i < end; ++i) {
+            auto* info = page.add_files();
+            info->set_relative_path(page_path(i));
+            info->set_size(1);
+            info->set_packed(true);
+        }
+        page.set_total_size(static_cast<std::uint64_t>(end));
+        co_await write_message(socket, page);
+    }
+
+    int ready_pages = 0;
+    while (ready_pages < 2) {
+        const auto message = co_await read_message(socket);
+        if (message.type() != "transfer.TransferMetadataResponse") {
+            co_return false;
+        }
+        transfer::TransferMetadataResponse ready;
+        ready.ParseFromString(message.payload());
+        if (ready.status() != transfer::TransferMetadataResponse::READY) {
+            co_return false;
+        }
+        ++ready_pages;
+    }
+
+    transfer::FileBatchRequest batch;
+    for (int i = 0; i < total_files; ++i) {
+        auto* entry = batch.add_entries();
+        entry->set_file_index(static_cast<std::uint32_t>(i));
+        entry->set_offset(static_cast<std::uint64_t>(i));
+        entry->set_length(1);
+    }
+    batch.set_data(std::string(static_cast<std::size_t>(total_files), 'x'));
+    co_await write_message(socket, batch);
+
+    while (true) {
+        const auto message = co_await read_message(socket);
+        if (message.type() == "transfer.TransferMetadataResponse") {
+            transfer::TransferMetadataResponse response;
+            response.ParseFromString(message.payload());
+            co_return response.status() == transfer::TransferMetadataResponse::SUCCESS;
+        }
+    }
+}
+
+bool wait_until(const std::function<bool()>& condition, std::chrono::seconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return true;
+}
+} // namespace
+
+class ReceiverServerTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        save_dir_ = std::filesystem::current_path() / "server_received";
+        std::filesystem::remove_all(save_dir_);
+    }
+
+    void TearDown() override { std::filesystem::remove_all(save_dir_); }
+
+    std::filesystem::path save_dir_;
+};
+
+TEST(ReceiverAdmissionTest, SplitsInflightBytesAcrossSessions) {
+    receiver::Admission admission(2, 1000);
+    ASSERT_TRUE(admission.try_admit());
+    ASSERT_TRUE(admission.try_admit());
+    EXPECT_FALSE(admission.try_admit());
+
+    int releases = 0;
+    admission.set_release_handler([&]() { ++releases; });
+
+    // 两个会话各占一半额度；没有在途分块的会话总能再接收一个
+    admission.take(600);
+    EXPECT_FALSE(admission.can_take(600));
+    EXPECT_TRUE(admission.can_take(0));
+    EXPECT_TRUE(admission.can_take(400));
+
+    admission.give_back(600);
+    EXPECT_EQ(releases, 1);
+    admission.give_back(0);
+    EXPECT_EQ(releases, 1);
+
+    // 只剩一个会话时它可以使用全部额度
+    admission.leave();
+    admission.take(600);
+    EXPECT_TRUE(admission.can_take(600));
+    EXPECT_EQ(admission.sessions(), 1u);
+}
+
+TEST_F(ReceiverServerTest, ServesConcurrentSenders) {
+    constexpr int kSenders = 64;
+    constexpr int kFilesPerSender = 3;
+
+    core::Executor executor;
+    std::thread runner([&]() { executor.start(); });
+
+    receiver::ServerOptions options;
+    options.save_dir = save_dir_.string();
+    // 会话上限小于发送端数量，多出的连接在监听队列中等待；
+    // 在途额度只够几个分块，让会话在全局额度上相互等待
+    options.max_sessions = 16;
+    options.max_inflight_bytes = 32 * 1024;
+    receiver::Server server(executor, options);
+    ASSERT_TRUE(server.start());
+    const auto port = server.port();
+    ASSERT_NE(port, 0);
+
+    std::atomic<int> succeeded{0};
+    std::atomic<int> finished{0};
+    for (int sender = 0; sender < kSenders; ++sender) {
+        asio::co_spawn(executor.next_io_context(),
+                       send_files(port, sender, kFilesPerSender),
+                       [&](std::exception_ptr error, bool ok) {
+                           if (!error && ok) {
+                               succeeded.fetch_add(1);
+                           }
+                           finished.fetch_add(1);
+                       });
+    }
+
+    std::size_t peak_sessions = 0;
+    const bool all_finished = wait_until(
+        [&]() {
+            peak_sessions = std::max(peak_sessions, server.active_sessions());
+            return finished.load() == kSenders;
+        },
+        std::chrono::seconds(60));
+    EXPECT_TRUE(all_finished);
+    EXPECT_EQ(succeeded.load(), kSenders);
+    EXPECT_EQ(server.accepted_sessions(), static_cast<std::size_t>(kSenders));
+    EXPECT_LE(peak_sessions, options.max_sessions);
+
+    // 发送端断开后会话自行结束并释放全部额度
+    EXPECT_TRUE(wait_until([&]() { return server.active_sessions() == 0; },
+                           std::chrono::seconds(10)));
+    EXPECT_EQ(server.admission().inflight_bytes(), 0u);
+
+    server.stop();
+    executor.stop();
+    runner.join();
+
+    for (int sender = 0; sender < kSenders; ++sender) {
+        for (int file = 0; file < kFilesPerSender; ++file) {
+            std::ifstream input(save_dir_ / relative_path(sender, file), std::ios::binary);
+            const std::string actual((std::istreambuf_iterator<char>(input)),
+                                     std::istreambuf_iterator<char>());
+            EXPECT_EQ(actual, file_content(sender, file)) << relative_path(sender, file);
+        }
+    }
+}
+
+// 分片模式下每个分片各自监听同一端口，连接留在接受它的分片上；
+// stop() 后等到 stopped() 即可在执行器仍在运行时销毁 Server
+TEST_F(ReceiverServerTest, ShardedServerListensOnEveryShard) {
+    constexpr int kSenders = 8;
+
+    core::Executor executor(1, 2, core::IoMode::Sharded);
+    std::thread runner([&]() { executor.start(); });
+
+    receiver::ServerOptions options;
+    options.save_dir = save_dir_.string();
+    auto server = std::make_unique<receiver::Server>(executor, options);
+    ASSERT_TRUE(server->start());
+    const auto port = server->port();
+    ASSERT_NE(port, 0);
+
+    std::atomic<int> succeeded{0};
+    std::atomic<int> finished{0};
+    for (int sender = 0; sender < kSenders; ++sender) {
+        asio::co_spawn(executor.next_io_context(),
+                       send_files(port, sender, 1),
+                       [&](std::exception_ptr error, bool ok) {
+                           if (!error && ok) {
+                               succeeded.fetch_add(1);
+                           }
+                           finished.fetch_add(1);
+                       });
+    }
+    EXPECT_TRUE(wait_until([&]() { return finished.load() == kSenders; },
+                           std::chrono::seconds(30)));
+    EXPECT_EQ(succeeded.load(), kSenders);
+    EXPECT_EQ(server->accepted_sessions(), static_cast<std::size_t>(kSenders));
+    EXPECT_TRUE(wait_until([&]() { return server->active_sessions() == 0; },
+                           std::chrono::seconds(10)));
+
+    EXPECT_FALSE(server->stopped());
+    server->stop();
+    EXPECT_TRUE(wait_until([&]() { return server->stopped(); }, std::chrono::seconds(5)));
+    server.reset();
+
+    executor.stop();
+    runner.join();
+}
+
+// 批次中重复的条目判为失败，不会重复写入，也不会让已完成文件数多计
+TEST_F(ReceiverServerTest, RejectsDuplicateBatchEntries) {
+    core::Executor executor;
+    std::thread runner([&]() { executor.start(); });
+
+    receiver::ServerOptions options;
+    options.save_dir = save_dir_.string();
+    receiver::Server server(executor, options);
+    ASSERT_TRUE(server.start());
+
+    std::atomic<bool> finished{false};
+    BatchOutcome outcome;
+    asio::co_spawn(executor.next_io_context(),
+                   send_packed_batch(server.port(), 2, {0, 0, 1}),
+                   [&](std::exception_ptr error, BatchOutcome result) {
+                       if (!error) {
+                           outcome = std::move(result);
+                       }
+                       finished.store(true);
+                   });
+    EXPECT_TRUE(wait_until([&]() { return finished.load(); }, std::chrono::seconds(10)));
+
+    server.stop();
+    executor.stop();
+    runner.join();
+
+    EXPECT_EQ(outcome.failed_files, std::vector<std::uint32_t>{0});
+    EXPECT_TRUE(outcome.transfer_succeeded);
+    for (int file = 0; file < 2; ++file) {
+        std::ifstream input(save_dir_ / relative_path(0, file), std::ios::binary);
+        const std::string actual((std::istreambuf_iterator<char>(input)),
+                                 std::istreambuf_iterator<char>());
+        EXPECT_EQ(actual, file_content(0, file));
+    }
+}
+
+// 最后一页先建完目录、先被确认时，前一页之后完成不会把清单改回不完整，传输照常结束
+TEST_F(ReceiverServerTest, CompletesWhenLastPageIsReadyFirst) {
+    // 多个计算线程，两页的建目录任务才会并行、乱序完成
+    core::Executor executor(4);
+    std::thread runner([&]() { executor.start(); });
+
+    receiver::ServerOptions options;
+    options.save_dir = save_dir_.string();
+    receiver::Server server(executor, options);
+    ASSERT_TRUE(server.start());
+
+    std::atomic<int> result{-1};
+    asio::co_spawn(executor.next_io_context(),
+                   send_two_page_manifest(server.port(), 2000),
+                   [&](std::exception_ptr error, bool ok) { result.store(!error && ok ? 1 : 0); });
+    EXPECT_TRUE(wait_until([&]() { return result.load() >= 0; }, std::chrono::seconds(20)));
+
+    server.stop();
+    executor.stop();
+    runner.join();
+
+    EXPECT_EQ(result.load(), 1);
+    EXPECT_TRUE(std::filesystem::exists(save_dir_ / "last.bin"));
+    EXPECT_TRUE(std::filesystem::exists(save_dir_ / "deep_1999/a/b/c/file.bin"));
+}
@@ -4,6 +4,7 @@
 #include <filesystem>
 #include <fstream>
 #include <gtest/gtest.h>
+#include <optional>
 #include <string>
 
 class SingleFileReceiverTest : public ::testing::Test {
@@ -36,6 +37,19 @@ class SingleFileReceiverTest : public ::testing::Test {
         return chunk;
     }
 
+    // 计算原始 SHA-256 摘要，与协议中 bytes 字段格式一致
+    static std::optional<std::string> Sha256Bytes(ConstDataBlock block) {
+        auto digest = util::hash::sha256(block);
+        if (!digest) {
+            return std::nullopt;
+        }
+        return std::string(reinterpret_cast<const char*>(digest->data()), digest->size());
+    }
+
+    static std::optional<util::hash::Sha256Digest> ToDigest(const std::string& bytes) {
+        return util::hash::to_digest(util::hash::as_block(bytes));
+    }
+
     // 生成内容
     std::string GenerateContent(size_t size) {
         std::string content;
@@ -72,7 +86,7 @@ TEST_F(SingleFileReceiverTest, ReceiveSmallFileInSingleChunk) {
     // 计算内容的哈希
     const std::byte* bytes = reinterpret_cast<const std::byte*>(content.data());
     ConstDataBlock block(bytes, content.size());
-    auto hash = util::hash::sha256_hex(block);
+    auto hash = Sha256Bytes(block);
     ASSERT_TRUE(hash.has_value());
 
     // 创建接收器，传递文件大小
@@ -91,8 +105,8 @@ TEST_F(SingleFileReceiverTest, ReceiveSmallFileInSingleChunk) {
     // 完成并验证
     auto [ok, expected_hash, actual_hash] = receiver.finalize_and_verify();
     EXPECT_TRUE(ok);
-    EXPECT_EQ(expected_hash, *hash);
-    EXPECT_EQ(actual_hash, *hash);
+    EXPECT_EQ(expected_hash, ToDigest(*hash));
+    EXPECT_EQ(actual_hash, ToDigest(*hash));
 
     // 验证文件内容
     ASSERT_TRUE(std::filesystem::exists(file_path));
@@ -117,7 +131,7 @@ TEST_F(SingleFileReceiverTest, ReceiveLargeFileInMultipleChunks) {
     // 计算完整文件的哈希（用于验证）
     const std::byte* bytes = reinterpret_cast<const std::byte*>(full_content.data());
     ConstDataBlock block(bytes, full_content.size());
-    auto file_hash = util::hash::sha256_hex(block);
+    auto file_hash = Sha256Bytes(block);
     ASSERT_TRUE(file_hash.has_value());
 
     // 创建接收器，传递文件大小
@@ -132,7 +146,7 @@ TEST_F(SingleFileReceiverTest, ReceiveLargeFileInMultipleChunks) {
         // 计算块的哈希
         const std::byte* chunk_bytes = reinterpret_cast<const std::byte*>(chunks[i].data());
         ConstDataBlock chunk_block(chunk_bytes, chunks[i].size());
-        auto chunk_hash = util::hash::sha256_hex(chunk_block);
+        auto chunk_hash = Sha256Bytes(chunk_block);
         ASSERT_TRUE(chunk_hash.has_value());
 
         bool is_last = (i == kNumChunks - 1);
@@ -145,8 +159,8 @@ TEST_F(SingleFileReceiverTest, ReceiveLargeFileInMultipleChunks) {
     // 完成并验证
     auto [ok, expected_hash, actual_hash] = receiver.finalize_and_verify();
     EXPECT_TRUE(ok);
-    EXPECT_EQ(expected_hash, *file_hash);
-    EXPECT_EQ(actual_hash, *file_hash);
+    EXPECT_EQ(expected_hash, ToDigest(*file_hash));
+    EXPECT_EQ(actual_hash, ToDigest(*file_hash));
 
     // 验证文件内容
     auto file_path = received_dir_ / relative_path;
@@ -161,7 +175,7 @@ TEST_F(SingleFileReceiverTest, ReceiveFileWithSubdirectory) {
     // 计算内容的哈希
     const std::byte* bytes = reinterpret_cast<const std::byte*>(content.data());
     ConstDataBlock block(bytes, content.size());
-    auto hash = util::hash::sha256_hex(block);
+    auto hash = Sha256Bytes(block);
     ASSERT_TRUE(hash.has_value());
 
     // 创建接收器，传递文件大小
@@ -194,7 +208,7 @@ TEST_F(SingleFileReceiverTest, ReceiveEmptyFile) {
     // 计算空内容的哈希
     const std::byte* bytes = reinterpret_cast<const std::byte*>(content.data());
     ConstDataBlock block(bytes, content.size());
-    auto hash = util::hash::sha256_hex(block);
+    auto hash = Sha256Bytes(block);
     ASSERT_TRUE(hash.has_value());
 
     // 创建接收器，传递文件大小
@@ -213,8 +227,8 @@ TEST_F(SingleFileReceiverTest, ReceiveEmptyFile) {
     // 完成并验证
     auto [ok, expected_hash, actual_hash] = receiver.finalize_and_verify();
     EXPECT_TRUE(ok);
-    EXPECT_EQ(expected_hash, *hash);
-    EXPECT_EQ(actual_hash, *hash);
+    EXPECT_EQ(expected_hash, ToDigest(*hash));
+    EXPECT_EQ(actual_hash, ToDigest(*hash));
 
     // 验证空文件
     ASSERT_TRUE(std::filesystem::exists(file_path));
@@ -239,7 +253,7 @@ TEST_F(SingleFileReceiverTest, ReceiveChunksOutOfOrder) {
     // 计算完整文件的哈希
     const std::byte* bytes = reinterpret_cast<const std::byte*>(full_content.data());
     ConstDataBlock block(bytes, full_content.size());
-    auto file_hash = util::hash::sha256_hex(block);
+    auto file_hash = Sha256Bytes(block);
     ASSERT_TRUE(file_hash.has_value());
 
     // 创建接收器
@@ -256,7 +270,7 @@ TEST_F(SingleFileReceiverTest, ReceiveChunksOutOfOrder) {
         size_t i = receive_order[idx];
         const std::byte* chunk_bytes = reinterpret_cast<const std::byte*>(chunks[i].data());
         ConstDataBlock chunk_block(chunk_bytes, chunks[i].size());
-        auto chunk_hash = util::hash::sha256_hex(chunk_block);
+        auto chunk_hash = Sha256Bytes(chunk_block);
         ASSERT_TRUE(chunk_hash.has_value());
 
         bool is_last = (i == kNumChunks - 1); // 块1是最后一块
@@ -269,8 +283,8 @@ TEST_F(SingleFileReceiverTest, ReceiveChunksOutOfOrder) {
     // 完成并验证
     auto [ok, expected_hash, actual_hash] = receiver.finalize_and_verify();
     EXPECT_TRUE(ok) << "File should be correctly assembled from out-of-order chunks";
-    EXPECT_EQ(expected_hash, *file_hash);
-    EXPECT_EQ(actual_hash, *file_hash);
+    EXPECT_EQ(expected_hash, ToDigest(*file_hash));
+    EXPECT_EQ(actual_hash, ToDigest(*file_hash));
 
     // 验证文件内容
     auto file_path = received_dir_ / relative_path;
@@ -285,7 +299,7 @@ TEST_F(SingleFileReceiverTest, RejectChunkWithWrongHash) {
     // 计算正确的哈希
     const std::byte* bytes = reinterpret_cast<const std::byte*>(content.data());
     ConstDataBlock block(bytes, content.size());
-    auto correct_hash = util::hash::sha256_hex(block);
+    auto correct_hash = Sha256Bytes(block);
     ASSERT_TRUE(correct_hash.has_value());
 
     // 创建接收器，传递文件大小
@@ -293,7 +307,7 @@ TEST_F(SingleFileReceiverTest, RejectChunkWithWrongHash) {
     ASSERT_TRUE(receiver.is_valid());
 
     // 使用错误的哈希创建块
-    std::string wrong_hash = "0000000000000000000000000000000000000000000000000000000000000000";
+    std::string wrong_hash(util::hash::kSha256Size, '\0');
     auto chunk = CreateChunk(relative_path, 0, content, wrong_hash, true);
 
     // 应该拒绝哈希不匹配的块
@@ -336,7 +350,7 @@ TEST_F(SingleFileReceiverTest, VerifyFinalFileHash) {
     // 计算预期的文件哈希
     const std::byte* bytes = reinterpret_cast<const std::byte*>(content.data());
     ConstDataBlock block(bytes, content.size());
-    auto expected_file_hash = util::hash::sha256_hex(block);
+    auto expected_file_hash = Sha256Bytes(block);
     ASSERT_TRUE(expected_file_hash.has_value());
 
     // 创建接收器，传递文件大小
@@ -348,7 +362,7 @@ TEST_F(SingleFileReceiverTest, VerifyFinalFileHash) {
     ASSERT_TRUE(receiver.prepare_storage(file_path));
 
     // 处理块（使用块哈希）
-    auto chunk_hash = util::hash::sha256_hex(block);
+    auto chunk_hash = Sha256Bytes(block);
     auto chunk = CreateChunk(relative_path, 0, content, *chunk_hash, true);
     bool result = receiver.handle_chunk(chunk);
     EXPECT_TRUE(result);
@@ -356,8 +370,8 @@ TEST_F(SingleFileReceiverTest, VerifyFinalFileHash) {
     // 完成并验证文件哈希
     auto [ok, expected_hash, actual_hash] = receiver.finalize_and_verify();
     EXPECT_TRUE(ok) << "File hash should match";
-    EXPECT_EQ(expected_hash, *expected_file_hash);
-    EXPECT_EQ(actual_hash, *expected_file_hash);
+    EXPECT_EQ(expected_hash, ToDigest(*expected_file_hash));
+    EXPECT_EQ(actual_hash, ToDigest(*expected_file_hash));
 }
 
 TEST_F(SingleFileReceiverTest, DetectCorruptedFile) {
@@ -367,7 +381,7 @@ TEST_F(SingleFileReceiverTest, DetectCorruptedFile) {
     // 计算原始内容的哈希
     const std::byte* bytes = reinterpret_cast<const std::byte*>(content.data());
     ConstDataBlock block(bytes, content.size());
-    auto original_hash = util::hash::sha256_hex(block);
+    auto original_hash = Sha256Bytes(block);
     ASSERT_TRUE(original_hash.has_value());
 
     // 创建接收器，使用原始哈希
@@ -378,7 +392,7 @@ TEST_F(SingleFileReceiverTest, DetectCorruptedFile) {
     std::string corrupted_content = "Corrupted content";
     const std::byte* corrupted_bytes = reinterpret_cast<const std::byte*>(corrupted_content.data());
     ConstDataBlock corrupted_block(corrupted_bytes, corrupted_content.size());
-    auto corrupted_chunk_hash = util::hash::sha256_hex(corrupted_block);
+    auto corrupted_chunk_hash = Sha256Bytes(corrupted_block);
 
     auto chunk = CreateChunk(relative_path, 0, corrupted_content, *corrupted_chunk_hash, true);
     bool result = receiver.handle_chunk(chunk);
@@ -387,8 +401,8 @@ TEST_F(SingleFileReceiverTest, DetectCorruptedFile) {
     // 完成时应检测到文件哈希不匹配
     auto [ok, expected_hash, actual_hash] = receiver.finalize_and_verify();
     EXPECT_FALSE(ok) << "Should detect corrupted file";
-    EXPECT_EQ(expected_hash, *original_hash);
-    EXPECT_NE(actual_hash, *original_hash);
+    EXPECT_EQ(expected_hash, ToDigest(*original_hash));
+    EXPECT_NE(actual_hash, ToDigest(*original_hash));
 }
 
 TEST_F(SingleFileReceiverTest, HandleDuplicateChunks) {
@@ -409,7 +423,7 @@ TEST_F(SingleFileReceiverTest, HandleDuplicateChunks) {
     // 计算完整文件的哈希
     const std::byte* bytes = reinterpret_cast<const std::byte*>(full_content.data());
     ConstDataBlock block(bytes, full_content.size());
-    auto file_hash = util::hash::sha256_hex(block);
+    auto file_hash = Sha256Bytes(block);
     ASSERT_TRUE(file_hash.has_value());
 
     // 创建接收器
@@ -423,7 +437,7 @@ TEST_F(SingleFileReceiverTest, HandleDuplicateChunks) {
     for (size_t i = 0; i < kNumChunks; ++i) {
         const std::byte* chunk_bytes = reinterpret_cast<const std::byte*>(chunks[i].data());
         ConstDataBlock chunk_block(chunk_bytes, chunks[i].size());
-        auto chunk_hash = util::hash::sha256_hex(chunk_block);
+        auto chunk_hash = Sha256Bytes(chunk_block);
         ASSERT_TRUE(chunk_hash.has_value());
 
         bool is_last = (i == kNumChunks - 1);
@@ -438,7 +452,7 @@ TEST_F(SingleFileReceiverTest, HandleDuplicateChunks) {
         size_t i = 1;
         const std::byte* chunk_bytes = reinterpret_cast<const std::byte*>(chunks[i].data());
         ConstDataBlock chunk_block(chunk_bytes, chunks[i].size());
-        auto chunk_hash = util::hash::sha256_hex(chunk_block);
+        auto chunk_hash = Sha256Bytes(chunk_block);
         ASSERT_TRUE(chunk_hash.has_value());
 
         auto chunk_request = CreateChunk(relative_path, i, chunks[i], *chunk_hash, false);
@@ -449,11 +463,144 @@ TEST_F(SingleFileReceiverTest, HandleDuplicateChunks) {
     // 完成并验证
     auto [ok, expected_hash, actual_hash] = receiver.finalize_and_verify();
     EXPECT_TRUE(ok) << "File should still be valid despite duplicate chunk";
-    EXPECT_EQ(expected_hash, *file_hash);
-    EXPECT_EQ(actual_hash, *file_hash);
+    EXPECT_EQ(expected_hash, ToDigest(*file_hash));
+    EXPECT_EQ(actual_hash, ToDigest(*file_hash));
 
     // 验证文件内容
     auto file_path = received_dir_ / relative_path;
     ASSERT_TRUE(std::filesystem::exists(file_path));
     EXPECT_TRUE(VerifyFile(file_path, full_content));
 }
+
+TEST_F(SingleFileReceiverTest, VerifyNoneSkipsAllChecks) {
+    std::string relative_path = "verify_none.txt";
+    std::string content = "Content without any verification";
+
+    const std::byte* bytes = reinterpret_cast<const std::byte*>(content.data());
+    ConstDataBlock block(bytes, content.size());
+    auto file_hash = Sha256Bytes(block);
+    ASSERT_TRUE(file_hash.has_value());
+
+    util::VerifyCost cost;
+    receiver::SingleFileReceiver receiver(relative_path,
+                                          *file_hash,
+                                          content.size(),
+                                          transfer::TransferMetadataRequest::VERIFY_NONE,
+                                          &cost);
+    ASSERT_TRUE(receiver.prepare_storage(received_dir_ / relative_path));
+
+    // 错误的分块哈希在 VERIFY_NONE 下不会被检查
+    std::string wrong_hash(util::hash::kSha256Size, '\0');
+    EXPECT_TRUE(receiver.handle_chunk(CreateChunk(relative_path, 0, content, wrong_hash, true)));
+
+    auto [ok, expected_hash, actual_hash] = receiver.finalize_and_verify();
+    EXPECT_TRUE(ok);
+    EXPECT_FALSE(actual_hash.has_value()) << "File should not be re-read for hashing";
+    EXPECT_EQ(cost.bytes_hashed(), 0U);
+    EXPECT_EQ(cost.bytes_read(), 0U);
+}
+
+TEST_F(SingleFileReceiverTest, VerifyFileOnlyDetectsCorruption) {
+    std::string relative_path = "verify_file.txt";
+    std::string content = "Original content";
+    std::string corrupted_content = "Corrupted data!!";
+
+    const std::byte* bytes = reinterpret_cast<const std::byte*>(content.data());
+    auto file_hash = Sha256Bytes(ConstDataBlock(bytes, content.size()));
+    ASSERT_TRUE(file_hash.has_value());
+
+    util::VerifyCost cost;
+    receiver::SingleFileReceiver receiver(relative_path,
+                                          *file_hash,
+                                          content.size(),
+                                          transfer::TransferMetadataRequest::VERIFY_FILE,
+                                          &cost);
+    ASSERT_TRUE(receiver.prepare_storage(received_dir_ / relative_path));
+
+    std::string wrong_hash(util::hash::kSha256Size, '\0');
+    EXPECT_TRUE(
+        receiver.handle_chunk(CreateChunk(relative_path, 0, corrupted_content, wrong_hash, true)));
+    EXPECT_EQ(cost.bytes_hashed(), 0U) << "Chunk hash must not be computed";
+
+    auto [ok, expected_hash, actual_hash] = receiver.finalize_and_verify();
+    EXPECT_FALSE(ok);
+    EXPECT_TRUE(actual_hash.has_value());
+    EXPECT_EQ(cost.bytes_read(), corrupted_content.size());
+}
+
+TEST_F(SingleFileReceiverTest, VerifyBothRecordsCost) {
+    std::string relative_path = "verify_both.txt";
+    std::string content = GenerateContent(4096);
+
+    const std::byte* bytes = reinterpret_cast<const std::byte*>(content.data());
+    auto hash = Sha256Bytes(ConstDataBlock(bytes, content.size()));
+    ASSERT_TRUE(hash.has_value());
+
+    util::VerifyCost cost;
+    receiver::SingleFileReceiver receiver(relative_path,
+                                          *hash,
+                                          content.size(),
+                                          transfer::TransferMetadataRequest::VERIFY_BOTH,
+                                          &cost);
+    ASSERT_TRUE(receiver.prepare_storage(received_dir_ / relative_path));
+    EXPECT_TRUE(receiver.handle_chunk(CreateChunk(relative_path, 0, content, *hash, true)));
+
+    auto [ok, expected_hash, actual_hash] = receiver.finalize_and_verify();
+    EXPECT_TRUE(ok);
+    // 分块摘要与整文件摘要各计算一次，整文件摘要需要重新读取文件
+    EXPECT_EQ(cost.bytes_hashed(), content.size() * 2);
+    EXPECT_EQ(cost.bytes_read(), content.size());
+}
+
+// 目标文件在第一个分块到达时才创建；缓存只能容纳一个文件时交替写入的两个文件
+// 反复被逐出、重新打开，已写入的内容不会被截断
+TEST_F(SingleFileReceiverTest, CreatesFilesLazilyThroughBoundedCache) {
+    receiver::FileHandleCache files(1);
+    const std::string first_content = GenerateContent(2 * kDefaultChunkSize);
+    const std::string second_content(2 * kDefaultChunkSize, 'z');
+
+    receiver::SingleFileReceiver first("first.bin",
+                                       "",
+                                       first_content.size(),
+                                       transfer::TransferMetadataRequest::VERIFY_NONE,
+                                       nullptr,
+                                       &files);
+    receiver::SingleFileReceiver second("second.bin",
+                                        "",
+                                        second_content.size(),
+                                        transfer::TransferMetadataRequest::VERIFY_NONE,
+                                        nullptr,
+                                        &files);
+    ASSERT_TRUE(first.prepare_storage(received_dir_ / "first.bin"));
+    ASSERT_TRUE(second.prepare_storage(received_dir_ / "second.bin"));
+    EXPECT_FALSE(std::filesystem::exists(received_dir_ / "first.bin"));
+    EXPECT_FALSE(std::filesystem::exists(received_dir_ / "second.bin"));
+
+    for (std::uint64_t i = 0; i < 2; ++i) {
+        const bool last = i == 1;
+        const auto offset = i * kDefaultChunkSize;
+        const auto first_chunk = first_content.substr(offset, kDefaultChunkSize);
+        const auto second_chunk = second_content.substr(offset, kDefaultChunkSize);
+        EXPECT_TRUE(first.handle_chunk(CreateChunk("first.bin", i, first_chunk, "", last)));
+        EXPECT_TRUE(second.handle_chunk(CreateChunk("second.bin", i, second_chunk, "", last)));
+        EXPECT_EQ(files.size(), 1u);
+    }
+
+    EXPECT_TRUE(std::get<0>(first.finalize_and_verify()));
+    EXPECT_TRUE(std::get<0>(second.finalize_and_verify()));
+    EXPECT_EQ(files.size(), 0u);
+    EXPECT_TRUE(VerifyFile(received_dir_ / "first.bin", first_content));
+    EXPECT_TRUE(VerifyFile(received_dir_ / "second.bin", second_content));
+}
+
+// 旧版本发送的十六进制摘要长度不符，准备阶段即失败，不能静默跳过校验
+TEST_F(SingleFileReceiverTest, RejectsMalformedExpectedHash) {
+    const std::string content = "Hello, World!";
+    const auto hash = Sha256Bytes(util::hash::as_block(content));
+    ASSERT_TRUE(hash.has_value());
+    const auto hex = util::hash::to_hex(*ToDigest(*hash));
+
+    receiver::SingleFileReceiver receiver("hex.txt", hex, content.size());
+    EXPECT_FALSE(receiver.prepare_storage(received_dir_ / "hex.txt"));
+    EXPECT_FALSE(receiver.is_ready());
+}
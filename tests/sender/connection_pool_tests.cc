@@ -0,0 +1,256 @@
+#include "core/executor.h"
+#include "receiver/server.h"
+#include "sender/connection_pool.h"
+#include <asio/co_spawn.hpp>
+#include <asio/post.hpp>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class ConnectionPoolTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        source_dir_ = std::filesystem::current_path() / "pool_source";
+        received_dir_ = std::filesystem::current_path() / "pool_received";
+        std::filesystem::remove_all(source_dir_);
+        std::filesystem::remove_all(received_dir_);
+        std::filesystem::create_directories(source_dir_);
+        runner_ = std::thread([this]() { executor_.start(); });
+    }
+
+    void TearDown() override {
+        StopExecutor();
+        std::filesystem::remove_all(source_dir_);
+        std::filesystem::remove_all(received_dir_);
+    }
+
+    // 连接池与接收服务要比执行器上的协程活得久，测试结束前先停止执行器
+    void StopExecutor() {
+        if (runner_.joinable()) {
+            executor_.stop();
+            runner_.join();
+        }
+    }
+
+    std::filesystem::path CreateFile(const std::string& name, const std::string& content) {
+        const auto path = source_dir_ / name;
+        std::ofstream output(path, std::ios::binary);
+        output << content;
+        return path;
+    }
+
+    // 在执行器上运行一次经由连接池的传输并等待结果
+    bool Transfer(sender::ConnectionPool& pool,
+                  std::uint16_t port,
+                  std::vector<std::filesystem::path> paths) {
+        std::atomic<int> result{-1};
+        asio::co_spawn(executor_.get_io_context(),
+                       pool.transfer("127.0.0.1", port, std::move(paths)),
+                       [&](std::exception_ptr error, bool success) {
+                           result.store(!error && success ? 1 : 0);
+                       });
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (result.load() < 0 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return result.load() == 1;
+    }
+
+    static std::string ReadFile(const std::filesystem::path& path) {
+        std::ifstream input(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+    }
+
+    core::Executor executor_;
+    std::thread runner_;
+    std::filesystem::path source_dir_;
+    std::filesystem::path received_dir_;
+};
+
+TEST_F(ConnectionPoolTest, SequentialTransfersReuseConnection) {
+    receiver::ServerOptions options;
+    options.save_dir = received_dir_.string();
+    receiver::Server server(executor_, options);
+    ASSERT_TRUE(server.start());
+
+    sender::ConnectionPool pool(executor_);
+    const auto first = CreateFile("first.txt", "first transfer");
+    const auto second = CreateFile("second.txt", "second transfer");
+    const auto third = CreateFile("third.txt", "third transfer");
+
+    EXPECT_TRUE(Transfer(pool, server.port(), {first}));
+    EXPECT_EQ(pool.idle_count(), 1u);
+    EXPECT_TRUE(Transfer(pool, server.port(), {second, third}));
+
+    // 三个文件经由同一个连接，接收端只接受过一次连接
+    EXPECT_EQ(server.accepted_sessions(), 1u);
+    EXPECT_EQ(pool.open_count(), 1u);
+    EXPECT_EQ(ReadFile(received_dir_ / "first.txt"), "first transfer");
+    EXPECT_EQ(ReadFile(received_dir_ / "second.txt"), "second transfer");
+    EXPECT_EQ(ReadFile(received_dir_ / "third.txt"), "third transfer");
+
+    pool.close_all();
+    server.stop();
+    StopExecutor();
+}
+
+// 并发的两个传输共用一个连接，各占一个流
+TEST_F(ConnectionPoolTest, ConcurrentTransfersShareConnection) {
+    receiver::ServerOptions options;
+    options.save_dir = received_dir_.string();
+    receiver::Server server(executor_, options);
+    ASSERT_TRUE(server.start());
+
+    sender::ConnectionPool pool(executor_);
+    const auto bulk = CreateFile("bulk.bin", std::string(8 * 1024 * 1024, 'b'));
+    const auto small = CreateFile("small.txt", "small transfer");
+
+    std::atomic<int> finished{0};
+    std::atomic<int> succeeded{0};
+    auto on_done = [&](std::exception_ptr error, bool success) {
+        succeeded.fetch_add(!error && success ? 1 : 0);
+        finished.fetch_add(1);
+    };
+    asio::co_spawn(executor_.get_io_context(),
+                   pool.transfer("127.0.0.1", server.port(), {bulk}),
+                   on_done);
+    asio::co_spawn(executor_.get_io_context(),
+                   pool.transfer("127.0.0.1", server.port(), {small}, 4),
+                   on_done);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+    while (finished.load() < 2 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    EXPECT_EQ(succeeded.load(), 2);
+    EXPECT_EQ(server.accepted_sessions(), 1u);
+    EXPECT_EQ(ReadFile(received_dir_ / "small.txt"), "small transfer");
+    EXPECT_EQ(std::filesystem::file_size(received_dir_ / "bulk.bin"), 8u * 1024 * 1024);
+
+    pool.close_all();
+    server.stop();
+    StopExecutor();
+}
+
+// 小文件打包成批次发送，超过文件数上限时拆成多个批次，大文件仍按分块发送
+TEST_F(ConnectionPoolTest, PacksSmallFilesIntoBatches) {
+    receiver::ServerOptions options;
+    options.save_dir = received_dir_.string();
+    receiver::Server server(executor_, options);
+    ASSERT_TRUE(server.start());
+
+    const auto tree = source_dir_ / "tree";
+    constexpr int kFiles = 1500;
+    for (int i = 0; i < kFiles; ++i) {
+        const auto dir = tree / ("d" + std::to_string(i % 7));
+        std::filesystem::create_directories(dir);
+        std::ofstream output(dir / ("f" + std::to_string(i) + ".txt"), std::ios::binary);
+        output << "content " << i;
+    }
+    std::ofstream(tree / "large.bin", std::ios::binary) << std::string(256 * 1024, 'l');
+
+    sender::ConnectionPool pool(executor_);
+    EXPECT_TRUE(Transfer(pool, server.port(), {tree}));
+
+    for (const int i : {0, 1, 777, kFiles - 1}) {
+        const auto path = received_dir_ / ("d" + std::to_string(i % 7))
+                          / ("f" + std::to_string(i) + ".txt");
+        EXPECT_EQ(ReadFile(path), "content " + std::to_string(i));
+    }
+    EXPECT_EQ(std::filesystem::file_size(received_dir_ / "large.bin"), 256u * 1024);
+
+    pool.close_all();
+    server.stop();
+    StopExecutor();
+}
+
+// 清单有多页时，前面几页的批次在读取的同时后面的页仍在追加，所有打包文件都完整到达
+TEST_F(ConnectionPoolTest, PacksFilesAcrossManifestPages) {
+    receiver::ServerOptions options;
+    options.save_dir = received_dir_.string();
+    receiver::Server server(executor_, options);
+    ASSERT_TRUE(server.start());
+
+    const auto tree = source_dir_ / "pages";
+    constexpr int kFiles = 4 * static_cast<int>(sender::Session::kManifestPageSize) + 100;
+    std::filesystem::create_directories(tree);
+    for (int i = 0; i < kFiles; ++i) {
+        std::ofstream output(tree / ("f" + std::to_string(i) + ".txt"), std::ios::binary);
+        output << "page content " << i;
+    }
+    std::ofstream(tree / "large.bin", std::ios::binary) << std::string(256 * 1024, 'p');
+
+    sender::ConnectionPool pool(executor_);
+    EXPECT_TRUE(Transfer(pool, server.port(), {tree}));
+
+    int mismatched = 0;
+    for (int i = 0; i < kFiles; ++i) {
+        const auto name = "f" + std::to_string(i) + ".txt";
+        mismatched += ReadFile(received_dir_ / name) != "page content " + std::to_string(i);
+    }
+    EXPECT_EQ(mismatched, 0);
+    EXPECT_EQ(std::filesystem::file_size(received_dir_ / "large.bin"), 256u * 1024);
+
+    pool.close_all();
+    server.stop();
+    StopExecutor();
+}
+
+TEST_F(ConnectionPoolTest, IdleConnectionsExpire) {
+    receiver::ServerOptions options;
+    options.save_dir = received_dir_.string();
+    receiver::Server server(executor_, options);
+    ASSERT_TRUE(server.start());
+
+    sender::ConnectionPool pool(executor_, {.idle_timeout = std::chrono::milliseconds(100)});
+    const auto file = CreateFile("expire.txt", "expire");
+
+    EXPECT_TRUE(Transfer(pool, server.port(), {file}));
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    EXPECT_EQ(pool.idle_count(), 0u);
+    EXPECT_EQ(pool.open_count(), 0u);
+    EXPECT_EQ(server.active_sessions(), 0u);
+
+    // 过期后的传输重新建立连接
+    EXPECT_TRUE(Transfer(pool, server.port(), {file}));
+    EXPECT_EQ(server.accepted_sessions(), 2u);
+
+    pool.close_all();
+    server.stop();
+    StopExecutor();
+}
+
+// 连接池先于借出的会话与定期清理销毁，之后到来的结束回调与清理不再访问连接池
+TEST_F(ConnectionPoolTest, SessionsAndSweeperOutlivePool) {
+    receiver::ServerOptions options;
+    options.save_dir = received_dir_.string();
+    receiver::Server server(executor_, options);
+    ASSERT_TRUE(server.start());
+
+    std::shared_ptr<sender::Session> session;
+    {
+        sender::ConnectionPool pool(executor_, {.idle_timeout = std::chrono::milliseconds(2)});
+        session = pool.acquire("127.0.0.1", server.port());
+        ASSERT_NE(session, nullptr);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    asio::post(session->strand(), [session]() { session->close(); });
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (session->is_running() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_FALSE(session->is_running());
+    // 留出时间让投递的结束回调与清理协程的最后一次唤醒执行
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    session.reset();
+    server.stop();
+    StopExecutor();
+}
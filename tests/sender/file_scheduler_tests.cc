@@ -0,0 +1,66 @@
+#include "sender/file_scheduler.h"
+#include <gtest/gtest.h>
+#include <optional>
+#include <vector>
+
+using sender::FileOrder;
+using sender::FileScheduler;
+
+namespace {
+std::vector<FileScheduler::File> sample_files() {
+    return {
+        {0, 300, "b/large.bin"},
+        {1, 10, "a/tiny.txt"},
+        {2, 200, "c/medium.bin"},
+        {3, 20, "a/small.txt"},
+    };
+}
+
+// 不限活动文件数时的完整发送顺序
+std::vector<std::size_t> drain_order(FileOrder order) {
+    FileScheduler scheduler(sample_files(), {.max_active_files = 16, .order = order});
+    std::vector<std::size_t> result;
+    while (auto index = scheduler.next()) {
+        result.push_back(*index);
+    }
+    return result;
+}
+} // namespace
+
+TEST(FileSchedulerTest, OrdersFilesByPolicy) {
+    EXPECT_EQ(drain_order(FileOrder::SizeAscending), (std::vector<std::size_t>{1, 3, 2, 0}));
+    EXPECT_EQ(drain_order(FileOrder::SizeDescending), (std::vector<std::size_t>{0, 2, 3, 1}));
+    EXPECT_EQ(drain_order(FileOrder::Interleaved), (std::vector<std::size_t>{0, 1, 2, 3}));
+    EXPECT_EQ(drain_order(FileOrder::ByPath), (std::vector<std::size_t>{3, 1, 0, 2}));
+}
+
+TEST(FileSchedulerTest, BoundsActiveFiles) {
+    FileScheduler scheduler(sample_files(), {.max_active_files = 2, .order = FileOrder::ByPath});
+
+    EXPECT_EQ(scheduler.next(), std::optional<std::size_t>(3));
+    EXPECT_EQ(scheduler.next(), std::optional<std::size_t>(1));
+    EXPECT_EQ(scheduler.next(), std::nullopt);
+    EXPECT_EQ(scheduler.active_count(), 2u);
+
+    // 结束一个文件才放出下一个，重复结束不会多放
+    EXPECT_TRUE(scheduler.finish(1));
+    EXPECT_FALSE(scheduler.finish(1));
+    EXPECT_FALSE(scheduler.finish(0));
+    EXPECT_EQ(scheduler.next(), std::optional<std::size_t>(0));
+    EXPECT_EQ(scheduler.next(), std::nullopt);
+    EXPECT_EQ(scheduler.pending_count(), 1u);
+}
+
+// 后续清单页追加的文件排在已有文件之后，顺序策略只作用于新的一批
+TEST(FileSchedulerTest, AppendsLaterPages) {
+    FileScheduler scheduler({{0, 50, "b"}, {1, 5, "a"}},
+                            {.max_active_files = 16, .order = FileOrder::SizeAscending});
+    scheduler.add({{2, 1, "d"}, {3, 100, "c"}, {4, 3, "e"}});
+
+    std::vector<std::size_t> order;
+    while (auto index = scheduler.next()) {
+        order.push_back(*index);
+    }
+    EXPECT_EQ(order, (std::vector<std::size_t>{1, 0, 2, 4, 3}));
+    EXPECT_TRUE(scheduler.finish(3));
+}
@@ -0,0 +1,122 @@
+#include "core/executor.h"
+#include "sender/file_walker.h"
+#include <algorithm>
+#include <asio/co_spawn.hpp>
+#include <asio/use_awaitable.hpp>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/stat.h>
+#endif
+
+class FileWalkerTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        root_ = std::filesystem::current_path() / "walker_source";
+        std::filesystem::remove_all(root_);
+        std::filesystem::create_directories(root_ / "a" / "b");
+        std::filesystem::create_directories(root_ / "empty");
+        CreateFile(root_ / "top.txt", "top");
+        CreateFile(root_ / "a" / "one.txt", "one");
+        CreateFile(root_ / "a" / "b" / "two.txt", "two!");
+        CreateFile(root_ / "a" / "b" / "three.txt", "three");
+        // 指向目录的符号链接不跟随，其中的文件不会重复出现
+        std::error_code ec;
+        std::filesystem::create_directory_symlink(root_ / "a", root_ / "link", ec);
+        single_ = std::filesystem::current_path() / "walker_single.txt";
+        CreateFile(single_, "single");
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(root_);
+        std::filesystem::remove(single_);
+    }
+
+    static void CreateFile(const std::filesystem::path& path, const std::string& content) {
+        std::ofstream output(path, std::ios::binary);
+        output << content;
+    }
+
+    // 在执行器上按每页 max 个取完全部文件，最后再取一次确认返回空页
+    std::vector<std::vector<sender::FileWalker::Entry>>
+    WalkPages(std::vector<std::filesystem::path> roots, std::size_t max) {
+        core::Executor executor(2);
+        std::thread runner([&executor]() { executor.start(); });
+        std::vector<std::vector<sender::FileWalker::Entry>> pages;
+        std::atomic<bool> finished{false};
+        auto walk = [&]() -> asio::awaitable<void> {
+            sender::FileWalker walker(executor, std::move(roots));
+            while (!walker.done()) {
+                pages.push_back(co_await walker.next(max));
+            }
+            pages.push_back(co_await walker.next(max));
+        };
+        asio::co_spawn(executor.get_io_context(), walk(), [&](std::exception_ptr) {
+            finished.store(true);
+        });
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!finished.load() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        executor.stop();
+        runner.join();
+        EXPECT_TRUE(finished.load());
+        return pages;
+    }
+
+    std::filesystem::path root_;
+    std::filesystem::path single_;
+};
+
+// 按页取出的文件合起来与整棵树一致，每页不超过上限
+TEST_F(FileWalkerTest, WalksTreeInPages) {
+    auto pages = WalkPages({single_, root_ / "missing", root_}, 2);
+    ASSERT_FALSE(pages.empty());
+    EXPECT_TRUE(pages.back().empty());
+    pages.pop_back();
+
+    std::set<std::string> relatives;
+    std::uint64_t total_size = 0;
+    for (const auto& page : pages) {
+        EXPECT_LE(page.size(), 2u);
+        for (const auto& entry : page) {
+            relatives.insert(entry.relative.generic_string());
+            total_size += entry.size;
+        }
+    }
+
+    EXPECT_EQ(relatives,
+              (std::set<std::string>{
+                  "walker_single.txt", "top.txt", "a/one.txt", "a/b/two.txt", "a/b/three.txt"}));
+    EXPECT_EQ(total_size, 6u + 3u + 3u + 4u + 5u);
+    EXPECT_GE(pages.size(), 3u);
+}
+
+#if defined(__linux__)
+// 遍历时取得的属性与 stat 一致，发送端据此直接查摘要缓存
+TEST_F(FileWalkerTest, ReportsStatAttributes) {
+    auto pages = WalkPages({root_ / "a"}, 16);
+    std::size_t files = 0;
+    for (const auto& page : pages) {
+        for (const auto& entry : page) {
+            struct stat st {};
+            ASSERT_EQ(::stat(entry.absolute.c_str(), &st), 0);
+            EXPECT_EQ(entry.device, static_cast<std::uint64_t>(st.st_dev));
+            EXPECT_EQ(entry.inode, static_cast<std::uint64_t>(st.st_ino));
+            EXPECT_EQ(entry.size, static_cast<std::uint64_t>(st.st_size));
+            EXPECT_EQ(entry.mtime_ns, st.st_mtim.tv_sec * 1'000'000'000 + st.st_mtim.tv_nsec);
+            EXPECT_EQ(entry.ctime_ns, st.st_ctim.tv_sec * 1'000'000'000 + st.st_ctim.tv_nsec);
+            ++files;
+        }
+    }
+    EXPECT_EQ(files, 3u);
+}
+#endif
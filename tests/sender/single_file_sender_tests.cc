@@ -28,9 +28,12 @@ bool GetLastChunkFlag(const Message& message) {
     return false;
 }
 
-std::string ComputeChunkHashHex(const std::string& data) {
-    auto hash_opt = util::hash::sha256_hex(MakeBlock(data));
-    return hash_opt.value_or(std::string());
+std::string ComputeChunkHash(const std::string& data) {
+    auto hash_opt = util::hash::sha256(MakeBlock(data));
+    if (!hash_opt) {
+        return {};
+    }
+    return std::string(reinterpret_cast<const char*>(hash_opt->data()), hash_opt->size());
 }
 
 } // namespace
@@ -117,14 +120,14 @@ TEST_F(SingleFileSenderTest, SendSmallFile) {
     std::string content = "Hello, World!";
     auto file_path = CreateTestFile("small.txt", content);
 
-    auto hash = util::hash::sha256_file_hex(file_path);
+    auto hash = util::hash::sha256_file(file_path);
     ASSERT_TRUE(hash.has_value());
 
     // 创建 FileInfoRequest
     transfer::FileInfoRequest file_info;
     file_info.set_relative_path(file_path.string());
     file_info.set_size(content.size());
-    file_info.set_hash(*hash);
+    file_info.set_hash(hash->data(), hash->size());
 
     // 创建发送方和接收方 executor
     core::Executor sender_executor;
@@ -181,7 +184,7 @@ TEST_F(SingleFileSenderTest, SendSmallFile) {
     EXPECT_EQ(chunk.file_relative_path(), file_path.string());
     EXPECT_EQ(chunk.chunk_index(), 0);
     EXPECT_EQ(chunk.data(), content);
-    EXPECT_EQ(chunk.hash(), ComputeChunkHashHex(chunk.data()));
+    EXPECT_EQ(chunk.hash(), ComputeChunkHash(chunk.data()));
     EXPECT_TRUE(GetLastChunkFlag(chunk));
 }
 
@@ -190,14 +193,14 @@ TEST_F(SingleFileSenderTest, SendLargeFileInChunks) {
     std::string content = GenerateContent(3 * 1024 * 1024);
     auto file_path = CreateTestFile("large.bin", content);
 
-    auto hash = util::hash::sha256_file_hex(file_path);
+    auto hash = util::hash::sha256_file(file_path);
     ASSERT_TRUE(hash.has_value());
 
     // 创建 FileInfoRequest
     transfer::FileInfoRequest file_info;
     file_info.set_relative_path(file_path.string());
     file_info.set_size(content.size());
-    file_info.set_hash(*hash);
+    file_info.set_hash(hash->data(), hash->size());
 
     // 创建发送方和接收方 executor
     core::Executor sender_executor;
@@ -256,7 +259,7 @@ TEST_F(SingleFileSenderTest, SendLargeFileInChunks) {
         const auto& chunk = test_receiver->received_chunks[i];
         EXPECT_EQ(chunk.file_relative_path(), file_path.string());
         EXPECT_EQ(chunk.chunk_index(), i);
-        EXPECT_EQ(chunk.hash(), ComputeChunkHashHex(chunk.data()));
+        EXPECT_EQ(chunk.hash(), ComputeChunkHash(chunk.data()));
 
         total_data_size += chunk.data().size();
 
@@ -275,14 +278,14 @@ TEST_F(SingleFileSenderTest, UpdateChunkStatus) {
     std::string content = GenerateContent(2 * 1024 * 1024); // 2MB
     auto file_path = CreateTestFile("test.bin", content);
 
-    auto hash = util::hash::sha256_file_hex(file_path);
+    auto hash = util::hash::sha256_file(file_path);
     ASSERT_TRUE(hash.has_value());
 
     // 创建 FileInfoRequest
     transfer::FileInfoRequest file_info;
     file_info.set_relative_path(file_path.string());
     file_info.set_size(content.size());
-    file_info.set_hash(*hash);
+    file_info.set_hash(hash->data(), hash->size());
 
     // 创建发送方和接收方 executor
     core::Executor sender_executor;
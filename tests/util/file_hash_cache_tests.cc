@@ -0,0 +1,204 @@
+#include "util/file_hash_cache.h"
+#include "util/hash.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/stat.h>
+#endif
+
+class FileHashCacheTest : public ::testing::Test {
+  protected:
+    static void SetUpTestSuite() {
+        std::filesystem::remove_all(data_dir());
+        std::filesystem::create_directories(data_dir());
+        for (int i = 0; i < kFileCount; ++i) {
+            const auto size = static_cast<std::size_t>(i) * 1000 + 10;
+            std::ofstream(file_path(i), std::ios::binary) << std::string(size, 'a' + i);
+        }
+        std::ofstream(mutable_path(), std::ios::binary) << "before";
+        // 刚写入的文件处于时间戳精度窗口内，不会被缓存
+        std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    }
+
+    static void TearDownTestSuite() { std::filesystem::remove_all(data_dir()); }
+
+    void SetUp() override {
+        std::filesystem::remove(cache_path());
+        std::filesystem::remove(cache_path().string() + ".lock");
+    }
+
+    static std::filesystem::path data_dir() {
+        return std::filesystem::current_path() / "hash_cache_test";
+    }
+    static std::filesystem::path file_path(int i) {
+        return data_dir() / ("file_" + std::to_string(i) + ".bin");
+    }
+    static std::filesystem::path mutable_path() { return data_dir() / "mutable.bin"; }
+    static std::filesystem::path cache_path() { return data_dir() / "cache.bin"; }
+
+    static constexpr int kFileCount = 5;
+    static constexpr std::size_t kChunkSize = 1024;
+};
+
+TEST_F(FileHashCacheTest, ComputesChunkDigests) {
+    util::FileHashCache cache;
+    ASSERT_TRUE(cache.open(cache_path(), 16, kChunkSize));
+
+    auto digests = cache.get_or_compute(file_path(3));
+    ASSERT_TRUE(digests.has_value());
+    EXPECT_EQ(digests->chunks.size(), 3U); // 3010 字节 / 1024
+
+    auto whole = util::hash::sha256_file(file_path(3));
+    ASSERT_TRUE(whole.has_value());
+    EXPECT_TRUE(util::hash::digest_equal(*whole, digests->file));
+}
+
+TEST_F(FileHashCacheTest, PersistsAcrossInstances) {
+    {
+        util::FileHashCache cache;
+        ASSERT_TRUE(cache.open(cache_path(), 16, kChunkSize));
+        EXPECT_FALSE(cache.lookup(file_path(1)).has_value());
+        ASSERT_TRUE(cache.get_or_compute(file_path(1)).has_value());
+        ASSERT_TRUE(cache.flush());
+    }
+
+    util::FileHashCache reopened;
+    ASSERT_TRUE(reopened.open(cache_path(), 16, kChunkSize));
+    auto cached = reopened.lookup(file_path(1));
+    ASSERT_TRUE(cached.has_value());
+    auto whole = util::hash::sha256_file(file_path(1));
+    ASSERT_TRUE(whole.has_value());
+    EXPECT_TRUE(util::hash::digest_equal(*whole, cached->file));
+}
+
+TEST_F(FileHashCacheTest, ChunkSizeChangeInvalidates) {
+    {
+        util::FileHashCache cache;
+        ASSERT_TRUE(cache.open(cache_path(), 16, kChunkSize));
+        ASSERT_TRUE(cache.get_or_compute(file_path(2)).has_value());
+        ASSERT_TRUE(cache.flush());
+    }
+
+    util::FileHashCache reopened;
+    ASSERT_TRUE(reopened.open(cache_path(), 16, kChunkSize * 2));
+    EXPECT_EQ(reopened.size(), 0U);
+    EXPECT_FALSE(reopened.lookup(file_path(2)).has_value());
+}
+
+TEST_F(FileHashCacheTest, MergesConcurrentWriters) {
+    util::FileHashCache first;
+    util::FileHashCache second;
+    ASSERT_TRUE(first.open(cache_path(), 16, kChunkSize));
+    ASSERT_TRUE(second.open(cache_path(), 16, kChunkSize));
+
+    ASSERT_TRUE(first.get_or_compute(file_path(0)).has_value());
+    ASSERT_TRUE(second.get_or_compute(file_path(4)).has_value());
+    ASSERT_TRUE(first.flush());
+    ASSERT_TRUE(second.flush());
+
+    util::FileHashCache reopened;
+    ASSERT_TRUE(reopened.open(cache_path(), 16, kChunkSize));
+    EXPECT_TRUE(reopened.lookup(file_path(0)).has_value());
+    EXPECT_TRUE(reopened.lookup(file_path(4)).has_value());
+}
+
+TEST_F(FileHashCacheTest, EvictsLeastRecentlyUsed) {
+    {
+        util::FileHashCache cache;
+        ASSERT_TRUE(cache.open(cache_path(), 2, kChunkSize));
+        for (int i = 0; i < kFileCount; ++i) {
+            ASSERT_TRUE(cache.get_or_compute(file_path(i)).has_value());
+        }
+        // 再次访问 file_0，使其成为最近使用的条目
+        ASSERT_TRUE(cache.lookup(file_path(0)).has_value());
+        ASSERT_TRUE(cache.flush());
+    }
+
+    util::FileHashCache reopened;
+    ASSERT_TRUE(reopened.open(cache_path(), 2, kChunkSize));
+    EXPECT_EQ(reopened.size(), 2U);
+    EXPECT_TRUE(reopened.lookup(file_path(0)).has_value());
+    EXPECT_TRUE(reopened.lookup(file_path(4)).has_value());
+    EXPECT_FALSE(reopened.lookup(file_path(1)).has_value());
+}
+
+TEST_F(FileHashCacheTest, ModifiedFileMisses) {
+    util::FileHashCache cache;
+    ASSERT_TRUE(cache.open(cache_path(), 16, kChunkSize));
+
+    ASSERT_TRUE(cache.get_or_compute(mutable_path()).has_value());
+    ASSERT_TRUE(cache.lookup(mutable_path()).has_value());
+
+    std::ofstream(mutable_path(), std::ios::binary | std::ios::app) << "after";
+    EXPECT_FALSE(cache.lookup(mutable_path()).has_value());
+}
+
+#if defined(__linux__)
+// 调用方给出的属性（遍历目录时的 statx）与缓存自己 stat 得到的键一致，按键查询不再 stat
+TEST_F(FileHashCacheTest, LookupByCallerKey) {
+    util::FileHashCache cache;
+    ASSERT_TRUE(cache.open(cache_path(), 16, kChunkSize));
+
+    struct stat st {};
+    ASSERT_EQ(::stat(file_path(1).c_str(), &st), 0);
+    util::FileHashCache::FileKey key{
+        static_cast<std::uint64_t>(st.st_dev),
+        static_cast<std::uint64_t>(st.st_ino),
+        static_cast<std::uint64_t>(st.st_size),
+        static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1'000'000'000 + st.st_mtim.tv_nsec,
+        static_cast<std::int64_t>(st.st_ctim.tv_sec) * 1'000'000'000 + st.st_ctim.tv_nsec};
+    const auto digests = cache.get_or_compute(file_path(1), key);
+    ASSERT_TRUE(digests.has_value());
+    EXPECT_TRUE(cache.lookup(file_path(1)).has_value());
+    EXPECT_TRUE(cache.lookup(key).has_value());
+
+    key.mtime_ns += 1;
+    EXPECT_FALSE(cache.lookup(key).has_value());
+}
+#endif
+
+// 命中的条目没有变化，flush 不再把它们重复追加到日志
+TEST_F(FileHashCacheTest, HitsDoNotGrowLog) {
+    {
+        util::FileHashCache cache;
+        ASSERT_TRUE(cache.open(cache_path(), 16, kChunkSize));
+        ASSERT_TRUE(cache.get_or_compute(file_path(2)).has_value());
+        ASSERT_TRUE(cache.flush());
+    }
+    const auto size = std::filesystem::file_size(cache_path());
+
+    util::FileHashCache reopened;
+    ASSERT_TRUE(reopened.open(cache_path(), 16, kChunkSize));
+    ASSERT_TRUE(reopened.get_or_compute(file_path(2)).has_value());
+    ASSERT_TRUE(reopened.lookup(file_path(2)).has_value());
+    ASSERT_TRUE(reopened.flush());
+    EXPECT_EQ(std::filesystem::file_size(cache_path()), size);
+}
+
+// 写到一半的记录之后不能继续追加，否则后续记录都读不到；flush 改为整体重写
+TEST_F(FileHashCacheTest, RewritesAfterTornRecord) {
+    {
+        util::FileHashCache cache;
+        ASSERT_TRUE(cache.open(cache_path(), 16, kChunkSize));
+        ASSERT_TRUE(cache.get_or_compute(file_path(0)).has_value());
+        ASSERT_TRUE(cache.flush());
+    }
+    std::ofstream(cache_path(), std::ios::binary | std::ios::app) << "HREC torn";
+
+    {
+        util::FileHashCache cache;
+        ASSERT_TRUE(cache.open(cache_path(), 16, kChunkSize));
+        ASSERT_TRUE(cache.get_or_compute(file_path(1)).has_value());
+        ASSERT_TRUE(cache.flush());
+    }
+
+    util::FileHashCache reopened;
+    ASSERT_TRUE(reopened.open(cache_path(), 16, kChunkSize));
+    EXPECT_TRUE(reopened.lookup(file_path(0)).has_value());
+    EXPECT_TRUE(reopened.lookup(file_path(1)).has_value());
+}
@@ -0,0 +1,135 @@
+#include "util/hash.h"
+#include "util/sha256_multi_buffer.h"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> GenerateInputs(const std::vector<std::size_t>& sizes) {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(0, 255);
+    std::vector<std::string> inputs;
+    inputs.reserve(sizes.size());
+    for (const auto size : sizes) {
+        std::string data(size, '\0');
+        for (auto& c : data) {
+            c = static_cast<char>(distribution(generator));
+        }
+        inputs.push_back(std::move(data));
+    }
+    return inputs;
+}
+
+std::vector<ConstDataBlock> ToBlocks(const std::vector<std::string>& inputs) {
+    std::vector<ConstDataBlock> blocks;
+    blocks.reserve(inputs.size());
+    for (const auto& input : inputs) {
+        blocks.push_back(util::hash::as_block(input));
+    }
+    return blocks;
+}
+
+} // namespace
+
+TEST(HashTest, KnownDigest) {
+    const std::string input = "abc";
+    auto digest = util::hash::sha256(util::hash::as_block(input));
+    ASSERT_TRUE(digest.has_value());
+    EXPECT_EQ(util::hash::to_hex(*digest),
+              "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+}
+
+TEST(HashTest, DigestEqualRequiresFullWidth) {
+    const std::string input = "digest";
+    auto digest = util::hash::sha256(util::hash::as_block(input));
+    ASSERT_TRUE(digest.has_value());
+
+    auto copy = *digest;
+    EXPECT_TRUE(util::hash::digest_equal(*digest, copy));
+
+    copy.back() ^= std::byte{0x01};
+    EXPECT_FALSE(util::hash::digest_equal(*digest, copy));
+
+    EXPECT_FALSE(util::hash::digest_equal(*digest, ConstDataBlock(digest->data(), 16)));
+}
+
+// 覆盖填充边界（55/56/63/64 字节）以及数量不是通道数整数倍的情况
+TEST(HashTest, MultiBufferMatchesSingleStream) {
+    std::vector<std::size_t> sizes = {0, 1, 3, 55, 56, 57, 63, 64, 65, 119, 120, 127, 128, 1000};
+    for (std::size_t i = 0; i < 23; ++i) {
+        sizes.push_back(i * 97 + 5);
+    }
+    const auto inputs = GenerateInputs(sizes);
+    const auto blocks = ToBlocks(inputs);
+
+    std::vector<util::hash::Sha256Digest> digests(blocks.size());
+    ASSERT_TRUE(util::hash::detail::sha256_multi_buffer(blocks, digests));
+
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        auto expected = util::hash::sha256(blocks[i]);
+        ASSERT_TRUE(expected.has_value());
+        EXPECT_TRUE(util::hash::digest_equal(*expected, digests[i])) << "size " << sizes[i];
+    }
+}
+
+TEST(HashTest, Sha256ManyMixedSizes) {
+    std::vector<std::size_t> sizes = {10, util::hash::detail::kMultiBufferMaxSize + 1, 0, 4096};
+    for (std::size_t i = 0; i < 40; ++i) {
+        sizes.push_back(200 + i);
+    }
+    const auto inputs = GenerateInputs(sizes);
+    const auto blocks = ToBlocks(inputs);
+
+    auto digests = util::hash::sha256_many(blocks);
+    ASSERT_TRUE(digests.has_value());
+    ASSERT_EQ(digests->size(), blocks.size());
+
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        auto expected = util::hash::sha256(blocks[i]);
+        ASSERT_TRUE(expected.has_value());
+        EXPECT_TRUE(util::hash::digest_equal(*expected, (*digests)[i])) << "index " << i;
+    }
+}
+
+TEST(HashTest, Sha256ManyEmptyBatch) {
+    auto digests = util::hash::sha256_many({});
+    ASSERT_TRUE(digests.has_value());
+    EXPECT_TRUE(digests->empty());
+}
+
+// 大量小文件批量读入后一起计算，结果与逐个文件计算一致，读取失败的文件单独返回空
+TEST(HashTest, Sha256FilesMatchesPerFileDigests) {
+    const auto root = std::filesystem::current_path() / "hash_files_root";
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+
+    std::vector<std::size_t> sizes;
+    for (std::size_t i = 0; i < 300; ++i) {
+        sizes.push_back(i * 37 % 5000);
+    }
+    const auto inputs = GenerateInputs(sizes);
+    std::vector<std::filesystem::path> paths;
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        paths.push_back(root / ("file_" + std::to_string(i)));
+        std::ofstream(paths.back(), std::ios::binary) << inputs[i];
+    }
+    paths.insert(paths.begin() + 7, root / "missing");
+
+    const auto digests = util::hash::sha256_files(paths);
+    ASSERT_EQ(digests.size(), paths.size());
+    EXPECT_FALSE(digests[7].has_value());
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        if (i == 7) {
+            continue;
+        }
+        const auto expected = util::hash::sha256_file(paths[i]);
+        ASSERT_TRUE(expected.has_value());
+        ASSERT_TRUE(digests[i].has_value()) << paths[i];
+        EXPECT_TRUE(util::hash::digest_equal(*expected, *digests[i])) << paths[i];
+    }
+    std::filesystem::remove_all(root);
+}